@@ -0,0 +1,10 @@
+#!/bin/bash
+
+TARGET_BUILD_FOLDER=../build
+
+mkdir $TARGET_BUILD_FOLDER
+mkdir $TARGET_BUILD_FOLDER/pixyrelay
+
+cd $TARGET_BUILD_FOLDER/pixyrelay
+cmake ../../src/host/pixyrelay
+make
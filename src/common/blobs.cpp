@@ -13,6 +13,7 @@
 // end license header
 //
 
+#include <string.h>
 #ifdef PIXY
 #include "pixy_init.h"
 #include "misc.h"
@@ -21,6 +22,9 @@
 #endif
 #include "blobs.h"
 #include "colorlut.h"
+#include "chirp.hpp"
+#include "perf.h"
+#include "fixmath.h"
 
 #define CC_SIGNATURE(s) (m_ccMode==CC_ONLY || m_clut->getType(s)==CL_MODEL_TYPE_COLORCODE)
 
@@ -46,6 +50,19 @@ Blobs::Blobs(Qqueue *qq)
     m_blobReadIndex = 0;
     m_ccBlobReadIndex = 0;
 
+    m_frame = new uint8_t[BL_V2_FRAME_SIZE];
+    m_frameLen = 0;
+    m_frameReadIndex = 0;
+    m_frameCount = 0;
+    m_frameEncoded = 0;
+    m_refBlocks = NULL;
+    m_deltaBlocks = NULL;
+    m_numRefBlocks = 0;
+    m_refFrame = 0;
+    m_refValid = false;
+    m_keyframePeriod = 0;
+    m_deltaFrames = 0;
+
 #ifdef PIXY
     m_clut = new ColorLUT((void *)LUT_MEMORY);
 #else
@@ -72,6 +89,11 @@ int Blobs::setParams(uint16_t maxBlobs, uint16_t maxBlobsPerModel, uint32_t minA
     return 0;
 }
 
+void Blobs::setRunFilter(uint8_t minLength, uint8_t maxGap, uint8_t vertical)
+{
+    m_runFilter.setParams(minLength, maxGap, vertical);
+}
+
 Blobs::~Blobs()
 {
 #ifndef PIXY
@@ -79,6 +101,9 @@ Blobs::~Blobs()
 #endif
     delete m_clut;
     delete [] m_blobs;
+    delete [] m_frame;
+    delete [] m_refBlocks;
+    delete [] m_deltaBlocks;
 }
 
 // Blob format:
@@ -96,10 +121,12 @@ void Blobs::blobify()
     uint16_t *blobsStart;
     uint16_t numBlobsStart, invalid, invalid2;
     uint16_t left, top, right, bottom;
-    //uint32_t timer, timer2=0;
+    PERF_DECLARE(timer);
+    PERF_DECLARE(combined);
 
     unpack();
 
+    PERF_START(timer);
     // copy blobs into memory
     invalid = 0;
     // mutex keeps interrupt routine from stepping on us
@@ -124,7 +151,6 @@ void Blobs::blobify()
             j += 5;
 
         }
-        //setTimer(&timer);
         if (!colorCode) // do not combine color code models
         {
             while(1)
@@ -135,33 +161,40 @@ void Blobs::blobify()
                 invalid += invalid2;
             }
         }
-        //timer2 += getTimer(timer);
     }
-    //setTimer(&timer);
     invalid += combine(m_blobs, m_numBlobs);
+    PERF_LAP(timer, combined);
     if (m_ccMode!=DISABLED)
     {
+        PERF_START(timer);
         m_ccBlobs = (BlobB *)(m_blobs + m_numBlobs*5);
         // calculate number of codedblobs left
         processCC();
+        PERF_STOP(PERF_CC, timer);
     }
+    PERF_START(timer);
     if (invalid || m_ccMode!=DISABLED)
     {
         invalid2 = compress(m_blobs, m_numBlobs);
         m_numBlobs -= invalid2;
     }
-    //timer2 += getTimer(timer);
-    //cprintf("time=%d\n", timer2); // never seen this greater than 200us.  or 1% of frame period
+    PERF_LAP(timer, combined);
+    PERF_ADD(PERF_COMBINE, combined);
+    PERF_COUNT(PERF_BLOBS, m_numBlobs+m_numCCBlobs);
 
     // reset read indexes-- new frame
     m_blobReadIndex = 0;
     m_ccBlobReadIndex = 0;
+    m_frameCount++;
     m_mutex = false;
 
     // free memory
     for (i=0; i<NUM_MODELS; i++)
         m_assembler[i].Reset();
 
+    // done with this frame's slot, the M0 can start another (see qqueue.h)
+    m_qq->releaseFrame();
+
 #if 0
     static int frame = 0;
     if (m_numBlobs>0)
@@ -172,13 +205,41 @@ void Blobs::blobify()
 #endif
 }
 
+void Blobs::addSegment(const SSegment &s, bool *memfull)
+{
+    if (*memfull)
+        PERF_COUNT(PERF_DROPPED, 1);
+    else if (m_assembler[s.model-1].Add(s)<0)
+    {
+        *memfull = true;
+        PERF_COUNT(PERF_HEAP_FULL, 1);
+        PERF_COUNT(PERF_DROPPED, 1);
+        cprintf("heap full %d\n", s.row);
+    }
+    else
+        PERF_COUNT(PERF_SEGMENTS, 1);
+}
+
+// what's made it through the run filter so far
+void Blobs::addFiltered(bool *memfull)
+{
+    SSegment *segs;
+    uint16_t i, len;
+
+    for (i=0, len=m_runFilter.take(&segs); i<len; i++)
+        addSegment(segs[i], memfull);
+}
+
 void Blobs::unpack()
 {
     SSegment s;
     int32_t row;
-    bool memfull;
-    uint32_t i;
+    bool memfull, filter;
+    uint32_t i, left, right;
     Qval qval;
+    PERF_DECLARE(timer);
+    PERF_DECLARE(wait);
+    PERF_DECLARE(waited);
 
     // q val:
     // | 4 bits    | 7 bits      | 9 bits | 9 bits    | 3 bits |
@@ -187,40 +248,85 @@ void Blobs::unpack()
     row = -1;
     memfull = false;
     i = 0;
+    left = 0;
+    right = 0x3ff;
+    filter = m_runFilter.enabled();
+    PERF_START(timer);
 
     while(1)
     {
-        while (m_qq->dequeue(&qval)==0);
-        if (qval==0xffffffff)
+        PERF_START(wait);
+        if (m_qq->dequeue(&qval)==0)
+        {
+            // the M0 hasn't got this far into the frame yet
+            while (m_qq->dequeue(&qval)==0);
+            PERF_LAP(wait, waited);
+        }
+        if (qval==0xffffffff) // end of frame
             break;
         i++;
         if (qval==0)
         {
             row++;
+            if (filter)
+            {
+                m_runFilter.beginRow(row);
+                addFiltered(&memfull);
+            }
             continue;
         }
         s.model = qval&0x07;
-        if (s.model>0 && !memfull)
+        if (s.model==0) // the frame was segmented in a window (see qqueue.h)
+        {
+            if (qval&QQ_WINDOW_ROWS_FLAG)
+            {
+                row = QQ_WINDOW_START(qval) - 1;
+                PERF_COUNT(PERF_WINDOWED, 1);
+            }
+            else
+            {
+                left = QQ_WINDOW_START(qval);
+                right = left + QQ_WINDOW_LEN(qval) - 1;
+            }
+        }
+        else if (memfull)
+            PERF_COUNT(PERF_DROPPED, 1);
+        else
         {
             s.row = row;
             qval >>= 3;
             s.startCol = qval&0x1ff;
             qval >>= 9;
             s.endCol = (qval&0x1ff) + s.startCol;
-            if (m_assembler[s.model-1].Add(s)<0)
-            {
-                memfull = true;
-                cprintf("heap full %d\n", i);
-            }
+            // the M0 segments whole lines, so cut off what's outside the window
+            if (s.startCol<left)
+                s.startCol = left;
+            if (s.endCol>right)
+                s.endCol = right;
+            if (s.startCol>s.endCol)
+                continue;
+            if (filter)
+                m_runFilter.add(s);
+            else
+                addSegment(s, &memfull);
         }
     }
+    if (filter)
+    {
+        m_runFilter.endFrame();
+        addFiltered(&memfull);
+    }
+    PERF_ADD(PERF_GRAB, waited);
+    PERF_STOP(PERF_UNPACK, timer+waited);
     //cprintf("rows %d %d\n", row, i);
     // finish frame
+    PERF_START(timer);
     for (i=0; i<NUM_MODELS; i++)
     {
         m_assembler[i].EndFrame();
         m_assembler[i].SortFinished();
     }
+    PERF_STOP(PERF_ASSEMBLE, timer);
 }
 
 uint16_t Blobs::getCCBlock(uint8_t *buf, uint32_t buflen)
@@ -354,6 +460,295 @@ uint16_t Blobs::getBlock(uint8_t *buf, uint32_t buflen)
     return len*sizeof(uint16_t);
 }
 
+// As many whole blocks as fit in buf, so the serial ISR can go a buffer at a time
+// rather than a block at a time.  The null word getBlock() returns when there's
+// nothing to send only goes out by itself.
+uint16_t Blobs::getBlocks(uint8_t *buf, uint32_t buflen)
+{
+    uint16_t len, total;
+
+    for (total=0; total<buflen; total+=len)
+    {
+        len = getBlock(buf+total, buflen-total);
+        if (len==0)
+            break;
+        if (len==sizeof(uint16_t) && *(uint16_t *)(buf+total)==0)
+        {
+            if (total==0)
+                return len;
+            break;
+        }
+    }
+
+    return total;
+}
+
+// v2 block, little-endian bit fields:
+// | 2 bits | 8 bits | 9 bits | 8 bits   | 9 bits   | 4 bits    |
+// | 0      | height | width  | y center | x center | signature |
+// signature 0 is a color code block, followed by 3 more bytes:
+// | 9 bits        | 15 bits      |
+// | angle (signed)| color code   |
+static uint8_t *packBlock(uint8_t *buf, const BlockV2 &block)
+{
+    uint32_t bits;
+    bool cc = block.m_signature>NUM_MODELS;
+
+    bits = (cc ? 0 : block.m_signature) | (uint32_t)(block.m_x&0x1ff)<<4 | (uint32_t)(block.m_y&0xff)<<13 |
+            (uint32_t)(block.m_width&0x1ff)<<21 | (uint32_t)(block.m_height&0x03)<<30;
+    buf[0] = bits;
+    buf[1] = bits>>8;
+    buf[2] = bits>>16;
+    buf[3] = bits>>24;
+    buf[4] = (block.m_height>>2)&0x3f;
+    if (!cc)
+        return buf + BL_V2_BLOCK_SIZE;
+
+    buf[5] = block.m_signature;
+    buf[6] = ((block.m_signature>>8)&0x7f) | (block.m_angle&0x01)<<7;
+    buf[7] = (block.m_angle>>1)&0xff;
+    return buf + BL_V2_CC_BLOCK_SIZE;
+}
+
+static void setBlock(BlockV2 *block, uint16_t signature, uint16_t left, uint16_t right, uint16_t top, uint16_t bottom, int16_t angle)
+{
+    block->m_signature = signature;
+    block->m_width = right - left;
+    block->m_height = bottom - top;
+    block->m_x = left + block->m_width/2;
+    block->m_y = top + block->m_height/2;
+    block->m_angle = angle;
+}
+
+// Header, crc and padding around the blocks, which are already in place.
+static uint16_t frame(uint8_t *buf, uint16_t marker, uint8_t counter, uint8_t count, uint16_t len)
+{
+    uint16_t crc;
+
+    buf[0] = marker&0xff;
+    buf[1] = marker>>8;
+    buf[2] = counter;
+    buf[3] = count;
+    buf[4] = len;
+    buf[5] = len>>8;
+    crc = Chirp::calcCrc16(buf+2, 4);
+    crc = Chirp::calcCrc16(buf+BL_V2_HEADER_SIZE, len, crc);
+    buf[6] = crc;
+    buf[7] = crc>>8;
+
+    len += BL_V2_HEADER_SIZE;
+    if (len&1)
+        buf[len++] = 0;
+
+    return len;
+}
+
+// the newest frame's blocks, the normal ones, then the color codes
+uint16_t Blobs::numBlocksV2()
+{
+    return m_numBlobs + (m_ccMode!=DISABLED ? m_numCCBlobs : 0);
+}
+
+void Blobs::blockV2(uint16_t index, BlockV2 *block)
+{
+    BlobA *blob;
+    BlobB *ccBlob;
+
+    if (index<m_numBlobs)
+    {
+        blob = (BlobA *)m_blobs + index;
+        setBlock(block, blob->m_model, blob->m_left, blob->m_right, blob->m_top, blob->m_bottom, 0);
+    }
+    else
+    {
+        ccBlob = m_ccBlobs + index - m_numBlobs;
+        setBlock(block, ccBlob->m_model, ccBlob->m_left, ccBlob->m_right, ccBlob->m_top, ccBlob->m_bottom, ccBlob->m_angle);
+    }
+}
+
+// Packs the whole frame for "Data out protocol" 1 (and 2's keyframes):
+// | 2 bytes | 1 byte        | 1 byte | 2 bytes        | 2 bytes | blocks |
+// | 0xaa57  | frame counter | blocks | length, blocks | crc16   |        |
+// all little-endian, the crc (same as Chirp::calcCrc16) covering everything after the
+// marker except itself.  The frame counter skips if frames were dropped.  Padded to
+// an even length, SPI sends words.  Returns the length, at most BL_V2_FRAME_SIZE.
+uint16_t Blobs::encodeFrame(uint8_t *buf, uint32_t buflen)
+{
+    uint8_t *block = buf + BL_V2_HEADER_SIZE;
+    uint8_t *end = buf + buflen;
+    uint16_t i, n;
+    BlockV2 one;
+
+    if (buflen<BL_V2_HEADER_SIZE+1)
+        return 0;
+
+    for (i=0, n=numBlocksV2(); i<n && block+BL_V2_CC_BLOCK_SIZE<end; i++)
+    {
+        blockV2(i, &one);
+        block = packBlock(block, one);
+        // if delta frames are on, this is what the next one refers to
+        if (m_refBlocks)
+            m_refBlocks[i] = one;
+    }
+    m_numRefBlocks = i;
+    m_refFrame = m_frameCount;
+    m_refValid = m_refBlocks!=NULL;
+    m_deltaFrames = 0;
+
+    return frame(buf, BL_BEGIN_MARKER_V2, m_frameCount, i, block - buf - BL_V2_HEADER_SIZE);
+}
+
+static inline bool fits(int16_t d, int16_t bits)
+{
+    return d>=-(1<<(bits-1)) && d<(1<<(bits-1));
+}
+
+// The frame as changes to the last one sent ("Data out protocol" 2), same header as
+// encodeFrame() but marked 0xaa58, then the counter of the frame it's relative to and
+// a 0 byte, then a byte for each block:
+// | 1 bit | 1 bit         | 2 bits | 4 bits                     |
+// | 0     | angle changed | type   | signature, 0 is color code |
+// The block it changes is the last frame's next one with the same signature
+// (nibble), whatever the type.  Type BL_DELTA_KEEP is the same block, BL_DELTA_SMALL
+// is followed by x, y, width and height changes, 4 bits each, low nibble first,
+// BL_DELTA_LARGE by the same, a byte each, and BL_DELTA_NEW by the whole block as
+// encodeFrame() packs it.  A changed angle comes last, a byte.  If the frame
+// wouldn't be smaller than a whole one, or it's time for a keyframe, or there's no
+// last frame, it's sent whole.
+uint16_t Blobs::encodeDeltaFrame(uint8_t *buf, uint32_t buflen)
+{
+    uint8_t *block = buf + BL_V2_HEADER_SIZE + BL_DELTA_REF_SIZE;
+    uint8_t *end = buf + buflen;
+    uint8_t next[16], type, nibble;
+    uint16_t i, j, n, keyLen;
+    int16_t dx, dy, dw, dh, da;
+    BlockV2 *blocks = m_deltaBlocks, *ref;
+
+    if (blocks==NULL || !m_refValid || m_deltaFrames+1>=m_keyframePeriod)
+        return encodeFrame(buf, buflen);
+
+    memset(next, 0, sizeof(next));
+    for (i=0, n=numBlocksV2(), keyLen=0; i<n; i++)
+    {
+        if (block+1+BL_V2_CC_BLOCK_SIZE>=end)
+            return encodeFrame(buf, buflen);
+
+        blockV2(i, blocks+i);
+        nibble = blocks[i].m_signature>NUM_MODELS ? 0 : blocks[i].m_signature;
+        keyLen += nibble ? BL_V2_BLOCK_SIZE : BL_V2_CC_BLOCK_SIZE;
+        for (j=next[nibble], ref=NULL; j<m_numRefBlocks; j++)
+        {
+            if ((m_refBlocks[j].m_signature>NUM_MODELS ? 0 : m_refBlocks[j].m_signature)==nibble)
+            {
+                ref = m_refBlocks + j;
+                break;
+            }
+        }
+        next[nibble] = j+1;
+
+        type = BL_DELTA_NEW;
+        if (ref && ref->m_signature==blocks[i].m_signature)
+        {
+            dx = blocks[i].m_x - ref->m_x;
+            dy = blocks[i].m_y - ref->m_y;
+            dw = blocks[i].m_width - ref->m_width;
+            dh = blocks[i].m_height - ref->m_height;
+            da = blocks[i].m_angle - ref->m_angle;
+            if (!fits(da, 8))
+                type = BL_DELTA_NEW;
+            else if (dx==0 && dy==0 && dw==0 && dh==0)
+                type = BL_DELTA_KEEP;
+            else if (fits(dx, 4) && fits(dy, 4) && fits(dw, 4) && fits(dh, 4))
+                type = BL_DELTA_SMALL;
+            else if (fits(dx, 8) && fits(dy, 8) && fits(dw, 8) && fits(dh, 8))
+                type = BL_DELTA_LARGE;
+        }
+
+        *block = nibble | type<<4;
+        if (type==BL_DELTA_NEW)
+        {
+            block = packBlock(block+1, blocks[i]);
+            continue;
+        }
+        if (da)
+            *block |= BL_DELTA_ANGLE;
+        block++;
+        if (type==BL_DELTA_SMALL)
+        {
+            *block++ = (dx&0x0f) | (dy&0x0f)<<4;
+            *block++ = (dw&0x0f) | (dh&0x0f)<<4;
+        }
+        else if (type==BL_DELTA_LARGE)
+        {
+            *block++ = dx;
+            *block++ = dy;
+            *block++ = dw;
+            *block++ = dh;
+        }
+        if (da)
+            *block++ = da;
+    }
+    if (block - buf - BL_V2_HEADER_SIZE - BL_DELTA_REF_SIZE >= keyLen)
+        return encodeFrame(buf, buflen);
+
+    buf[BL_V2_HEADER_SIZE] = m_refFrame;
+    buf[BL_V2_HEADER_SIZE+1] = 0;
+    // this frame is what the next one refers to
+    m_deltaBlocks = m_refBlocks;
+    m_refBlocks = blocks;
+    m_numRefBlocks = n;
+    m_refFrame = m_frameCount;
+    m_deltaFrames++;
+
+    return frame(buf, BL_BEGIN_MARKER_DELTA, m_frameCount, n, block - buf - BL_V2_HEADER_SIZE);
+}
+
+// 0 turns delta frames off, otherwise every period'th frame is sent whole
+int Blobs::setKeyframePeriod(uint8_t period)
+{
+    if (period && m_refBlocks==NULL)
+    {
+        m_refBlocks = new BlockV2[MAX_BLOBS];
+        m_deltaBlocks = new BlockV2[MAX_BLOBS];
+    }
+    m_refValid = false;
+    m_keyframePeriod = period;
+
+    return 0;
+}
+
+uint16_t Blobs::getBlockV2(uint8_t *buf, uint32_t buflen)
+{
+    uint16_t len;
+
+    if (buflen<2)
+        return 0;
+
+    if (m_frameReadIndex>=m_frameLen)
+    {
+        if (m_mutex || m_frameEncoded==m_frameCount) // nothing new, send a null word like getBlock()
+        {
+            buf[0] = 0;
+            buf[1] = 0;
+            return 2;
+        }
+        // the last frame has gone out whole, so now the newest one
+        if (m_keyframePeriod)
+            m_frameLen = encodeDeltaFrame(m_frame, BL_V2_FRAME_SIZE);
+        else
+            m_frameLen = encodeFrame(m_frame, BL_V2_FRAME_SIZE);
+        m_frameReadIndex = 0;
+        m_frameEncoded = m_frameCount;
+    }
+
+    len = m_frameLen - m_frameReadIndex;
+    if (len>buflen)
+        len = buflen&~1;
+    memcpy(buf, m_frame+m_frameReadIndex, len);
+    m_frameReadIndex += len;
+
+    return len;
+}
 
 BlobA *Blobs::getMaxBlob(uint16_t signature)
 {
@@ -633,16 +1028,22 @@ int16_t Blobs::distance(BlobA *blob0, BlobA *blob1, bool horiz)
 int16_t Blobs::angle(BlobA *blob0, BlobA *blob1)
 {
     int acx, acy, bcx, bcy;
+#ifndef FIXED_MATH
     float res;
+#endif
 
     acx = (blob0->m_right + blob0->m_left)/2;
     acy = (blob0->m_bottom + blob0->m_top)/2;
     bcx = (blob1->m_right + blob1->m_left)/2;
     bcy = (blob1->m_bottom + blob1->m_top)/2;
 
+#ifdef FIXED_MATH
+    return fm_atan2Deg(acy-bcy, bcx-acx);
+#else
     res = atan2((float)(acy-bcy), (float)(bcx-acx))*180/3.1415f;
 
     return (int16_t)res;
+#endif
 }
 
 void Blobs::sort(BlobA *blobs[], uint16_t len, BlobA *firstBlob, bool horiz)
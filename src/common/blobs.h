@@ -20,6 +20,7 @@
 #include "colorlut.h"
 #include "pixytypes.h"
 #include "qqueue.h"
+#include "runfilter.h"
 
 #define NUM_MODELS            7
 #define MAX_BLOBS             100
@@ -34,6 +35,21 @@
 
 #define BL_BEGIN_MARKER	      0xaa55
 #define BL_BEGIN_MARKER_CC    0xaa56
+#define BL_BEGIN_MARKER_V2    0xaa57
+#define BL_BEGIN_MARKER_DELTA 0xaa58
+
+// "Data out protocol" 1 sends a frame at a time, see Blobs::encodeFrame(), and 2
+// sends most frames as changes to the one before, see Blobs::encodeDeltaFrame()
+#define BL_V2_HEADER_SIZE     8
+#define BL_V2_BLOCK_SIZE      5
+#define BL_V2_CC_BLOCK_SIZE   8
+#define BL_DELTA_REF_SIZE     2
+#define BL_DELTA_KEEP         0
+#define BL_DELTA_SMALL        1 // 4-bit changes to x, y, width, height
+#define BL_DELTA_LARGE        2 // 8-bit changes
+#define BL_DELTA_NEW          3 // the whole block
+#define BL_DELTA_ANGLE        0x40 // color code angle changed, 8-bit change follows
+#define BL_V2_FRAME_SIZE      (BL_V2_HEADER_SIZE + BL_DELTA_REF_SIZE + MAX_BLOBS*(1+BL_V2_CC_BLOCK_SIZE) + 1)
 
 enum ColorCodeMode
 {
@@ -43,6 +59,17 @@ enum ColorCodeMode
     MIXED = 3 // experimental
 };
 
+// a block as a v2 frame sends it
+struct BlockV2
+{
+    uint16_t m_signature; // color code if it's a color code block
+    uint16_t m_x;
+    uint16_t m_y;
+    uint16_t m_width;
+    uint16_t m_height;
+    int16_t m_angle;
+};
+
 class Blobs
 {
 public:
@@ -51,9 +78,16 @@ public:
     void blobify();
     uint16_t getBlock(uint8_t *buf, uint32_t buflen);
     uint16_t getCCBlock(uint8_t *buf, uint32_t buflen);
+    uint16_t getBlocks(uint8_t *buf, uint32_t buflen);
+    uint16_t getBlockV2(uint8_t *buf, uint32_t buflen);
+    uint16_t encodeFrame(uint8_t *buf, uint32_t buflen);
+    uint16_t encodeDeltaFrame(uint8_t *buf, uint32_t buflen);
+    int setKeyframePeriod(uint8_t period);
     BlobA *getMaxBlob(uint16_t signature=0);
     void getBlobs(BlobA **blobs, uint32_t *len, BlobB **ccBlobs, uint32_t *ccLen);
     int setParams(uint16_t maxBlobs, uint16_t maxBlobsPerModel, uint32_t minArea, ColorCodeMode ccMode);
+    // see runfilter.h, all 0 for none
+    void setRunFilter(uint8_t minLength, uint8_t maxGap, uint8_t vertical);
 
     int generateLUT(uint8_t model, const Frame8 &frame, const RectA &region, ColorModel *pcmodel=NULL);
     int generateLUT(uint8_t model, const Frame8 &frame, const Point16 &seed, ColorModel *pcmodel=NULL, RectA *region=NULL);
@@ -65,6 +99,10 @@ public:
 
 private:
     void unpack();
+    void addSegment(const SSegment &s, bool *memfull);
+    void addFiltered(bool *memfull);
+    uint16_t numBlocksV2();
+    void blockV2(uint16_t index, BlockV2 *block);
     uint16_t combine(uint16_t *blobs, uint16_t numBlobs);
     uint16_t combine2(uint16_t *blobs, uint16_t numBlobs);
     uint16_t compress(uint16_t *blobs, uint16_t numBlobs);
@@ -83,6 +121,7 @@ private:
     void printBlobs();
 
     CBlobAssembler m_assembler[NUM_MODELS];
+    RunFilter m_runFilter;
     Qqueue *m_qq;
 
     uint16_t *m_blobs;
@@ -98,6 +137,22 @@ private:
     uint16_t m_blobReadIndex;
     uint16_t m_ccBlobReadIndex;
 
+    // v2 frame going out, encoded from the newest frame once the last one has gone
+    uint8_t *m_frame;
+    uint16_t m_frameLen;
+    uint16_t m_frameReadIndex;
+    uint16_t m_frameCount;
+    uint16_t m_frameEncoded;
+
+    // what the last v2 frame sent, for delta frames, and every how many frames a whole one
+    BlockV2 *m_refBlocks;
+    BlockV2 *m_deltaBlocks;
+    uint16_t m_numRefBlocks;
+    uint8_t m_refFrame;
+    bool m_refValid;
+    uint8_t m_keyframePeriod;
+    uint8_t m_deltaFrames;
+
     uint32_t m_minArea;
     uint16_t m_mergeDist;
     uint16_t m_maxCodedDist;
@@ -49,9 +49,38 @@ Chirp::Chirp(bool hinterested, bool client, Link *link)
     m_hinterested = hinterested;
     m_client = client;
 
+    m_remoteProcTable = NULL;
+    m_remoteProcTableLen = 0;
+
+    m_tagged = false;
+    m_crc16 = false;
+    m_crc16Agreed = false;
+    m_firstLen = CRP_MAX_HEADER_LEN;
+    m_firstLenNext = CRP_MAX_HEADER_LEN;
+    m_sendTag = 0;
+    m_recvTag = 0;
+    m_lastTag = 0;
+    m_asyncTag = 0;
+    m_nextTag = 0;
+    m_pending = NULL;
+    m_response = NULL;
+    m_batch = NULL;
+    m_batchLen = 0;
+    m_batchSize = 0;
+    m_batchResponse = NULL;
+    m_batchResponseLen = 0;
+    m_recvBuf = NULL;
+    m_pool = NULL;
+    m_held = NULL;
+    m_poolLen = 0;
+
     m_procTableSize = CRP_PROCTABLE_LEN;
+    m_procTableLen = 0;
     m_procTable = new (std::nothrow) ProcTableEntry[m_procTableSize];
     memset(m_procTable, 0, sizeof(ProcTableEntry)*m_procTableSize);
+    m_procIndexSize = 2*CRP_PROCTABLE_LEN;
+    m_procIndex = new (std::nothrow) uint16_t[m_procIndexSize];
+    memset(m_procIndex, 0, sizeof(uint16_t)*m_procIndexSize);
 
     if (link)
         setLink(link);
@@ -62,12 +91,16 @@ Chirp::~Chirp()
     // if we're a client, disconnect (let server know)
     if (m_client)
         remoteInit(false);
-    if (!m_sharedMem)
-    {
-        restoreBuffer();
-        delete[] m_buf;
-    }
+    restoreBuffer();
+    freeBuffers();
     delete[] m_procTable;
+    delete[] m_procIndex;
+    delete[] m_remoteProcTable;
+    while (m_pending)
+        freePending(m_pending);
+    delete[] m_response;
+    delete[] m_batch;
+    delete[] m_batchResponse;
 }
 
 int Chirp::init(bool connect)
@@ -78,6 +111,14 @@ int Chirp::init(bool connect)
 int Chirp::setLink(Link *link)
 {
     m_link = link;
+    // new link, new remote-- forget its procedure table
+    delete[] m_remoteProcTable;
+    m_remoteProcTable = NULL;
+    m_remoteProcTableLen = 0;
+    m_tagged = false;
+    m_crc16 = false;
+    m_crc16Agreed = false;
+    m_firstLen = CRP_MAX_HEADER_LEN;
     m_errorCorrected = m_link->getFlags()&LINK_FLAG_ERROR_CORRECTED;
     m_sharedMem = m_link->getFlags()&LINK_FLAG_SHARED_MEM;
     m_blkSize = m_link->blockSize();
@@ -87,6 +128,7 @@ int Chirp::setLink(Link *link)
     else
         m_headerLen = 8;  // type (uint8_t), (pad), proc (uint16_t), len (uint32_t)
 
+    freeBuffers();
     if (m_sharedMem)
     {
         m_buf = (uint8_t *)m_link->getFlags(LINK_FLAG_INDEX_SHARED_MEMORY_LOCATION);
@@ -94,8 +136,10 @@ int Chirp::setLink(Link *link)
     }
     else
     {
-        m_bufSize = CRP_BUFSIZE;
-        m_buf = new (std::nothrow) uint8_t[m_bufSize];
+        if ((m_recvBuf=getBuffer(CRP_BUFSIZE))==NULL)
+            return CRP_RES_ERROR_MEMORY;
+        m_buf = m_recvBuf->m_data;
+        m_bufSize = m_recvBuf->m_size;
     }
 
     // link is set up, need to call init
@@ -135,6 +179,8 @@ int Chirp::vassemble(va_list *args)
 {
     int len;
 
+    if ((len=ownBuffer())<0)
+        return len;
     len = vserialize(this, m_buf, m_bufSize, args);
     // check for error
     if (len<0)
@@ -151,6 +197,11 @@ bool Chirp::connected()
     return m_connected;
 }
 
+bool Chirp::crc16()
+{
+    return m_crc16;
+}
+
 int Chirp::useBuffer(uint8_t *buf, uint32_t len)
 {
     int res;
@@ -403,14 +454,17 @@ int Chirp::loadArgs(va_list *args, void *recvArgs[])
 int Chirp::call(uint8_t service, ChirpProc proc, va_list args)
 {
     int res, i;
-    uint8_t type;
+    void *recvArgs[CRP_MAX_ARGS+1];
     va_list arguments;
 
     va_copy(arguments, args);
 
     // if it's just a regular call (not init or enumerate), we need to be connected
     if (!(service&CRP_CALL) && !m_connected)
+    {
+        va_end(arguments);
         return CRP_RES_ERROR_NOT_CONNECTED;
+    }
 
     // parse arguments and assemble in m_buf
     m_len = 0;
@@ -422,6 +476,75 @@ int Chirp::call(uint8_t service, ChirpProc proc, va_list args)
         return res;
     }
 
+    res = sendArgs(service, proc, m_len, recvArgs);
+    // intrinsic calls (CRP_CALL bit) are always synchronous
+    if (res<0 || (!(service&CRP_CALL) && (service&(ASYNC|PIPELINED))))
+    {
+        va_end(arguments);
+        return res;
+    }
+
+    // deal with arguments
+    if (!(service&CRP_CALL) && (service&RETURN_ARRAY)) // copy array of arguments
+    {
+        void **recvArray;
+        while(1)
+        {
+            recvArray = va_arg(arguments, void **);
+            if (recvArray!=NULL)
+                break;
+        }
+        for (i=0; recvArgs[i]; i++)
+            recvArray[i] = recvArgs[i];
+        recvArray[i] = NULL;
+    }
+    else if ((res=loadArgs(&arguments, recvArgs))<0)
+    {
+        va_end(arguments);
+        return res;
+    }
+
+    va_end(arguments);
+    return CRP_RES_OK;
+}
+
+uint8_t *Chirp::argBuffer(uint32_t len)
+{
+    restoreBuffer();
+    if (ownBuffer()<0)
+        return NULL;
+    if (m_headerLen+len+CRP_BUFPAD>m_bufSize && realloc(m_headerLen+len+CRP_BUFPAD)<0)
+        return NULL;
+    return m_buf+m_headerLen;
+}
+
+// m_buf holds len bytes of arguments, send them and if the call is synchronous, wait for
+// the response and point recvArgs at its values
+uint8_t *Chirp::returnBuffer(uint32_t len)
+{
+    if (ownBuffer()<0)
+        return NULL;
+    // the args follow the responseInt, same as CRP_RETURN puts them
+    if (m_headerLen+4+len+CRP_BUFPAD>m_bufSize && realloc(m_headerLen+4+len+CRP_BUFPAD)<0)
+        return NULL;
+    return m_buf+m_headerLen+4;
+}
+
+void Chirp::returnArgs(uint32_t len)
+{
+    m_len = len+4;
+}
+
+int Chirp::sendArgs(uint8_t service, ChirpProc proc, uint32_t len, void *recvArgs[])
+{
+    int res;
+    uint8_t type, tag;
+    ChirpPending *pending = NULL;
+
+    if (!(service&CRP_CALL) && !m_connected)
+        return CRP_RES_ERROR_NOT_CONNECTED;
+    m_len = len;
+
     if (service&CRP_CALL) // special case for enumerate and init (internal calls)
     {
         type = service;
@@ -430,62 +553,72 @@ int Chirp::call(uint8_t service, ChirpProc proc, va_list args)
     else
         type = CRP_CALL;
 
+    // tag the call so we can tell its response from the responses of other calls in flight
+    if ((tag=nextTag())==0)
+        return CRP_RES_ERROR; // every tag is waiting for getResponse()
+    if (service&PIPELINED)
+    {
+        pending = new (std::nothrow) ChirpPending;
+        if (pending==NULL)
+            return CRP_RES_ERROR_MEMORY;
+        pending->tag = tag;
+        pending->buf = NULL;
+        pending->len = 0;
+        pending->next = m_pending;
+        m_pending = pending;
+    }
+    m_lastTag = tag;
+    m_asyncTag = service&ASYNC ? tag : 0;
+
     // send call data
-    if ((res=sendChirpRetry(type, proc))!=CRP_RES_OK) // convert call into response
+    m_sendTag = m_tagged ? tag : 0;
+    res = sendChirpRetry(type, proc);
+    m_sendTag = 0;
+    if (res!=CRP_RES_OK)
     {
-        va_end(arguments);
+        if (pending)
+            freePending(pending);
         return res;
     }
 
+    // if the remote tags its responses, a pipelined call is done for now.  Otherwise we can
+    // only have one call in flight, so we wait for the response and hold it for getResponse().
+    if ((pending && m_tagged) || (service&ASYNC))
+        return CRP_RES_OK;
+
+    // receive response while servicing other calls
+    ChirpProc recvProc;
+    m_link->setTimer(); // set timer, so we can check to see if we're taking too much time
 
-    // if the service is synchronous, receive response while servicing other calls
-    if (!(service&ASYNC))
+    while(1)
     {
-        ChirpProc recvProc;
-        void *recvArgs[CRP_MAX_ARGS+1];
-        m_link->setTimer(); // set timer, so we can check to see if we're taking too much time
-
-        while(1)
+        if ((res=recvChirp(&type, &recvProc, recvArgs, true))==CRP_RES_OK)
         {
-            if ((res=recvChirp(&type, &recvProc, recvArgs, true))==CRP_RES_OK)
-            {
-                if (type&CRP_RESPONSE)
-                    break;
-                else // handle calls as they come in
-                    handleChirp(type, recvProc, recvArgs);
-            }
-            else
-            {
-                va_end(arguments);
-                return res;
-            }
-            if (m_link->getTimer()>m_headerTimeout) // we could receive XDATA (for example) and never exit this while loop
-                return CRP_RES_ERROR_RECV_TIMEOUT;
+            if (!(type&CRP_RESPONSE)) // handle calls as they come in
+                handleChirp(type, recvProc, recvArgs);
+            else if (!m_tagged || m_recvTag==tag)
+                break;
+            // else it's a stale response (to a call that timed out, say), drop it
         }
-
-        // deal with arguments
-        if (service&RETURN_ARRAY) // copy array of arguments
+        else if (res==CRP_RES_STORED)
         {
-            void **recvArray;
-            while(1)
-            {
-                recvArray = va_arg(arguments, void **);
-                if (recvArray!=NULL)
-                    break;
-            }
-            for (i=0; recvArgs[i]; i++)
-                recvArray[i] = recvArgs[i];
-            recvArray[i] = NULL;
+            if (pending)
+                break;
         }
-        else if ((res=loadArgs(&arguments, recvArgs))<0)
+        else
         {
-            va_end(arguments);
+            if (pending)
+                freePending(pending);
             return res;
         }
+        if (m_link->getTimer()>m_headerTimeout) // we could receive XDATA (for example) and never exit this while loop
+        {
+            if (pending)
+                freePending(pending);
+            return CRP_RES_ERROR_RECV_TIMEOUT;
+        }
     }
 
-
-    va_end(arguments);
     return CRP_RES_OK;
 }
 
@@ -502,6 +635,278 @@ int Chirp::call(uint8_t service, ChirpProc proc, ...)
   return result;
 }
 
+uint8_t Chirp::lastTag()
+{
+    return m_lastTag;
+}
+
+int Chirp::getResponse(uint8_t tag, va_list args)
+{
+    int res;
+    uint8_t type;
+    ChirpProc recvProc;
+    void *recvArgs[CRP_MAX_ARGS+1];
+    ChirpPending *pending;
+    va_list arguments;
+
+    if ((pending=findPending(tag))==NULL)
+    {
+        // an ASYNC call's response isn't waited for, but it can still be picked up if
+        // it's the last call-- recvChirp() stores it like a pipelined one
+        if (tag==0 || tag!=m_asyncTag)
+            return CRP_RES_ERROR;
+        pending = new (std::nothrow) ChirpPending;
+        if (pending==NULL)
+            return CRP_RES_ERROR_MEMORY;
+        pending->tag = tag;
+        pending->buf = NULL;
+        pending->len = 0;
+        pending->next = m_pending;
+        m_pending = pending;
+    }
+    m_asyncTag = 0;
+
+    // receive until the response shows up, handling calls and XDATA as they come in
+    m_link->setTimer();
+    while (pending->buf==NULL)
+    {
+        res = recvChirp(&type, &recvProc, recvArgs, true);
+        if (res==CRP_RES_OK)
+        {
+            if (!(type&CRP_RESPONSE))
+                handleChirp(type, recvProc, recvArgs);
+        }
+        else if (res!=CRP_RES_STORED)
+        {
+            freePending(pending);
+            return res;
+        }
+        if (pending->buf==NULL && m_link->getTimer()>m_headerTimeout)
+        {
+            freePending(pending);
+            return CRP_RES_ERROR_RECV_TIMEOUT;
+        }
+    }
+
+    // keep the response around until the next one, since the caller's arrays point into it
+    delete[] m_response;
+    m_response = pending->buf;
+    pending->buf = NULL;
+    res = deserializeParse(m_response, pending->len, recvArgs);
+    freePending(pending);
+    if (res<0)
+        return res;
+
+    va_copy(arguments, args);
+    res = loadArgs(&arguments, recvArgs);
+    va_end(arguments);
+
+    return res;
+}
+
+int Chirp::getResponse(uint8_t tag, ...)
+{
+    int result;
+    va_list arguments;
+
+    va_start(arguments, tag);
+    result = getResponse(tag, arguments);
+    va_end(arguments);
+
+    return result;
+}
+
+int Chirp::batchBegin()
+{
+    m_batchLen = 0;
+    return CRP_RES_OK;
+}
+
+int Chirp::batchAdd(ChirpProc proc, va_list *args)
+{
+    int res;
+    uint8_t *batch;
+    uint32_t size;
+
+    if (proc<0)
+        return CRP_RES_ERROR;
+    // serialize in m_buf the way call() does, then move it to the end of the batch
+    m_len = 0;
+    restoreBuffer();
+    if ((res=vassemble(args))<0)
+        return res;
+    size = m_batchLen+8+m_len+3;
+    if (size>m_batchSize)
+    {
+        if ((batch=new (std::nothrow) uint8_t[2*size])==NULL)
+            return CRP_RES_ERROR_MEMORY;
+        memcpy(batch, m_batch, m_batchLen);
+        delete[] m_batch;
+        m_batch = batch;
+        m_batchSize = 2*size;
+    }
+    *(ChirpProc *)(m_batch+m_batchLen) = proc;
+    *(uint16_t *)(m_batch+m_batchLen+2) = 0;
+    *(uint32_t *)(m_batch+m_batchLen+4) = m_len;
+    memcpy(m_batch+m_batchLen+8, m_buf+m_headerLen, m_len);
+    m_batchLen += 8+m_len;
+    while (m_batchLen&3)
+        m_batch[m_batchLen++] = 0;
+
+    return CRP_RES_OK;
+}
+
+int Chirp::batchAdd(ChirpProc proc, ...)
+{
+    int res;
+    va_list args;
+
+    va_start(args, proc);
+    res = batchAdd(proc, &args);
+    va_end(args);
+
+    return res;
+}
+
+int Chirp::batchCall()
+{
+    int res;
+    int32_t responseInt;
+    uint32_t len;
+    uint8_t *data;
+
+    if (!m_connected)
+        return CRP_RES_ERROR_NOT_CONNECTED;
+    if (m_batchLen==0)
+        return 0;
+    res = call(CRP_CALL_BATCH, 0, UINTS8(m_batchLen, m_batch), END_OUT_ARGS,
+               &responseInt, &len, &data, END_IN_ARGS);
+    m_batchLen = 0;
+    if (res<0)
+        return res;
+    if (responseInt<0)
+        return responseInt;
+
+    // the responses are in m_buf, which the next chirp will write over
+    if (len>m_batchResponseLen)
+    {
+        delete[] m_batchResponse;
+        if ((m_batchResponse=new (std::nothrow) uint8_t[len])==NULL)
+        {
+            m_batchResponseLen = 0;
+            return CRP_RES_ERROR_MEMORY;
+        }
+        m_batchResponseLen = len;
+    }
+    memcpy(m_batchResponse, data, len);
+
+    return responseInt;
+}
+
+int Chirp::batchArgs(uint32_t i, void *args[])
+{
+    int res;
+    uint32_t len, offset;
+
+    for (offset=0; offset+4<=m_batchResponseLen; i--)
+    {
+        len = *(uint32_t *)(m_batchResponse+offset);
+        if (len>m_batchResponseLen-offset-4)
+            break;
+        if (i==0)
+        {
+            if ((res=deserializeParse(m_batchResponse+offset+4, len, args))<0)
+                return res;
+            return len;
+        }
+        offset += 4+len;
+        ALIGN(offset, 4);
+    }
+    return CRP_RES_ERROR;
+}
+
+int Chirp::batchResponse(uint32_t i, va_list args)
+{
+    int res;
+    void *recvArgs[CRP_MAX_ARGS+1];
+    va_list arguments;
+
+    if ((res=batchArgs(i, recvArgs))<0)
+        return res;
+
+    va_copy(arguments, args);
+    res = loadArgs(&arguments, recvArgs);
+    va_end(arguments);
+
+    return res;
+}
+
+int Chirp::batchResponse(uint32_t i, ...)
+{
+    int res;
+    va_list args;
+
+    va_start(args, i);
+    res = batchResponse(i, args);
+    va_end(args);
+
+    return res;
+}
+
+// next tag not in use by a pipelined call, 0 if there isn't one
+uint8_t Chirp::nextTag()
+{
+    int i;
+
+    for (i=0; i<0xff; i++)
+    {
+        if (++m_nextTag==0) // 0 means untagged
+            m_nextTag = 1;
+        if (findPending(m_nextTag)==NULL)
+            return m_nextTag;
+    }
+    return 0;
+}
+
+ChirpPending *Chirp::findPending(uint8_t tag)
+{
+    ChirpPending *pending;
+
+    for (pending=m_pending; pending; pending=pending->next)
+    {
+        if (pending->tag==tag)
+            return pending;
+    }
+    return NULL;
+}
+
+int Chirp::storeResponse(ChirpPending *pending, uint8_t *buf, uint32_t len)
+{
+    pending->buf = new (std::nothrow) uint8_t[len];
+    if (pending->buf==NULL)
+        return CRP_RES_ERROR_MEMORY;
+    memcpy(pending->buf, buf, len);
+    pending->len = len;
+
+    return CRP_RES_STORED;
+}
+
+void Chirp::freePending(ChirpPending *pending)
+{
+    ChirpPending **p;
+
+    for (p=&m_pending; *p; p=&(*p)->next)
+    {
+        if (*p==pending)
+        {
+            *p = pending->next;
+            break;
+        }
+    }
+    delete[] pending->buf;
+    delete pending;
+}
+
 int Chirp::sendChirpRetry(uint8_t type, ChirpProc proc)
 {
     int i, res=-1;
@@ -515,12 +920,13 @@ int Chirp::sendChirpRetry(uint8_t type, ChirpProc proc)
     for (i=0; i<m_retries; i++)
     {
         res = sendChirp(type, proc);
-        if (res==CRP_RES_OK)
+        if (res==CRP_RES_OK || res==CRP_RES_ERROR_COLLISION)
             break;
     }
 
     // if sending the chirp fails after retries, we should assume we're no longer connected
-    if (res<0)
+    // (but not if we backed off for the remote's chirp, we're in step with it)
+    if (res<0 && res!=CRP_RES_ERROR_COLLISION)
         m_connected = false;
 
     return res;
@@ -529,16 +935,22 @@ int Chirp::sendChirpRetry(uint8_t type, ChirpProc proc)
 int Chirp::sendChirp(uint8_t type, ChirpProc proc)
 {
     int res;
+    uint8_t naks;
     if (m_errorCorrected)
         res = sendFull(type, proc);
     else
     {
-        // we'll send forever as long as we get naks
-        // we rely on receiver to give up
-        while((res=sendHeader(type, proc))==CRP_RES_ERROR_CRC);
+        // resend as long as we get naks, up to m_maxNak-- if both sides end up sending
+        // at the same time, sendHeader() sorts out which one goes first
+        for (naks=0; (res=sendHeader(type, proc))==CRP_RES_ERROR_CRC && naks<m_maxNak; naks++);
+        if (res==CRP_RES_ERROR_CRC)
+            m_crc16 = false;
         if (res!=CRP_RES_OK)
             return res;
         res = sendData();
+        // a run of naks, the remote may have gone back to the sum
+        if (res==CRP_RES_ERROR_CRC || res==CRP_RES_ERROR_MAX_NAK)
+            m_crc16 = false;
     }
     if (res!=CRP_RES_OK)
         return res;
@@ -549,7 +961,7 @@ int Chirp::handleChirp(uint8_t type, ChirpProc proc, void *args[])
 {
     int res;
     int32_t responseInt = 0;
-    uint8_t n;
+    uint8_t tag = m_recvTag;
 
     // default case, we return one integer (responseint)
     m_len = 4;
@@ -561,9 +973,13 @@ int Chirp::handleChirp(uint8_t type, ChirpProc proc, void *args[])
         if (type==CRP_CALL_ENUMERATE)
             responseInt = handleEnumerate((char *)args[0], (ChirpProc *)args[1]);
         else if (type==CRP_CALL_INIT)
-            responseInt = handleInit((uint16_t *)args[0], (uint8_t *)args[1]);
+            responseInt = handleInit((uint16_t *)args[0], (uint8_t *)args[1], (uint32_t *)args[2]);
         else if (type==CRP_CALL_ENUMERATE_INFO)
             responseInt = handleEnumerateInfo((ChirpProc *)args[0]);
+        else if (type==CRP_CALL_ENUMERATE_ALL)
+            responseInt = handleEnumerateAll();
+        else if (type==CRP_CALL_BATCH && args[0] && args[1])
+            responseInt = handleBatch((uint32_t *)args[0], (uint8_t *)args[1]);
         else
             responseInt = CRP_RES_ERROR;
         m_call = false;
@@ -582,105 +998,175 @@ int Chirp::handleChirp(uint8_t type, ChirpProc proc, void *args[])
         if (ptr==NULL)
             return CRP_RES_ERROR; // some chirps are not meant to be called in both directions
 
-        // count args
-        for (n=0; args[n]!=NULL; n++);
-
-        m_call = true; // indicate to ourselves that this is a chirp call
-        // this is probably overkill....
-        if (n==0)
-            responseInt = (*ptr)(this);
-        else if (n==1)
-            responseInt = (*(uint32_t(*)(void*,Chirp*))ptr)(args[0],this);
-        else if (n==2)
-            responseInt = (*(uint32_t(*)(void*,void*,Chirp*))ptr)(args[0],args[1],this);
-        else if (n==3)
-            responseInt = (*(uint32_t(*)(void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],this);
-        else if (n==4)
-            responseInt = (*(uint32_t(*)(void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],this);
-        else if (n==5)
-            responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],this);
-        else if (n==6)
-            responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],this);
-        else if (n==7)
-            responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],args[6],this);
-        else if (n==8)
-            responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],args[6],args[7],this);
-        else if (n==9)
-            responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],args[6],args[7],args[8],this);
-        else if (n==10)
-            responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],args[6],args[7],args[8],args[9],this);
-        else
-            responseInt = CRP_RES_ERROR;
-        m_call = false;
+        responseInt = callProc(ptr, args);
     }
 
     // if it's a chirp call, we need to send back the result
     // result is in m_buf
     if (type&CRP_CALL)
     {
+        // the call's args may have been held, but then CRP_RETURN has moved us already
+        if ((res=ownBuffer())<0)
+            return res;
         // write responseInt
         *(uint32_t *)(m_buf+m_headerLen) = responseInt;
-        // send response
+        // send response, with the call's tag so the caller can match it up
+        m_sendTag = tag;
         res = sendChirpRetry(CRP_RESPONSE | (type&~CRP_CALL), m_procTable[proc].chirpProc);	// convert call into response
+        m_sendTag = 0;
         restoreBuffer(); // restore buffer immediately!
         if (res!=CRP_RES_OK) 
             return res;
+        // init response goes out in a CRP_MAX_HEADER_LEN first transfer, everything after it
+        // with what was agreed
+        if (type==CRP_CALL_INIT)
+            m_firstLen = m_firstLenNext;
     }
 
     return CRP_RES_OK;
 }
 
+// call a procedure in our table with the args of the chirp we've received
+int32_t Chirp::callProc(ProcPtr ptr, void *args[])
+{
+    int32_t responseInt;
+    uint8_t n;
+
+    // count args
+    for (n=0; args[n]!=NULL; n++);
+
+    m_call = true; // indicate to ourselves that this is a chirp call
+    // this is probably overkill....
+    if (n==0)
+        responseInt = (*ptr)(this);
+    else if (n==1)
+        responseInt = (*(uint32_t(*)(void*,Chirp*))ptr)(args[0],this);
+    else if (n==2)
+        responseInt = (*(uint32_t(*)(void*,void*,Chirp*))ptr)(args[0],args[1],this);
+    else if (n==3)
+        responseInt = (*(uint32_t(*)(void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],this);
+    else if (n==4)
+        responseInt = (*(uint32_t(*)(void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],this);
+    else if (n==5)
+        responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],this);
+    else if (n==6)
+        responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],this);
+    else if (n==7)
+        responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],args[6],this);
+    else if (n==8)
+        responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],args[6],args[7],this);
+    else if (n==9)
+        responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],args[6],args[7],args[8],this);
+    else if (n==10)
+        responseInt = (*(uint32_t(*)(void*,void*,void*,void*,void*,void*,void*,void*,void*,void*,Chirp*))ptr)(args[0],args[1],args[2],args[3],args[4],args[5],args[6],args[7],args[8],args[9],this);
+    else
+        responseInt = CRP_RES_ERROR;
+    m_call = false;
+
+    return responseInt;
+}
+
+// FNV-1a
+static uint32_t hashName(const char *name)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619;
+    }
+    return hash;
+}
+
 int Chirp::reallocTable()
 {
     ProcTableEntry *newProcTable;
-    int newProcTableSize;
+    uint16_t *newProcIndex;
+    int newProcTableSize, newProcIndexSize;
+    ChirpProc i;
 
     // allocate new table, zero
     newProcTableSize = m_procTableSize+CRP_PROCTABLE_LEN;
+    for (newProcIndexSize=m_procIndexSize; newProcIndexSize<2*newProcTableSize; newProcIndexSize*=2);
     newProcTable = new (std::nothrow) ProcTableEntry[newProcTableSize];
     if (newProcTable==NULL)
         return CRP_RES_ERROR_MEMORY;
+    newProcIndex = new (std::nothrow) uint16_t[newProcIndexSize];
+    if (newProcIndex==NULL)
+    {
+        delete [] newProcTable;
+        return CRP_RES_ERROR_MEMORY;
+    }
     memset(newProcTable, 0, sizeof(ProcTableEntry)*newProcTableSize);
+    memset(newProcIndex, 0, sizeof(uint16_t)*newProcIndexSize);
     // copy to new table
     memcpy(newProcTable, m_procTable, sizeof(ProcTableEntry)*m_procTableSize);
     // delete old table
     delete [] m_procTable;
+    delete [] m_procIndex;
     // set to new
     m_procTable = newProcTable;
     m_procTableSize = newProcTableSize;
+    m_procIndex = newProcIndex;
+    m_procIndexSize = newProcIndexSize;
+
+    // rehash
+    for (i=0; i<m_procTableLen; i++)
+        indexTable(i);
 
     return CRP_RES_OK;
 }
 
 ChirpProc Chirp::lookupTable(const char *procName)
 {
-    ChirpProc i;
+    return lookupTable(procName, hashName(procName));
+}
 
-    for(i=0; i<m_procTableSize; i++)
+// Procedures keep their place in m_procTable (it's their index on the wire), so
+// m_procIndex is a separate open addressing table pointing into it.  It's at most
+// half full, so a miss is a probe or two, and the stored hash saves the strcmp()
+// on anything but a real match.
+ChirpProc Chirp::lookupTable(const char *procName, uint32_t hash)
+{
+    uint16_t i, mask = m_procIndexSize-1;
+    ProcTableEntry *entry;
+
+    for (i=hash&mask; m_procIndex[i]; i=(i+1)&mask)
     {
-        if (m_procTable[i].procName!=NULL && strcmp(m_procTable[i].procName, procName)==0)
-            return i;
+        entry = &m_procTable[m_procIndex[i]-1];
+        if (entry->hash==hash && strcmp(entry->procName, procName)==0)
+            return m_procIndex[i]-1;
     }
     return -1;
 }
 
+void Chirp::indexTable(ChirpProc proc)
+{
+    uint16_t i, mask = m_procIndexSize-1;
+
+    for (i=m_procTable[proc].hash&mask; m_procIndex[i]; i=(i+1)&mask);
+    m_procIndex[i] = proc+1;
+}
 
 ChirpProc Chirp::updateTable(const char *procName, ProcPtr procPtr)
 {
+    uint32_t hash;
+
     // if it exists already, update,
     // if it doesn't exist, add it
     if (procName==NULL)
         return -1;
 
-    ChirpProc proc = lookupTable(procName);
+    hash = hashName(procName);
+    ChirpProc proc = lookupTable(procName, hash);
     if (proc<0) // next empty entry
     {
-        for (proc=0; proc<m_procTableSize && m_procTable[proc].procName; proc++);
-        if (proc==m_procTableSize)
-        {
-            reallocTable();
-            return updateTable(procName, procPtr);
-        }
+        if (m_procTableLen==m_procTableSize && reallocTable()<0)
+            return -1;
+        proc = m_procTableLen++;
+        m_procTable[proc].hash = hash;
+        indexTable(proc);
     }
 
     // add to table
@@ -697,6 +1183,18 @@ ChirpProc Chirp::getProc(const char *procName, ProcPtr callback)
 
     if (callback)
         cproc = updateTable(procName, callback);
+    else if (m_remoteProcTable)
+    {
+        // we have the remote's table (getProcTable()), no need for a round trip
+        uint32_t i;
+        char *name;
+        for (i=0, name=m_remoteProcTable; name<m_remoteProcTable+m_remoteProcTableLen; i++, name+=strlen(name)+1)
+        {
+            if (strcmp(name, procName)==0)
+                return i;
+        }
+        return -1;
+    }
 
     if (call(CRP_CALL_ENUMERATE, 0,
              STRING(procName), // send name
@@ -711,15 +1209,36 @@ ChirpProc Chirp::getProc(const char *procName, ProcPtr callback)
     return -1;
 }
 
+// a link's block size in CRP_MAX_HEADER_LEN units, as CRP_INIT_XFER carries it
+static uint32_t xferUnits(uint32_t blockSize)
+{
+    blockSize /= CRP_MAX_HEADER_LEN;
+    return blockSize>0xff ? 0xff : blockSize;
+}
+
 int Chirp::remoteInit(bool connect)
 {
     int res;
-    uint32_t responseInt;
+    uint32_t responseInt, flags, units;
     uint8_t hinformer;
 
+    // ask for crc16 framing, error-corrected links don't checksum
+    flags = m_errorCorrected ? 0 : CRP_INIT_CRC16;
+    // and for a first transfer as long as our link's blocks, so the header and a small
+    // payload go in one transfer (e.g. a 512 byte high-speed USB packet)
+    units = xferUnits(m_link->blockSize());
+    if (connect && units>1 && !m_sharedMem)
+        flags |= CRP_INIT_XFER | units<<CRP_INIT_XFER_SHIFT;
+
+    // init always goes out with the sum and in a CRP_MAX_HEADER_LEN first transfer, since
+    // we don't know what the remote understands
+    m_crc16 = false;
+    m_crc16Agreed = false;
+    m_firstLen = CRP_MAX_HEADER_LEN;
     res = call(CRP_CALL_INIT, 0,
                UINT16(connect ? m_blkSize : 0), // send block size
                UINT8(m_hinterested), // send whether we're interested in hints or not
+               UINT32(flags),
                END_OUT_ARGS,
                &responseInt,
                &hinformer,       // receive whether we should send hints
@@ -729,6 +1248,22 @@ int Chirp::remoteInit(bool connect)
     {
         m_connected = connect;
         m_hinformer = hinformer;
+        // older firmware doesn't tag its responses, so we don't pipeline.  Neither do we
+        // without error correction-- each side waits for acks, so a response going out
+        // while the next call is coming in would deadlock.
+        if ((int32_t)responseInt>=0)
+        {
+            m_tagged = connect && m_errorCorrected && (responseInt&CRP_INIT_TAGGED);
+            // Older firmware ignores our flags and leaves the bit clear, so we keep the sum.
+            // We switch with the next chirp we send, the remote when that chirp comes in
+            // (see recvHeader()).
+            m_crc16Agreed = connect && (responseInt&CRP_INIT_CRC16);
+            m_crc16 = m_crc16Agreed;
+            // and keeps CRP_MAX_HEADER_LEN
+            if (connect && (responseInt&CRP_INIT_XFER))
+                m_firstLen = ((responseInt&CRP_INIT_XFER_MASK)>>CRP_INIT_XFER_SHIFT)*CRP_MAX_HEADER_LEN;
+            responseInt &= ~(CRP_INIT_TAGGED | CRP_INIT_CRC16 | CRP_INIT_XFER | CRP_INIT_XFER_MASK);
+        }
         return responseInt;
     }
     return res;
@@ -754,6 +1289,42 @@ int Chirp::getProcInfo(ChirpProc proc, ProcInfo *info)
     return res;
 }
 
+// Fetch the remote's entire procedure table in one call so that subsequent getProc()
+// calls (without callback) can be resolved locally.  Older firmware doesn't support
+// CRP_CALL_ENUMERATE_ALL and returns an error, in which case getProc() keeps doing
+// a round trip per procedure.
+int Chirp::getProcTable()
+{
+    uint32_t responseInt, len;
+    uint8_t *names;
+    int res;
+
+    res = call(CRP_CALL_ENUMERATE_ALL, 0,
+               END_OUT_ARGS,
+               &responseInt,
+               &len,
+               &names,
+               END_IN_ARGS
+               );
+
+    if (res!=CRP_RES_OK)
+        return res;
+    if ((int32_t)responseInt<0 || len==0 || names[len-1]!='\0')
+        return CRP_RES_ERROR;
+
+    delete[] m_remoteProcTable;
+    m_remoteProcTable = new (std::nothrow) char[len];
+    if (m_remoteProcTable==NULL)
+    {
+        m_remoteProcTableLen = 0;
+        return CRP_RES_ERROR_MEMORY;
+    }
+    memcpy(m_remoteProcTable, names, len);
+    m_remoteProcTableLen = len;
+
+    return responseInt;
+}
+
 int Chirp::setProc(const char *procName, ProcPtr proc, ProcTableExtension *extension)
 {
     ChirpProc cProc = updateTable(procName, proc);
@@ -780,17 +1351,41 @@ int32_t Chirp::handleEnumerate(char *procName, ChirpProc *callback)
     // lookup in table
     proc = lookupTable(procName);
     // set remote index in table
-    m_procTable[proc].chirpProc = *callback;
+    if (proc>=0)
+        m_procTable[proc].chirpProc = *callback;
 
     return proc;
 }
 
-int32_t Chirp::handleInit(uint16_t *blkSize, uint8_t *hinformer)
+int32_t Chirp::handleInit(uint16_t *blkSize, uint8_t *hinformer, uint32_t *flags)
 {
     int32_t responseInt;
+    uint32_t units = 0;
 
     bool connect = *blkSize ? true : false;
     responseInt = init(connect);
+    // Older clients don't send flags.  We keep the sum until the client's first crc16
+    // chirp comes in, it switches when it sends it.
+    m_crc16 = false;
+    m_crc16Agreed = connect && responseInt>=0 && !m_errorCorrected && flags && (*flags&CRP_INIT_CRC16);
+    // the response goes out the way init came in, with the sum and in a CRP_MAX_HEADER_LEN
+    // first transfer.  After that, the shorter of the two links' block sizes.
+    m_firstLen = CRP_MAX_HEADER_LEN;
+    if (connect && responseInt>=0 && flags && (*flags&CRP_INIT_XFER) && !m_sharedMem)
+    {
+        units = (*flags&CRP_INIT_XFER_MASK)>>CRP_INIT_XFER_SHIFT;
+        if (units>xferUnits(m_link->blockSize()))
+            units = xferUnits(m_link->blockSize());
+    }
+    m_firstLenNext = units>1 ? units*CRP_MAX_HEADER_LEN : CRP_MAX_HEADER_LEN;
+    if (responseInt>=0)
+    {
+        responseInt |= CRP_INIT_TAGGED;
+        if (m_crc16Agreed)
+            responseInt |= CRP_INIT_CRC16;
+        if (units>1)
+            responseInt |= CRP_INIT_XFER | units<<CRP_INIT_XFER_SHIFT;
+    }
     m_connected = connect;
     m_blkSize = *blkSize;  // get block size, write it
     m_hinformer = *hinformer;
@@ -824,6 +1419,145 @@ int32_t Chirp::handleEnumerateInfo(ChirpProc *proc)
     }
 }
 
+// Return the names of all procedures in our table, '\0'-separated and in index order
+// (empty string for unused entries) so the caller can compute each index.
+int32_t Chirp::handleEnumerateAll()
+{
+    ChirpProc i, n;
+    uint32_t len;
+    uint8_t *names;
+    char *p;
+
+    // find extent of table, and length of names
+    for (i=0, n=0, len=0; i<m_procTableLen; i++)
+    {
+        if (m_procTable[i].procName)
+        {
+            n = i+1;
+            len += strlen(m_procTable[i].procName);
+        }
+    }
+    len += n;
+    if (len==0)
+        return CRP_RES_ERROR;
+
+    names = new (std::nothrow) uint8_t[len];
+    if (names==NULL)
+        return CRP_RES_ERROR_MEMORY;
+
+    for (i=0, p=(char *)names; i<n; i++)
+    {
+        if (m_procTable[i].procName)
+        {
+            strcpy(p, m_procTable[i].procName);
+            p += strlen(p)+1;
+        }
+        else
+            *p++ = '\0';
+    }
+
+    CRP_RETURN(this, UINTS8(len, names), END);
+    delete[] names;
+
+    return n;
+}
+
+// Make each call in a batch and send all of their responses back in one.  The calls are
+// packed one after the other, each 4-byte aligned:
+//
+//     proc (uint16_t), (pad), len (uint32_t), len bytes of serialized args
+//
+// and so are the responses, each one what the call on its own would have gotten back,
+// with its type in front the way recvChirp() stores it:
+//
+//     len (uint32_t), len bytes of serialized response int and return values
+int32_t Chirp::handleBatch(uint32_t *len, uint8_t *calls)
+{
+    uint8_t *in, *out = NULL, *newOut, *rec;
+    uint32_t i, argLen, recLen, inLen = *len, outLen = 0, outSize = 0;
+    int32_t n, res = CRP_RES_OK;
+    ChirpProc proc;
+    ProcPtr ptr;
+    void *args[CRP_MAX_ARGS+1];
+
+    // each call's args and response go through m_buf, so the calls need to be somewhere else
+    if ((in=new (std::nothrow) uint8_t[inLen])==NULL)
+        return CRP_RES_ERROR_MEMORY;
+    memcpy(in, calls, inLen);
+
+    for (i=0, n=0; i+8<=inLen && res==CRP_RES_OK; n++)
+    {
+        proc = *(ChirpProc *)(in+i);
+        argLen = *(uint32_t *)(in+i+4);
+        i += 8;
+        if (argLen>inLen-i)
+        {
+            res = CRP_RES_ERROR_PARSE;
+            break;
+        }
+
+        // set the call up the way recvChirp() would have, then make it
+        m_len = 4;
+        if ((res=ownBuffer())<0 ||
+                (m_headerLen+argLen+CRP_BUFPAD>m_bufSize && (res=realloc(m_headerLen+argLen+CRP_BUFPAD))<0))
+            break;
+        memcpy(m_buf+m_headerLen, in+i, argLen);
+        i += argLen;
+        ALIGN(i, 4);
+        if (proc<0 || proc>=m_procTableSize || (ptr=m_procTable[proc].procPtr)==NULL ||
+                deserializeParse(m_buf+m_headerLen, argLen, args)<0)
+            *(uint32_t *)(m_buf+m_headerLen) = CRP_RES_ERROR;
+        else
+        {
+            res = callProc(ptr, args);
+            // the response may be in the proc's own buffer (useBuffer()), or CRP_RETURN has moved us
+            if (ownBuffer()<0)
+                break;
+            *(uint32_t *)(m_buf+m_headerLen) = res;
+            res = CRP_RES_OK;
+        }
+
+        recLen = m_len+4;
+        if (outLen+4+recLen+3>outSize)
+        {
+            outSize = 2*(outLen+4+recLen+3);
+            if ((newOut=new (std::nothrow) uint8_t[outSize])==NULL)
+                res = CRP_RES_ERROR_MEMORY;
+            else
+            {
+                memcpy(newOut, out, outLen);
+                delete[] out;
+                out = newOut;
+            }
+        }
+        if (res==CRP_RES_OK)
+        {
+            *(uint32_t *)(out+outLen) = recLen;
+            rec = out+outLen+4;
+            rec[0] = CRP_UINT32;
+            rec[1] = rec[2] = 0;
+            rec[3] = CRP_UINT32;
+            memcpy(rec+4, m_buf+m_headerLen, m_len);
+            outLen += 4+recLen;
+            while (outLen&3)
+                out[outLen++] = 0;
+        }
+        restoreBuffer();
+    }
+
+    m_call = true; // callProc() is done with it
+    m_len = 4;
+    if (res==CRP_RES_OK && (res=ownBuffer())==CRP_RES_OK &&
+            m_headerLen+outLen+16+CRP_BUFPAD>m_bufSize)
+        res = realloc(m_headerLen+outLen+16+CRP_BUFPAD);
+    if (res==CRP_RES_OK)
+        CRP_RETURN(this, UINTS8(outLen, out), END);
+    delete[] in;
+    delete[] out;
+
+    return res==CRP_RES_OK ? n : res;
+}
+
 int Chirp::realloc(uint32_t min)
 {
     if (m_sharedMem)
@@ -840,23 +1574,159 @@ int Chirp::realloc(uint32_t min)
     delete[] m_buf;
     m_buf = newbuf;
     m_bufSize = min;
+    if (m_recvBuf)
+    {
+        m_recvBuf->m_data = m_buf;
+        m_recvBuf->m_size = m_bufSize;
+    }
+
+    return CRP_RES_OK;
+}
+
+ChirpBuffer::ChirpBuffer(uint32_t size)
+{
+    m_data = new (std::nothrow) uint8_t[size];
+    m_size = size;
+    m_refs = 1;
+    m_chirp = NULL;
+    m_next = NULL;
+}
+
+ChirpBuffer::~ChirpBuffer()
+{
+    delete[] m_data;
+}
+
+void ChirpBuffer::release()
+{
+    if (--m_refs)
+        return;
+    if (m_chirp)
+        m_chirp->putBuffer(this);
+    else
+        delete this;
+}
+
+ChirpBuffer *Chirp::holdBuffer(const void *ptr)
+{
+    if (m_recvBuf==NULL || m_bufSave)
+        return NULL;
+    if (ptr && ((uint8_t *)ptr<m_buf || (uint8_t *)ptr>=m_buf+m_bufSize))
+        return NULL;
+    m_recvBuf->m_refs++;
+    return m_recvBuf;
+}
+
+// We're about to write to m_buf.  If somebody is holding it, leave it to them and carry
+// on in a buffer from the pool.
+int Chirp::ownBuffer()
+{
+    ChirpBuffer *buf;
+
+    if (m_recvBuf==NULL || m_recvBuf->m_refs==1 || m_bufSave)
+        return CRP_RES_OK;
+    if ((buf=getBuffer(m_bufSize))==NULL)
+        return CRP_RES_ERROR_MEMORY;
+    m_recvBuf->m_refs--;
+    m_recvBuf->m_next = m_held;
+    m_held = m_recvBuf;
+    m_recvBuf = buf;
+    m_buf = buf->m_data;
+    m_bufSize = buf->m_size;
 
     return CRP_RES_OK;
 }
 
+// A buffer of at least size bytes.  Pooled buffers grow to the biggest chirp received
+// so far, so once things are going there's nothing to allocate.
+ChirpBuffer *Chirp::getBuffer(uint32_t size)
+{
+    ChirpBuffer *buf;
+    uint8_t *data;
+
+    if (m_pool)
+    {
+        buf = m_pool;
+        // chirps have gotten bigger since it went in the pool
+        if (buf->m_size<size)
+        {
+            if ((data=new (std::nothrow) uint8_t[size])==NULL)
+                return NULL;
+            delete[] buf->m_data;
+            buf->m_data = data;
+            buf->m_size = size;
+        }
+        m_pool = buf->m_next;
+        m_poolLen--;
+        buf->m_refs = 1;
+        buf->m_next = NULL;
+        return buf;
+    }
+    buf = new (std::nothrow) ChirpBuffer(size);
+    if (buf==NULL || buf->m_data==NULL)
+    {
+        delete buf;
+        return NULL;
+    }
+    buf->m_chirp = this;
+    return buf;
+}
+
+// last reference to a held buffer is gone, keep it for reuse
+void Chirp::putBuffer(ChirpBuffer *buf)
+{
+    ChirpBuffer **prev;
+
+    for (prev=&m_held; *prev && *prev!=buf; prev=&(*prev)->m_next);
+    if (*prev)
+        *prev = buf->m_next;
+    if (m_poolLen<CRP_BUFPOOL)
+    {
+        buf->m_next = m_pool;
+        m_pool = buf;
+        m_poolLen++;
+    }
+    else
+        delete buf;
+}
+
+// free what we can, buffers others are holding are freed when they let go
+void Chirp::freeBuffers()
+{
+    ChirpBuffer *buf;
+
+    while (m_pool)
+    {
+        buf = m_pool;
+        m_pool = buf->m_next;
+        delete buf;
+    }
+    m_poolLen = 0;
+    for (buf=m_held; buf; buf=buf->m_next)
+        buf->m_chirp = NULL;
+    m_held = NULL;
+    if (m_recvBuf)
+    {
+        m_recvBuf->m_chirp = NULL;
+        m_recvBuf->release();
+        m_recvBuf = NULL;
+    }
+}
+
 // service deals with calls and callbacks
 int Chirp::service(bool all)
 {
-    int i;
+    int i, res;
     uint8_t type;
     ChirpProc recvProc;
     void *args[CRP_MAX_ARGS+1];
 
     for (i=0; true; i++)
     {
-        if (recvChirp(&type, &recvProc, args)==CRP_RES_OK)
+        res = recvChirp(&type, &recvProc, args);
+        if (res==CRP_RES_OK)
             handleChirp(type, recvProc, args);
-        else
+        else if (res!=CRP_RES_STORED)
             break;
         if (!all)
             break;
@@ -869,8 +1739,11 @@ int Chirp::recvChirp(uint8_t *type, ChirpProc *proc, void *args[], bool wait) //
 {
     int res;
     uint32_t i, offset;
+    ChirpPending *pending;
 
     restoreBuffer();
+    if ((res=ownBuffer())<0)
+        return res;
 
     // receive
     if (m_errorCorrected)
@@ -884,8 +1757,10 @@ int Chirp::recvChirp(uint8_t *type, ChirpProc *proc, void *args[], bool wait) //
             {
                 if (i<m_maxNak)
                     continue;
-                else
-                    return CRP_RES_ERROR_MAX_NAK;
+                // a run of bad headers, go back to the sum (we follow the remote if it's
+                // still on crc16)
+                m_crc16 = false;
+                return CRP_RES_ERROR_MAX_NAK;
             }
             else if (res==CRP_RES_OK)
                 break;
@@ -893,6 +1768,8 @@ int Chirp::recvChirp(uint8_t *type, ChirpProc *proc, void *args[], bool wait) //
                 return res;
         }
         res = recvData();
+        if (res==CRP_RES_ERROR_MAX_NAK)
+            m_crc16 = false;
     }
     if (res!=CRP_RES_OK)
         return res;
@@ -906,6 +1783,10 @@ int Chirp::recvChirp(uint8_t *type, ChirpProc *proc, void *args[], bool wait) //
         // increment pointer
         offset = m_headerLen-4;
         m_len+=4;
+        // a pipelined call's response waits for getResponse()
+        pending = findPending(m_tagged ? m_recvTag : m_lastTag);
+        if (pending && pending->buf==NULL)
+            return storeResponse(pending, m_buf+offset, m_len);
     }
     else // call has no responseInt
         offset = m_headerLen;
@@ -1038,22 +1919,77 @@ uint16_t Chirp::calcCrc(uint8_t *buf, uint32_t len)
     return crc;
 }
 
+// crc16-ccitt (poly 0x1021, msb first), 8 bytes per step.  table[0] is the usual
+// byte-at-a-time table, table[k] is the crc of a byte followed by k zero bytes, so
+// 8 lookups, one per byte, advance the crc 8 bytes at once.
+uint16_t Chirp::calcCrc16(const uint8_t *buf, uint32_t len, uint16_t crc)
+{
+    static uint16_t table[8][256];
+    static bool init = false;
+    uint32_t i, j;
+    uint16_t c;
+
+    if (!init)
+    {
+        for (i=0; i<256; i++)
+        {
+            for (j=0, c=i<<8; j<8; j++)
+                c = c&0x8000 ? (c<<1)^0x1021 : c<<1;
+            table[0][i] = c;
+        }
+        for (j=1; j<8; j++)
+        {
+            for (i=0; i<256; i++)
+                table[j][i] = (table[j-1][i]<<8) ^ table[0][table[j-1][i]>>8];
+        }
+        init = true;
+    }
+
+    for (; len>=8; len-=8, buf+=8)
+        crc = table[7][buf[0]^(crc>>8)] ^ table[6][buf[1]^(crc&0xff)] ^
+                table[5][buf[2]] ^ table[4][buf[3]] ^ table[3][buf[4]] ^
+                table[2][buf[5]] ^ table[1][buf[6]] ^ table[0][buf[7]];
+    for (; len; len--)
+        crc = (crc<<8) ^ table[0][(crc>>8)^*buf++];
+
+    return crc;
+}
+
+uint16_t Chirp::frameCrcSeed()
+{
+    return m_crc16 ? 0xffff : 0;
+}
+
+// checksum for the header and data chunks, the sum unless crc16 was agreed on in init
+uint16_t Chirp::frameCrc(const uint8_t *buf, uint32_t len, uint16_t crc)
+{
+    if (m_crc16)
+        return calcCrc16(buf, len, crc);
+    return crc + calcCrc((uint8_t *)buf, len);
+}
+
 
 int Chirp::sendFull(uint8_t type, ChirpProc proc)
 {
     int res;
+    uint32_t len = m_len+m_headerLen, first = m_firstLen;
 
     *(uint32_t *)m_buf = CRP_START_CODE;
     *(uint8_t *)(m_buf+4) = type;
+    *(uint8_t *)(m_buf+5) = m_sendTag;
     *(ChirpProc *)(m_buf+6) = proc;
     *(uint32_t *)(m_buf+8) = m_len;
-    // send header
-    if ((res=m_link->send(m_buf, CRP_MAX_HEADER_LEN, m_sendTimeout))<0)
+    // Send header, and as much data as fits.  Older remotes always take CRP_MAX_HEADER_LEN,
+    // one that negotiated a longer first transfer takes a short one if that's all there is
+    // (the short packet ends the transfer).
+    if (first>CRP_MAX_HEADER_LEN && len<first)
+        first = len;
+    if ((res=m_link->send(m_buf, first, m_sendTimeout))<0)
         return res;
     // if we haven't sent everything yet....
-    if (m_len+m_headerLen>CRP_MAX_HEADER_LEN && !m_sharedMem)
+    if (len>m_firstLen && !m_sharedMem)
     {
-        if ((res=m_link->send(m_buf+CRP_MAX_HEADER_LEN, m_len-(CRP_MAX_HEADER_LEN-m_headerLen), m_sendTimeout))<0)
+        if ((res=m_link->send(m_buf+m_firstLen, len-m_firstLen, m_sendTimeout))<0)
             return res;
     }
     return CRP_RES_OK;
@@ -1070,26 +2006,39 @@ int Chirp::sendHeader(uint8_t type, ChirpProc proc)
         return res;
 
     *(uint8_t *)m_buf = type;
+    *(uint8_t *)(m_buf+1) = m_sendTag;
     *(uint16_t *)(m_buf+2) = proc;
     *(uint32_t *)(m_buf+4) = m_len;
     if ((res=m_link->send(m_buf, m_headerLen, m_sendTimeout))<0)
         return res;
-    crc = calcCrc(m_buf, m_headerLen);
+    crc = frameCrc(m_buf, m_headerLen, frameCrcSeed());
 
-    if (m_len>=CRP_MAX_HEADER_LEN)
-        chunk = CRP_MAX_HEADER_LEN;
+    // first chunk of data goes with the header, same as recvHeader()
+    if (m_len>=m_firstLen-m_headerLen)
+        chunk = m_firstLen-m_headerLen;
     else
         chunk = m_len;
-    if (m_link->send(m_buf, chunk, m_sendTimeout)<0)
+    if (m_link->send(m_buf+m_headerLen, chunk, m_sendTimeout)<0)
         return CRP_RES_ERROR_SEND_TIMEOUT;
 
     // send crc
-    crc += calcCrc(m_buf, chunk);
+    crc = frameCrc(m_buf+m_headerLen, chunk, crc);
     if (m_link->send((uint8_t *)&crc, 2, m_sendTimeout)<0)
         return CRP_RES_ERROR_SEND_TIMEOUT;
 
     if ((res=recvAck(&ack, m_headerTimeout))<0)
+    {
+        // The remote is sending a chirp of its own, e.g. the response to a call we gave up
+        // on, and is taking ours as a nak.  If we both sent again, neither would get through.
+        // The device backs off and receives the host's chirp, the host drops the device's
+        // and sends again.
+        if (res==CRP_RES_ERROR_COLLISION && m_client)
+        {
+            flushLink();
+            return CRP_RES_ERROR_CRC;
+        }
         return res;
+    }
 
     if (ack)
         m_offset = chunk;
@@ -1103,24 +2052,25 @@ int Chirp::sendData()
 {
     uint16_t crc;
     uint32_t chunk;
-    uint8_t sequence;
+    uint8_t sequence, naks;
     bool ack;
     int res;
 
-    for (sequence=0; m_offset<m_len; )
+    for (sequence=0, naks=0; m_offset<m_len; )
     {
         if (m_len-m_offset>=m_blkSize)
             chunk = m_blkSize;
         else
             chunk = m_len-m_offset;
         // send data
-        if (m_link->send(m_buf+m_offset, chunk, m_sendTimeout)<0)
+        if (m_link->send(m_buf+m_headerLen+m_offset, chunk, m_sendTimeout)<0)
             return CRP_RES_ERROR_SEND_TIMEOUT;
         // send sequence
         if (m_link->send((uint8_t *)&sequence, 1, m_sendTimeout)<0)
             return CRP_RES_ERROR_SEND_TIMEOUT;
         // send crc
-        crc = calcCrc(m_buf+m_offset, chunk) + calcCrc((uint8_t *)&sequence, 1);
+        crc = frameCrc(m_buf+m_headerLen+m_offset, chunk, frameCrcSeed());
+        crc = frameCrc((uint8_t *)&sequence, 1, crc);
         if (m_link->send((uint8_t *)&crc, 2, m_sendTimeout)<0)
             return CRP_RES_ERROR_SEND_TIMEOUT;
 
@@ -1130,7 +2080,10 @@ int Chirp::sendData()
         {
             m_offset += chunk;
             sequence++;
+            naks = 0;
         }
+        else if (++naks>=m_maxNak)
+            return CRP_RES_ERROR_MAX_NAK;
     }
     return CRP_RES_OK;
 }
@@ -1156,6 +2109,7 @@ int Chirp::recvHeader(uint8_t *type, ChirpProc *proc, bool wait)
     uint8_t c;
     uint32_t chunk, startCode = 0;
     uint16_t crc, rcrc;
+    bool ok;
 
     if ((res=m_link->receive(&c, 1, wait?m_headerTimeout:0))<0)
         return res;
@@ -1175,25 +2129,43 @@ int Chirp::recvHeader(uint8_t *type, ChirpProc *proc, bool wait)
             return CRP_RES_ERROR;
     }
     // receive rest of header
-    if (m_link->receive(m_buf, m_headerLen, m_idleTimeout)<0)
+    if ((res=m_link->receive(m_buf, m_headerLen, m_idleTimeout))<0)
         return CRP_RES_ERROR_RECV_TIMEOUT;
     if (res<(int)m_headerLen)
         return CRP_RES_ERROR;
     *type = *(uint8_t *)m_buf;
+    m_recvTag = *(uint8_t *)(m_buf+1);
     *proc = *(ChirpProc *)(m_buf+2);
     m_len = *(uint32_t *)(m_buf+4);
-    crc = calcCrc(m_buf, m_headerLen);
+    crc = frameCrc(m_buf, m_headerLen, frameCrcSeed());
 
-    if (m_len>=CRP_MAX_HEADER_LEN-m_headerLen)
-        chunk = CRP_MAX_HEADER_LEN-m_headerLen;
+    if (m_len>=m_firstLen-m_headerLen)
+        chunk = m_firstLen-m_headerLen;
     else
         chunk = m_len;
-    if ((res=m_link->receive(m_buf, chunk+2, m_idleTimeout))<0) // +2 for crc
+    if (m_headerLen+chunk+2>m_bufSize && (res=realloc(m_headerLen+chunk+2))<0)
+        return res;
+    if ((res=m_link->receive(m_buf+m_headerLen, chunk+2, m_idleTimeout))<0) // +2 for crc
         return res;
     if (res<(int)chunk+2)
         return CRP_RES_ERROR;
-    copyAlign((char *)&rcrc, (char *)(m_buf+chunk), 2);
-    if (rcrc==crc+calcCrc(m_buf, chunk))
+    copyAlign((char *)&rcrc, (char *)(m_buf+m_headerLen+chunk), 2);
+    ok = rcrc==frameCrc(m_buf+m_headerLen, chunk, crc);
+    // Once init has agreed on crc16, the remote's frames may carry either checksum: it
+    // switches to crc16 with its first chirp after init, falls back to the sum after a run
+    // of failures, and sends init with the sum when it reconnects.  We follow it.  A frame
+    // that checks out with crc16 is taken, one only the sum vouches for is nak'ed and has
+    // to come again, so a corrupted frame doesn't get in on the weaker check.
+    if (!ok && m_crc16Agreed)
+    {
+        m_crc16 = !m_crc16;
+        crc = frameCrc(m_buf, m_headerLen, frameCrcSeed());
+        if (rcrc==frameCrc(m_buf+m_headerLen, chunk, crc))
+            ok = m_crc16;
+        else
+            m_crc16 = !m_crc16;
+    }
+    if (ok)
     {
         m_offset = chunk;
         sendAck(true);
@@ -1213,13 +2185,15 @@ int Chirp::recvFull(uint8_t *type, ChirpProc *proc, bool wait)
     uint32_t startCode;
     uint32_t len, recvd;
 
+    if (m_firstLen>m_bufSize && (res=realloc(m_firstLen))<0)
+        return res;
     // receive header, with startcode check to make sure we're synced
     while(1)
     {
-        if ((res=m_link->receive(m_buf, CRP_MAX_HEADER_LEN, wait?m_headerTimeout:0))<0)
+        if ((res=m_link->receive(m_buf, m_firstLen, wait?m_headerTimeout:0))<0)
             return res;
         // check to see if we received less data than expected
-        if (res<CRP_MAX_HEADER_LEN)
+        if (res<(int)m_headerLen)
             return CRP_RES_ERROR;
 
         startCode = *(uint32_t *)m_buf;
@@ -1227,16 +2201,20 @@ int Chirp::recvFull(uint8_t *type, ChirpProc *proc, bool wait)
             break;
     }
     *type = *(uint8_t *)(m_buf+4);
+    m_recvTag = *(uint8_t *)(m_buf+5);
     *proc = *(ChirpProc *)(m_buf+6);
     m_len = *(uint32_t *)(m_buf+8);
+    len = m_len+m_headerLen;
+    // a short first transfer has to be the whole chirp
+    if ((uint32_t)res<m_firstLen && (uint32_t)res<len)
+        return CRP_RES_ERROR;
 
-    if (m_len+m_headerLen>m_bufSize && (res=realloc(m_len+m_headerLen))<0)
+    if (len>m_bufSize && (res=realloc(len))<0)
         return res;
 
-    if (m_len+m_headerLen>CRP_MAX_HEADER_LEN && !m_sharedMem)
+    if (len>m_firstLen && !m_sharedMem)
     {
-        len = m_len+m_headerLen;
-        recvd = CRP_MAX_HEADER_LEN;
+        recvd = m_firstLen;
         while(recvd<len)
         {
             if ((res=m_link->receive(m_buf+recvd, len-recvd, m_idleTimeout))<0)
@@ -1286,13 +2264,13 @@ int Chirp::recvData()
             chunk = m_blkSize;
         else
             chunk = m_len-m_offset;
-        if (m_link->receive(m_buf+m_offset, chunk+3, m_dataTimeout)<0) // +3 to read sequence, crc
+        if ((res=m_link->receive(m_buf+m_headerLen+m_offset, chunk+3, m_dataTimeout))<0) // +3 to read sequence, crc
             return CRP_RES_ERROR_RECV_TIMEOUT;
         if (res<(int)chunk+3)
             return CRP_RES_ERROR;
-        sequence = *(uint8_t *)(m_buf+m_offset+chunk);
-        copyAlign((char *)&crc, (char *)(m_buf+m_offset+chunk+1), 2);
-        if (crc==calcCrc(m_buf+m_offset, chunk+1))
+        sequence = *(uint8_t *)(m_buf+m_headerLen+m_offset+chunk);
+        copyAlign((char *)&crc, (char *)(m_buf+m_headerLen+m_offset+chunk+1), 2);
+        if (crc==frameCrc(m_buf+m_headerLen+m_offset, chunk+1, frameCrcSeed()))
         {
             if (rsequence==sequence)
             {
@@ -1315,6 +2293,15 @@ int Chirp::recvData()
     return CRP_RES_OK;
 }
 
+static uint8_t bitsSet(uint8_t c)
+{
+    uint8_t n;
+
+    for (n=0; c; c&=c-1)
+        n++;
+    return n;
+}
+
 int Chirp::recvAck(bool *ack, uint16_t timeout) // false=nack
 {
     int res;
@@ -1324,10 +2311,23 @@ int Chirp::recvAck(bool *ack, uint16_t timeout) // false=nack
     if (res<1)
         return CRP_RES_ERROR;
 
-    if (c==CRP_ACK)
+    // CRP_ACK and CRP_NACK are 4 bits apart, so an ack with a bit flipped is still an ack.
+    // Taking it as a nak would have us send again while the remote has moved on.
+    if (bitsSet(c^CRP_ACK)<=1)
         *ack = true;
-    else
+    else if (bitsSet(c^CRP_NACK)<=1)
         *ack = false;
+    else // neither, it's the start of the remote's chirp
+        return CRP_RES_ERROR_COLLISION;
 
     return CRP_RES_OK;
 }
+
+// drop what the remote has sent, until the link goes quiet
+void Chirp::flushLink()
+{
+    uint8_t c;
+    uint32_t i;
+
+    for (i=0; i<CRP_FLUSH_LEN && m_link->receive(&c, 1, 1)>0; i++);
+}
@@ -18,6 +18,8 @@
 #define CRP_RES_ERROR_MAX_NAK           -4
 #define CRP_RES_ERROR_MEMORY            -5
 #define CRP_RES_ERROR_NOT_CONNECTED     -6
+#define CRP_RES_ERROR_COLLISION         -7 // the remote started a chirp of its own while we waited for an ack
+#define CRP_RES_STORED                  1 // recvChirp() put away a pipelined response for getResponse()
 
 #define CRP_MAX_NAK           		3
 #define CRP_RETRIES                     3
@@ -28,6 +30,7 @@
 #define CRP_MAX_ARGS          		10
 #define CRP_BUFSIZE           		0x80
 #define CRP_BUFPAD            		8
+#define CRP_BUFPOOL                     4 // free receive buffers kept for reuse
 #define CRP_PROCTABLE_LEN     		0x40
 
 #define CRP_START_CODE        		0xaaaa5555
@@ -40,10 +43,18 @@
 #define CRP_CALL_ENUMERATE    		(CRP_CALL | CRP_INTRINSIC | 0x00)
 #define CRP_CALL_INIT         		(CRP_CALL | CRP_INTRINSIC | 0x01)
 #define CRP_CALL_ENUMERATE_INFO         (CRP_CALL | CRP_INTRINSIC | 0x02)
+#define CRP_CALL_ENUMERATE_ALL          (CRP_CALL | CRP_INTRINSIC | 0x03)
+#define CRP_CALL_BATCH                  (CRP_CALL | CRP_INTRINSIC | 0x04)
+#define CRP_INIT_TAGGED                 0x40000000 // set in init response if responses carry the call's tag
+#define CRP_INIT_CRC16                  0x20000000 // set in init flags/response to frame with crc16 instead of the sum
+#define CRP_INIT_XFER                   0x10000000 // set in init flags/response with a first transfer length, below
+#define CRP_INIT_XFER_SHIFT             16 // first transfer length in CRP_MAX_HEADER_LEN units, bits 16-23
+#define CRP_INIT_XFER_MASK              (0xff<<CRP_INIT_XFER_SHIFT)
 
 #define CRP_ACK                         0x59
 #define CRP_NACK                        0x95
 #define CRP_MAX_HEADER_LEN              64
+#define CRP_FLUSH_LEN                   0x400 // most we drop from the link at once after a collision
 
 #define CRP_ARRAY                       0x80 // bit
 #define CRP_FLT                         0x10 // bit
@@ -158,12 +169,14 @@
 #define ASYNC                           0x01 // bit
 #define RETURN_ARRAY                    0x02 // bit
 #define SYNC_RETURN_ARRAY               (SYNC | RETURN_ARRAY)
+#define PIPELINED                       0x04 // bit
 
 #define CRP_RETURN(chirp, ...)          chirp->assemble(0, __VA_ARGS__, END)
 #define CRP_SEND_XDATA(chirp, ...)      chirp->assemble(CRP_XDATA, __VA_ARGS__, END)
 #define callSync(...)                   call(SYNC, __VA_ARGS__, END)
 #define callAsync(...)                  call(ASYNC, __VA_ARGS__, END)
 #define callSyncArray(...)              call(SYNC_RETURN_ARRAY, __VA_ARGS__, END)
+#define callPipelined(...)              call(PIPELINED, __VA_ARGS__, END)
 
 class Chirp;
 
@@ -198,6 +211,34 @@ struct ProcTableEntry
     ProcPtr procPtr;
     ChirpProc chirpProc;
     const ProcTableExtension *extension;
+    uint32_t hash; // of procName, see lookupTable()
+};
+
+struct ChirpPending
+{
+    uint8_t tag;
+    uint8_t *buf; // serialized response, NULL until it arrives
+    uint32_t len;
+    ChirpPending *next;
+};
+
+// A receive buffer that can be kept past the next receive, see Chirp::holdBuffer()
+class ChirpBuffer
+{
+public:
+    void release();
+
+private:
+    ChirpBuffer(uint32_t size);
+    ~ChirpBuffer();
+
+    uint8_t *m_data;
+    uint32_t m_size;
+    uint32_t m_refs;
+    Chirp *m_chirp; // whose pool it goes back to, NULL once that Chirp is gone
+    ChirpBuffer *m_next;
+
+    friend class Chirp;
 };
 
 class Chirp
@@ -211,14 +252,47 @@ public:
     ChirpProc getProc(const char *procName, ProcPtr callback=0);
     int setProc(const char *procName, ProcPtr proc,  ProcTableExtension *extension=NULL);
     int getProcInfo(ChirpProc proc, ProcInfo *info);
+    int getProcTable();
     int registerModule(const ProcModule *module);
 
     int call(uint8_t service, ChirpProc proc, ...);
     int call(uint8_t service, ChirpProc proc, va_list args);
+    // callPipelined() returns as soon as the call is sent, so several calls can be in flight.
+    // lastTag() identifies the call, getResponse() waits for its response and loads the
+    // in-args the way callSync() does.  getResponse(lastTag()) also collects the response
+    // to an ASYNC call, as long as nothing else has been sent since.
+    uint8_t lastTag();
+    int getResponse(uint8_t tag, ...);
+    int getResponse(uint8_t tag, va_list args);
+    // Batched calls.  The calls added after batchBegin() go out together in one
+    // CRP_CALL_BATCH chirp when batchCall() is called, and all of their responses come
+    // back in one response, so independent calls (both servos and the LED, say) cost one
+    // round trip.  batchAdd() takes the out-args the way call() does, batchCall() returns
+    // how many calls were made, and batchResponse(i) loads the i'th call's in-args the
+    // way callSync() does.  Arrays in the responses are good until the next batchCall().
+    // Older firmware doesn't know CRP_CALL_BATCH, batchCall() returns an error and the
+    // calls have to be made one by one.
+    int batchBegin();
+    int batchAdd(ChirpProc proc, ...);
+    int batchAdd(ChirpProc proc, va_list *args);
+    int batchCall();
+    int batchResponse(uint32_t i, ...);
+    int batchResponse(uint32_t i, va_list args);
+    int batchArgs(uint32_t i, void *args[]); // length of the response, which starts 4 bytes before args[0]
+    // for typed calls (chirptyped.hpp), which write their arguments into argBuffer()
+    // themselves and hand them to sendArgs()
+    uint8_t *argBuffer(uint32_t len);
+    int sendArgs(uint8_t service, ChirpProc proc, uint32_t len, void *recvArgs[]);
+    // for procedures that write a long response in place instead of handing CRP_RETURN
+    // a copy of it: returnBuffer() is where the response's args go, returnArgs() sets
+    // their length
+    uint8_t *returnBuffer(uint32_t len);
+    void returnArgs(uint32_t len);
     static uint8_t getType(void *arg);
     int service(bool all=true);
     int assemble(uint8_t type, ...);
     bool connected();
+    bool crc16(); // frames carry a crc16, once init has agreed on it (links without error correction)
 
     // utility methods
     static int serialize(Chirp *chirp, uint8_t *buf, uint32_t bufSize, ...);
@@ -226,9 +300,18 @@ public:
     static int vserialize(Chirp *chirp, uint8_t *buf, uint32_t bufSize, va_list *args);
     static int vdeserialize(uint8_t *buf, uint32_t len, va_list *args);
     static int getArgList(uint8_t *buf, uint32_t len, uint8_t *argList);
+    static int deserializeParse(uint8_t *buf, uint32_t len, void *args[]);
     int useBuffer(uint8_t *buf, uint32_t len);
+    // Chirps are received into pooled buffers.  holdBuffer() takes a reference to the one
+    // ptr points into (an arg of the chirp just received, or without ptr, whatever is in
+    // the receive buffer), which keeps it and every pointer into it good past the next
+    // receive, until ChirpBuffer::release().  Chirp receives into another buffer from the
+    // pool in the meantime.  Returns NULL if ptr isn't in the receive buffer, or the link
+    // is shared memory.  Hold and release from the thread that services chirp.
+    ChirpBuffer *holdBuffer(const void *ptr=NULL);
 
     static uint16_t calcCrc(uint8_t *buf, uint32_t len);
+    static uint16_t calcCrc16(const uint8_t *buf, uint32_t len, uint16_t crc=0xffff);
 
 protected:
     int remoteInit(bool connect);
@@ -263,27 +346,72 @@ private:
     int recvFull(uint8_t *type, ChirpProc *proc, bool wait);
     int recvData();
     int recvAck(bool *ack, uint16_t timeout); // false=nack
+    void flushLink();
     int32_t handleEnumerate(char *procName, ChirpProc *callback);
-    int32_t handleInit(uint16_t *blkSize, uint8_t *hintSource);
+    int32_t handleInit(uint16_t *blkSize, uint8_t *hintSource, uint32_t *flags);
+    uint16_t frameCrc(const uint8_t *buf, uint32_t len, uint16_t crc);
+    uint16_t frameCrcSeed();
     int32_t handleEnumerateInfo(ChirpProc *proc);
+    int32_t handleEnumerateAll();
+    int32_t handleBatch(uint32_t *len, uint8_t *calls);
+    int32_t callProc(ProcPtr ptr, void *args[]);
     int vassemble(va_list *args);
-    static int deserializeParse(uint8_t *buf, uint32_t len, void *args[]);
     static int loadArgs(va_list *args, void *recvArgs[]);
     void restoreBuffer();
+    uint8_t nextTag();
+    ChirpPending *findPending(uint8_t tag);
+    int storeResponse(ChirpPending *pending, uint8_t *buf, uint32_t len);
+    void freePending(ChirpPending *pending);
 
     ChirpProc updateTable(const char *procName, ProcPtr procPtr);
     ChirpProc lookupTable(const char *procName);
+    ChirpProc lookupTable(const char *procName, uint32_t hash);
+    void indexTable(ChirpProc proc);
     int realloc(uint32_t min=0);
     int reallocTable();
+    int ownBuffer();
+    ChirpBuffer *getBuffer(uint32_t size);
+    void putBuffer(ChirpBuffer *buf);
+    void freeBuffers();
 
     Link *m_link;
     ProcTableEntry *m_procTable;
     uint16_t m_procTableSize;
+    uint16_t m_procTableLen; // entries in use, they're never removed
+    uint16_t *m_procIndex; // open addressing hash of m_procTable, index+1 (0 is empty)
+    uint16_t m_procIndexSize; // power of 2, at least twice m_procTableSize
+    char *m_remoteProcTable; // remote procedure names, '\0'-separated, in index order
+    uint32_t m_remoteProcTableLen;
     uint16_t m_blkSize;
     uint8_t m_maxNak;
     uint8_t m_retries;
     bool m_call;
     bool m_connected;
+
+    bool m_tagged; // remote echoes our tags in its responses
+    bool m_crc16; // frames carry a crc16 rather than the sum
+    bool m_crc16Agreed; // init agreed on crc16, either checksum may be in use
+    uint32_t m_firstLen; // first transfer of a chirp, header and as much data as fits
+    uint32_t m_firstLenNext; // first transfer length once the init response is out
+    uint8_t m_sendTag;
+    uint8_t m_recvTag;
+    uint8_t m_lastTag;
+    uint8_t m_asyncTag; // m_lastTag if that call was ASYNC and nobody has its response yet
+    uint8_t m_nextTag;
+    ChirpPending *m_pending;
+    uint8_t *m_response; // last response handed out by getResponse(), its arrays point here
+    uint8_t *m_batch; // calls added since batchBegin(), see handleBatch() for the layout
+    uint32_t m_batchLen;
+    uint32_t m_batchSize;
+    uint8_t *m_batchResponse; // responses to the last batchCall()
+    uint32_t m_batchResponseLen;
+
+    ChirpBuffer *m_recvBuf; // what m_buf points into, NULL with shared memory
+    ChirpBuffer *m_pool; // free buffers, for when m_recvBuf is held
+    ChirpBuffer *m_held; // buffers only others hold now, orphaned when we go
+    uint8_t m_poolLen;
+
+    friend class ChirpBuffer;
 };
 
 #endif // CHIRP_H
@@ -0,0 +1,253 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef CHIRPTYPED_HPP
+#define CHIRPTYPED_HPP
+
+#include <string.h>
+#include <tuple>
+#include <type_traits>
+#include "chirp.hpp"
+
+// Typed chirp calls.  Arguments are plain C++ values rather than CRP_ type codes
+// followed by values and END, so the type codes and the wire layout come from the
+// compiler, and a response that doesn't match what the caller expects is a
+// CRP_RES_ERROR_PARSE instead of a bad pointer.  The bytes on the wire are the same
+// as Chirp::vserialize()'s, so the two can be mixed freely:
+//
+//     int32_t response;
+//     res = chirp::call(chirp, proc, std::make_tuple((uint8_t)channel, (uint16_t)pos), &response);
+//
+// is the same call as
+//
+//     res = chirp->callSync(proc, UINT8(channel), UINT16(pos), END_OUT_ARGS, &response, END_IN_ARGS);
+//
+// Arrays go out as chirp::Array(len, data).  Coming back, an Array gets the length
+// and a pointer into the receive buffer (good until the next call), as does a
+// const char * for strings.  Hints aren't supported.
+
+namespace chirp
+{
+
+template <typename T> struct Array
+{
+    Array(uint32_t len=0, T *data=NULL) : len(len), data(data) {}
+    uint32_t len;
+    T *data;
+};
+
+template <typename T> Array<T> makeArray(uint32_t len, T *data)
+{
+    return Array<T>(len, data);
+}
+
+// type code and alignment of each C++ type, there's none for types chirp can't send
+template <typename T> struct Type;
+template <> struct Type<int8_t>   { enum {code=CRP_INT8,  size=1, scalar=1}; };
+template <> struct Type<uint8_t>  { enum {code=CRP_UINT8, size=1, scalar=1}; };
+template <> struct Type<int16_t>  { enum {code=CRP_INT16, size=2, scalar=1}; };
+template <> struct Type<uint16_t> { enum {code=CRP_UINT16, size=2, scalar=1}; };
+template <> struct Type<int32_t>  { enum {code=CRP_INT32, size=4, scalar=1}; };
+template <> struct Type<uint32_t> { enum {code=CRP_UINT32, size=4, scalar=1}; };
+template <> struct Type<float>    { enum {code=CRP_FLT32, size=4, scalar=1}; };
+template <> struct Type<const char *> { enum {code=CRP_STRING, size=1, scalar=0}; };
+template <> struct Type<char *> : Type<const char *> {};
+template <typename T> struct Type<Array<T> >
+{
+    typedef typename std::remove_const<T>::type Element;
+    enum {code=Type<Element>::code|CRP_ARRAY, size=Type<Element>::size, scalar=0};
+};
+
+constexpr uint32_t align(uint32_t i, uint32_t n)
+{
+    return i&(n-1) ? (i&~(n-1))+n : i;
+}
+
+// Where an argument list ends, counting from a 4-byte aligned start (the header
+// length always is).  All-scalar lists are laid out entirely at compile time;
+// fixed is 0 once there's a string or array.
+template <uint32_t I, typename... Args> struct Layout
+{
+    enum {fixed=1, size=I};
+};
+template <uint32_t I, typename T, typename... Rest> struct Layout<I, T, Rest...>
+{
+    typedef Layout<align(I+1, Type<T>::size)+Type<T>::size, Rest...> Next;
+    enum {fixed=Type<T>::scalar && Next::fixed, size=Next::size};
+};
+
+// runtime extent, for lists with strings or arrays
+template <typename T> inline uint32_t extent(uint32_t i, T)
+{
+    return align(i+1, sizeof(T))+sizeof(T);
+}
+inline uint32_t extent(uint32_t i, const char *s)
+{
+    return i+1+strlen(s)+1;
+}
+inline uint32_t extent(uint32_t i, char *s)
+{
+    return extent(i, (const char *)s);
+}
+template <typename T> inline uint32_t extent(uint32_t i, Array<T> a)
+{
+    return align(i+1, 4)+4+a.len*Type<Array<T> >::size;
+}
+
+inline uint32_t extentAll(uint32_t i)
+{
+    return i;
+}
+template <typename T, typename... Rest> inline uint32_t extentAll(uint32_t i, T arg, Rest... rest)
+{
+    return extentAll(extent(i, arg), rest...);
+}
+
+// Each put() writes the type code and the value at i and returns the index after
+// it.  Like vserialize(), the type code goes at i, where the receiver parses it,
+// and again right in front of the value after any padding, for getType().
+template <typename T> inline uint32_t put(uint8_t *buf, uint32_t i, T val)
+{
+    buf[i] = Type<T>::code;
+    i = align(i+1, sizeof(T));
+    buf[i-1] = Type<T>::code;
+    memcpy(buf+i, &val, sizeof(T));
+    return i+sizeof(T);
+}
+inline uint32_t put(uint8_t *buf, uint32_t i, const char *s)
+{
+    uint32_t len = strlen(s)+1;
+
+    buf[i++] = CRP_STRING;
+    memcpy(buf+i, s, len);
+    return i+len;
+}
+inline uint32_t put(uint8_t *buf, uint32_t i, char *s)
+{
+    return put(buf, i, (const char *)s);
+}
+template <typename T> inline uint32_t put(uint8_t *buf, uint32_t i, Array<T> a)
+{
+    buf[i] = Type<Array<T> >::code;
+    i = align(i+1, 4);
+    buf[i-1] = Type<Array<T> >::code;
+    memcpy(buf+i, &a.len, 4);
+    i += 4;
+    memcpy(buf+i, a.data, a.len*Type<Array<T> >::size);
+    return i+a.len*Type<Array<T> >::size;
+}
+
+inline uint32_t putAll(uint8_t *buf, uint32_t i)
+{
+    return i;
+}
+template <typename T, typename... Rest> inline uint32_t putAll(uint8_t *buf, uint32_t i, T arg, Rest... rest)
+{
+    return putAll(buf, put(buf, i, arg), rest...);
+}
+
+// Each get() checks the type of the value at args[i] and copies it out.  Arrays
+// take two entries in args, the length and then the data.
+template <typename T> inline int get(void *args[], int i, T *val)
+{
+    if (args[i]==NULL || (Chirp::getType(args[i])&~CRP_HINT)!=Type<T>::code)
+        return CRP_RES_ERROR_PARSE;
+    memcpy(val, args[i], sizeof(T));
+    return i+1;
+}
+inline int get(void *args[], int i, const char **s)
+{
+    if (args[i]==NULL || (Chirp::getType(args[i])&~CRP_HINT)!=CRP_STRING)
+        return CRP_RES_ERROR_PARSE;
+    *s = (const char *)args[i];
+    return i+1;
+}
+template <typename T> inline int get(void *args[], int i, Array<T> *a)
+{
+    if (args[i]==NULL || args[i+1]==NULL || (Chirp::getType(args[i])&~CRP_HINT)!=Type<Array<T> >::code)
+        return CRP_RES_ERROR_PARSE;
+    memcpy(&a->len, args[i], 4);
+    a->data = (T *)args[i+1];
+    return i+2;
+}
+
+inline int getAll(void *args[], int i)
+{
+    // the response has to have exactly as many values as the caller asked for
+    return args[i]==NULL ? CRP_RES_OK : CRP_RES_ERROR_PARSE;
+}
+template <typename T, typename... Rest> inline int getAll(void *args[], int i, T *val, Rest *... rest)
+{
+    if ((i=get(args, i, val))<0)
+        return i;
+    return getAll(args, i, rest...);
+}
+
+// unpacking a tuple into an argument list
+template <size_t... I> struct Indices {};
+template <size_t N, size_t... I> struct MakeIndices : MakeIndices<N-1, N-1, I...> {};
+template <size_t... I> struct MakeIndices<0, I...>
+{
+    typedef Indices<I...> Type;
+};
+
+template <typename... Out, size_t... I> inline int assemble(Chirp *chirp, const std::tuple<Out...> &out, Indices<I...>)
+{
+    typedef Layout<0, Out...> L;
+    uint8_t *buf;
+    uint32_t len;
+
+    len = L::fixed ? (uint32_t)L::size : extentAll(0, std::get<I>(out)...);
+    if ((buf=chirp->argBuffer(len))==NULL)
+        return CRP_RES_ERROR_MEMORY;
+    return putAll(buf, 0, std::get<I>(out)...);
+}
+
+template <typename... Out> inline int assemble(Chirp *chirp, const std::tuple<Out...> &out)
+{
+    return assemble(chirp, out, typename MakeIndices<sizeof...(Out)>::Type());
+}
+
+// Call proc with the values in out and wait for the response, which is copied into
+// in-- the first is the response int.
+template <typename... Out, typename... In>
+int call(Chirp *chirp, ChirpProc proc, const std::tuple<Out...> &out, In *... in)
+{
+    int res;
+    void *recvArgs[CRP_MAX_ARGS+1];
+
+    if ((res=assemble(chirp, out))<0)
+        return res;
+    if ((res=chirp->sendArgs(SYNC, proc, res, recvArgs))<0)
+        return res;
+    res = getAll(recvArgs, 0, in...);
+
+    return res<0 ? res : CRP_RES_OK;
+}
+
+// Call proc without waiting for the response, as Chirp::call(ASYNC...) does.
+template <typename... Out>
+int send(Chirp *chirp, ChirpProc proc, const std::tuple<Out...> &out)
+{
+    int res;
+
+    if ((res=assemble(chirp, out))<0)
+        return res;
+    return chirp->sendArgs(ASYNC, proc, res, NULL);
+}
+
+}
+
+#endif // CHIRPTYPED_HPP
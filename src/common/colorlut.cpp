@@ -14,10 +14,12 @@
 //
 
 #ifndef PIXY
+#ifdef MATLAB
 #include <QString>
 #include <QFile>
 #include <QTextStream>
 #endif
+#endif
 #include <stdlib.h>
 #include <math.h>
 #include "colorlut.h"
@@ -63,7 +65,13 @@ float distance(Fpoint a, Fpoint b)
     diffx = a.m_x-b.m_x;
     diffy = a.m_y-b.m_y;
 
+#ifdef FIXED_MATH
+    // u and v are -128..127, so Q7 differences squared still fit
+    int32_t dx = diffx*128, dy = diffy*128;
+    return fm_isqrt(dx*dx + dy*dy)/128.0f;
+#else
     return sqrt(diffx*diffx + diffy*diffy);
+#endif
 }
 
 
@@ -91,7 +99,7 @@ ColorLUT::~ColorLUT()
 int ColorLUT::generate(ColorModel *model, const Frame8 &frame, const RectA &region)
 {
     Fpoint meanVal;
-    float angle, pangle, pslope, meanSat;
+    float pslope, pcos, meanSat;
     float yi, istep, s, xsat, sat;
     int result;
 
@@ -103,6 +111,22 @@ int ColorLUT::generate(ColorModel *model, const Frame8 &frame, const RectA &regi
 
     map(frame, region);
     mean(&meanVal);
+#ifdef FIXED_MATH
+    int32_t sine, cosine;
+    fm_sincos(fm_atan2(FM_Q16(meanVal.m_y), FM_Q16(meanVal.m_x)), &sine, &cosine);
+    // tweakMean() keeps the mean off the axes, but not always by 1/65536 of a radian
+    if (sine==0)
+        sine = meanVal.m_y<0.0f ? -1 : 1;
+    if (cosine==0)
+        cosine = meanVal.m_x<0.0f ? -1 : 1;
+    Fpoint uvec((float)cosine/FM_ONE, (float)sine/FM_ONE);
+
+    Line hueLine((float)sine/cosine, 0.0);
+
+    pslope = -(float)cosine/sine; // perpendicular slope
+    pcos = -uvec.m_y; // cos(angle + PI/2)
+#else
+    float angle, pangle;
     angle = atan2(meanVal.m_y, meanVal.m_x);
     Fpoint uvec(cos(angle), sin(angle));
 
@@ -110,6 +134,8 @@ int ColorLUT::generate(ColorModel *model, const Frame8 &frame, const RectA &regi
 
     pangle = angle + PI/2; // perpendicular angle
     pslope = tan(pangle); // perpendicular slope
+    pcos = cos(pangle);
+#endif
     Line pLine(pslope, meanVal.m_y - pslope*meanVal.m_x); // perpendicular line through mean
 
     // upper hue line
@@ -127,7 +153,7 @@ int ColorLUT::generate(ColorModel *model, const Frame8 &frame, const RectA &regi
 
     // inner sat line
     s = sign(uvec.m_y);
-    istep = s*fabs(m_iterateStep/cos(pangle));
+    istep = s*fabs(m_iterateStep/pcos);
     yi = iterate(pLine, -istep);
     yi -= s*fabs(m_satTol*(yi-pLine.m_yi)); // extend
     xsat = yi/(hueLine.m_slope-pslope); // x value where inner sat line crosses hue line
@@ -172,8 +198,8 @@ int ColorLUT::generate(ColorModel *model, const Frame8 &frame, const RectA &regi
 
 void ColorLUT::map(const Frame8 &frame, const RectA &region)
 {
-    uint32_t x, y, r, g1, g2, b, count;
-    int32_t u, v;
+    uint32_t y, r, g1, g2, b, count;
+    int32_t x, u, v; // signed, pixel indexes below can be negative
     uint8_t *pixels;
 
     pixels = frame.m_pixels + (region.m_yOffset | 1)*frame.m_width + (region.m_xOffset | 1);
@@ -232,8 +258,20 @@ void ColorLUT::mean(Fpoint *mean)
 uint32_t ColorLUT::boundTest(const Line *line, float dir)
 {
     uint32_t i, count;
-    float v;
     bool gtz = dir>0.0f;
+#ifdef FIXED_MATH
+    FmLine fline;
+    int32_t side;
+
+    fm_line(&fline, line->m_slope, line->m_yi);
+    for (i=0, count=0; i<m_hpixelLen; i++)
+    {
+        side = fm_side(&fline, m_hpixels[i].m_u, m_hpixels[i].m_v);
+        if (gtz ? side>0 : side<0)
+            count++;
+    }
+#else
+    float v;
 
     for (i=0, count=0; i<m_hpixelLen; i++)
     {
@@ -246,6 +284,7 @@ uint32_t ColorLUT::boundTest(const Line *line, float dir)
         else if (m_hpixels[i].m_v>v)
             count++;
     }
+#endif
 
     return count;
 }
@@ -279,6 +318,9 @@ void ColorLUT::add(const ColorModel *model, uint8_t modelIndex)
 {
     uint32_t i;
     HuePixel p;
+#ifdef FIXED_MATH
+    FmLine lines[4];
+#endif
 
 #ifndef PIXY
 #ifdef MATLAB
@@ -292,12 +334,23 @@ void ColorLUT::add(const ColorModel *model, uint8_t modelIndex)
     if (model->m_hue[0].m_slope==0.0f)
         return;
 
+#ifdef FIXED_MATH
+    // once here rather than 4 times for each of the 65536 entries
+    fm_line(&lines[0], model->m_hue[0].m_slope, model->m_hue[0].m_yi);
+    fm_line(&lines[1], model->m_hue[1].m_slope, model->m_hue[1].m_yi);
+    fm_line(&lines[2], model->m_sat[0].m_slope, model->m_sat[0].m_yi);
+    fm_line(&lines[3], model->m_sat[1].m_slope, model->m_sat[1].m_yi);
+#endif
     for (i=0; i<CL_LUT_SIZE; i++)
     {
         p.m_v = (int8_t)(i&0xff);
         p.m_u = (int8_t)(i>>8);
         if (((m_lut[i]&0x07)==0 || (m_lut[i]&0x07)>=modelIndex) &&
+#ifdef FIXED_MATH
+                checkBounds(lines, &p))
+#else
                 checkBounds(model, &p))
+#endif
             m_lut[i] = modelIndex;
     }
 
@@ -335,6 +388,23 @@ bool ColorLUT::checkBounds(const ColorModel *model, const HuePixel *pixel)
     return true;
 }
 
+#ifdef FIXED_MATH
+// the same tests, lines as fm_line() makes them, which are positive below
+bool ColorLUT::checkBounds(const FmLine lines[4], const HuePixel *pixel)
+{
+    if (fm_side(&lines[0], pixel->m_u, pixel->m_v)<0)
+        return false;
+    if (fm_side(&lines[1], pixel->m_u, pixel->m_v)>0)
+        return false;
+    if (fm_side(&lines[2], pixel->m_u, pixel->m_v)<0)
+        return false;
+    if (fm_side(&lines[3], pixel->m_u, pixel->m_v)>0)
+        return false;
+
+    return true;
+}
+#endif
+
 void ColorLUT::clear(uint8_t modelIndex)
 {
     uint32_t i;
@@ -481,6 +551,7 @@ int ColorLUT::growRegion(RectA *result, const Frame8 &frame, const Point16 &seed
 }
 
 #ifndef PIXY
+#ifdef MATLAB
 void ColorLUT::matlabOut(const ColorModel *model, uint8_t index)
 {
     unsigned int i;
@@ -529,4 +600,5 @@ void ColorLUT::matlabOut()
     file.close();
 }
 #endif
+#endif
 
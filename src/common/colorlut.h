@@ -17,6 +17,7 @@
 
 #include <inttypes.h>
 #include "pixytypes.h"
+#include "fixmath.h"
 
 #undef PI
 #define PI 3.1415926f
@@ -69,10 +70,15 @@ private:
     void tweakMean(float *mean);
     uint32_t boundTest(const Line *line, float dir);
     bool checkBounds(const ColorModel *model, const HuePixel *pixel);
+#ifdef FIXED_MATH
+    bool checkBounds(const FmLine lines[4], const HuePixel *pixel);
+#endif
 
 #ifndef PIXY
+#ifdef MATLAB
     void matlabOut(const ColorModel *model, uint8_t index);
     void matlabOut();
+#endif
 #endif
 
     uint8_t *m_lut;
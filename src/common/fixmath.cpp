@@ -0,0 +1,198 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <stdlib.h>
+#include "fixmath.h"
+
+// CORDIC works in Q29, which keeps the last steps meaningful, and hands back Q16
+#define FM_SHIFT            13 // Q29 to Q16
+#define FM_PI_Q29           1686629713
+#define FM_HALF_PI_Q29      843314857
+#define FM_GAIN_Q29         326016437 // 1/(the CORDIC gain)
+#define FM_LINE_ONE         (1<<20) // Q20 for lines
+#define FM_LINE_MAX_C       (512*FM_LINE_ONE) // well outside -128..127 either way
+
+// atan(2^-i) in Q29
+static const int32_t g_atan[FM_CORDIC_STEPS] =
+{
+    421657428, 248918915, 131521918, 66762579, 33510843, 16771758, 8387925, 4194219,
+    2097141, 1048575, 524288, 262144, 131072, 65536, 32768, 16384,
+    8192, 4096, 2048, 1024, 512, 256, 128, 64,
+    32, 16, 8, 4
+};
+
+// v, or -v if neg is -1.  CORDIC's turns go either way about half the time, which
+// branches predict badly.
+static inline int32_t flip(int32_t v, int32_t neg)
+{
+    return (v^neg) - neg;
+}
+
+static inline int32_t toQ16(int32_t q29)
+{
+    return (q29 + (1<<(FM_SHIFT-1)))>>FM_SHIFT;
+}
+
+// in Q29, so fm_atan2Deg() can round once
+static int32_t atan2Q29(int32_t y, int32_t x)
+{
+    int32_t offset, angle, xn, m, neg, i, shift=0;
+
+    // the ones that come up all the time, exactly
+    if (y==0)
+        return x<0 ? FM_PI_Q29 : 0;
+    if (x==0)
+        return y>0 ? FM_HALF_PI_Q29 : -FM_HALF_PI_Q29;
+
+    // CORDIC only gets as far as 99 degrees, so turn the left half plane around
+    offset = 0;
+    if (x<0)
+    {
+        x = -x;
+        y = -y;
+        offset = y<0 ? FM_PI_Q29 : -FM_PI_Q29;
+    }
+    if (x==y || x==-y)
+        return offset + (y>0 ? FM_HALF_PI_Q29/2 : -FM_HALF_PI_Q29/2);
+
+    // as big as they can be without overflowing, for precision.  Centroid
+    // differences are small, so get most of the way a byte at a time.
+    m = x | abs(y);
+    while (m>=(1<<29))
+    {
+        m >>= 1;
+        shift--;
+    }
+    while (m<(1<<20))
+    {
+        m <<= 8;
+        shift += 8;
+    }
+    while (m<(1<<28))
+    {
+        m <<= 1;
+        shift++;
+    }
+    if (shift<0)
+    {
+        x >>= -shift;
+        y >>= -shift;
+    }
+    else
+    {
+        x <<= shift;
+        y <<= shift;
+    }
+
+    // rotate (x, y) onto the x axis, adding up how far
+    for (i=0, angle=0; i<FM_CORDIC_STEPS; i++)
+    {
+        neg = -(y<=0); // turn clockwise if above the axis
+        xn = x + flip(y>>i, neg);
+        y -= flip(x>>i, neg);
+        angle += flip(g_atan[i], neg);
+        x = xn;
+    }
+
+    return angle + offset;
+}
+
+int32_t fm_atan2(int32_t y, int32_t x)
+{
+    return toQ16(atan2Q29(y, x));
+}
+
+int16_t fm_atan2Deg(int32_t y, int32_t x)
+{
+    // 3.1415 in Q29 is 1686579970
+    return (int64_t)atan2Q29(y, x)*180/1686579970;
+}
+
+void fm_sincos(int32_t angle, int32_t *sin, int32_t *cos)
+{
+    int32_t x, y, xn, z, neg, i;
+    bool negate = false;
+
+    // into -pi..pi, then -pi/2..pi/2, where CORDIC converges
+    if (angle>FM_PI)
+        angle -= 2*FM_PI;
+    else if (angle<-FM_PI)
+        angle += 2*FM_PI;
+    if (angle>FM_PI/2)
+    {
+        angle -= FM_PI;
+        negate = true;
+    }
+    else if (angle<-FM_PI/2)
+    {
+        angle += FM_PI;
+        negate = true;
+    }
+
+    // rotate (1/gain, 0) by angle
+    x = FM_GAIN_Q29;
+    y = 0;
+    z = angle<<FM_SHIFT;
+    for (i=0; i<FM_CORDIC_STEPS; i++)
+    {
+        neg = -(z<=0); // counterclockwise while there's angle left
+        xn = x - flip(y>>i, neg);
+        y += flip(x>>i, neg);
+        z -= flip(g_atan[i], neg);
+        x = xn;
+    }
+
+    *cos = toQ16(negate ? -x : x);
+    *sin = toQ16(negate ? -y : y);
+}
+
+uint16_t fm_isqrt(uint32_t x)
+{
+    uint32_t res = 0, bit = 1u<<30;
+
+    while (bit>x)
+        bit >>= 2;
+    while (bit)
+    {
+        if (x>=res+bit)
+        {
+            x -= res+bit;
+            res = (res>>1) + bit;
+        }
+        else
+            res >>= 1;
+        bit >>= 2;
+    }
+
+    return res;
+}
+
+void fm_line(FmLine *line, float slope, float yi)
+{
+    float n, c;
+
+    n = slope<0.0f ? -slope : slope;
+    if (n<1.0f)
+        n = 1.0f;
+    c = yi/n*FM_LINE_ONE;
+    if (c>FM_LINE_MAX_C)
+        c = FM_LINE_MAX_C;
+    else if (c<-FM_LINE_MAX_C)
+        c = -FM_LINE_MAX_C;
+
+    line->a = (int32_t)(slope/n*FM_LINE_ONE);
+    line->b = (int32_t)(-1.0f/n*FM_LINE_ONE);
+    line->c = (int32_t)c;
+}
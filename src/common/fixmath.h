@@ -0,0 +1,62 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+#ifndef FIXMATH_H
+#define FIXMATH_H
+
+#include <stdint.h>
+
+// Fixed-point versions of the math Blobs and ColorLUT do with libm: atan2, sin
+// and cos by CORDIC, square roots, and which side of a line a point is on.
+// They give the same answers on Pixy and on the host, where libm's don't, and
+// they keep Pixy, whose FPU only does single precision, out of libm's software
+// routines.  Blobs and ColorLUT use them when FIXED_MATH is defined.
+// fixmathbench checks them against libm.
+//
+// Angles are radians in Q16 (65536 is 1 radian), -FM_PI to FM_PI.
+
+#define FM_ONE              65536 // 1.0 in Q16
+#define FM_PI               205887 // pi in Q16
+#define FM_Q16(f)           ((int32_t)((f)*FM_ONE))
+#define FM_CORDIC_STEPS     28 // each one is another bit
+
+// atan2(y, x) for |x|, |y| below 2^30, 0 if both are 0
+int32_t fm_atan2(int32_t y, int32_t x);
+// atan2(y, x) in whole degrees, truncated, for Blobs::angle().  Like the float
+// version it divides by 3.1415 rather than pi, which keeps exact multiples of 45
+// degrees from coming out one less.
+int16_t fm_atan2Deg(int32_t y, int32_t x);
+// sin and cos in Q16, any angle from -2*FM_PI to 2*FM_PI
+void fm_sincos(int32_t angle, int32_t *sin, int32_t *cos);
+// floor(sqrt(x))
+uint16_t fm_isqrt(uint32_t x);
+
+// The line y = slope*x + yi, to test integer points (in -128..127, u and v) against.
+// It's a*x + b*y + c in Q20 where the float version has slope*x + yi - y, scaled
+// down by |slope| when the line's steep so it doesn't overflow.  The sign is the
+// same, positive below the line.  c is clipped to what still gets it right.
+struct FmLine
+{
+    int32_t a;
+    int32_t b;
+    int32_t c;
+};
+
+void fm_line(FmLine *line, float slope, float yi);
+static inline int32_t fm_side(const FmLine *line, int32_t x, int32_t y)
+{
+    return line->a*x + line->b*y + line->c;
+}
+
+#endif // FIXMATH_H
@@ -0,0 +1,125 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <string.h>
+#include "perf.h"
+
+#ifdef PIXY
+
+#include "chirp.hpp"
+
+PerfStats g_perfStages[PERF_STAGES];
+uint32_t g_perfCounters[PERF_COUNTERS];
+
+const char *g_perfStageNames[PERF_STAGES] =
+{
+    "frame", "grab", "unpack", "assemble", "combine", "cc", "usb", "serial"
+};
+
+const char *g_perfCounterNames[PERF_COUNTERS] =
+{
+    "segments", "blobs", "heapfull", "dropped", "windowed", "tracklost"
+};
+
+#define PERF_STATS_WORDS    (4+PERF_HIST_BUCKETS) // per stage, see perf_get
+
+static int32_t perf_get(const uint8_t &reset, Chirp *chirp);
+
+static const ProcModule g_module[] =
+{
+    {
+    "perf_get",
+    (ProcPtr)perf_get,
+    {CRP_UINT8, END},
+    "Get the time spent in each stage of a frame, and the counters"
+    "@p reset 1 to start over after this, 0 to keep counting"
+    "@r 0, followed by PRF1 data: ticks per us, stage names, then count, min, avg, max "
+    "and histogram (under 16us, 64us, ... x4 each) per stage in ticks, counter names and counters"
+    },
+    END
+};
+
+int perf_init(Chirp *chirp)
+{
+    perf_reset();
+    chirp->registerModule(g_module);
+
+    return 0;
+}
+
+void perf_reset()
+{
+    uint32_t i;
+
+    memset((void *)g_perfStages, 0, sizeof(g_perfStages));
+    memset((void *)g_perfCounters, 0, sizeof(g_perfCounters));
+    for (i=0; i<PERF_STAGES; i++)
+        g_perfStages[i].min = 0xffffffff;
+}
+
+void perf_add(uint8_t stage, uint32_t ticks)
+{
+    PerfStats *stats = g_perfStages + stage;
+    uint32_t us, bucket;
+
+    stats->count++;
+    stats->sum += ticks;
+    if (ticks<stats->min)
+        stats->min = ticks;
+    if (ticks>stats->max)
+        stats->max = ticks;
+    for (us=ticks/CTIMER_TICKS_PER_US, bucket=0; us>=16 && bucket<PERF_HIST_BUCKETS-1; us>>=2, bucket++);
+    stats->hist[bucket]++;
+}
+
+// names go out as one string each, space separated
+static const char *join(char *buf, const char **names, uint32_t n)
+{
+    uint32_t i;
+
+    for (i=0, buf[0]='\0'; i<n; i++)
+    {
+        if (i)
+            strcat(buf, " ");
+        strcat(buf, names[i]);
+    }
+    return buf;
+}
+
+static int32_t perf_get(const uint8_t &reset, Chirp *chirp)
+{
+    static uint32_t stats[PERF_STAGES*PERF_STATS_WORDS];
+    char stageNames[PERF_STAGES*10], counterNames[PERF_COUNTERS*10];
+    uint32_t i, j, *s;
+
+    for (i=0, s=stats; i<PERF_STAGES; i++, s+=PERF_STATS_WORDS)
+    {
+        s[0] = g_perfStages[i].count;
+        s[1] = g_perfStages[i].count ? g_perfStages[i].min : 0;
+        s[2] = g_perfStages[i].count ? g_perfStages[i].sum/g_perfStages[i].count : 0;
+        s[3] = g_perfStages[i].max;
+        for (j=0; j<PERF_HIST_BUCKETS; j++)
+            s[4+j] = g_perfStages[i].hist[j];
+    }
+    CRP_RETURN(chirp, HTYPE(FOURCC('P','R','F','1')), UINT32(CTIMER_TICKS_PER_US),
+               STRING(join(stageNames, g_perfStageNames, PERF_STAGES)), UINTS32(sizeof(stats)/sizeof(uint32_t), stats),
+               STRING(join(counterNames, g_perfCounterNames, PERF_COUNTERS)), UINTS32(PERF_COUNTERS, g_perfCounters), END);
+    if (reset)
+        perf_reset();
+
+    return 0;
+}
+
+#endif
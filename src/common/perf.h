@@ -0,0 +1,93 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef _PERF_H
+#define _PERF_H
+
+#include <inttypes.h>
+
+// Timing probes around the stages a frame goes through on the M4, and a few
+// counters, for perf_get.  On Pixy a probe is a read of TIMER1, so they stay in.
+// Elsewhere (PixyMon's copy of Blobs) they compile to nothing.
+
+#define PERF_HIST_BUCKETS   8 // under 16us, 64us, 256us... (x4 each), the last is the rest
+
+enum PerfStage
+{
+    PERF_FRAME,     // a frame's trip through the blobs program's loop
+    PERF_GRAB,      // waiting on the M0 for Qvals, it grabs and segments as the frame comes in
+    PERF_UNPACK,    // Qvals into segments, into the blob assemblers
+    PERF_ASSEMBLE,  // finishing the assemblers' blobs
+    PERF_COMBINE,   // copying, combining and compressing blobs
+    PERF_CC,        // color codes
+    PERF_USB,       // sending blobs to PixyMon
+    PERF_SERIAL,    // the serial port's callback, in the ISR
+    PERF_STAGES
+};
+
+enum PerfCounter
+{
+    PERF_SEGMENTS,  // added to the assemblers
+    PERF_BLOBS,     // found, color code blobs included
+    PERF_HEAP_FULL, // frames where an assembler ran out of memory
+    PERF_DROPPED,   // Qvals thrown away after that
+    PERF_WINDOWED,  // frames segmented in a tracking window
+    PERF_TRACK_LOST, // times the tracked target went missing from its window
+    PERF_COUNTERS
+};
+
+struct PerfStats
+{
+    uint32_t count;
+    uint32_t min; // ticks
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PERF_HIST_BUCKETS];
+};
+
+#ifdef PIXY
+
+#include "cycletimer.h"
+
+#define PERF_DECLARE(t)         uint32_t t = 0
+#define PERF_START(t)           t = CTIMER_TICKS()
+#define PERF_STOP(stage, t)     perf_add(stage, CTIMER_TICKS()-(t))
+#define PERF_LAP(t, total)      total += CTIMER_TICKS()-(t) // for a stage that comes and goes
+#define PERF_ADD(stage, ticks)  perf_add(stage, ticks)
+#define PERF_COUNT(counter, n)  g_perfCounters[counter] += n
+
+class Chirp;
+
+int perf_init(Chirp *chirp);
+void perf_add(uint8_t stage, uint32_t ticks);
+void perf_reset();
+
+extern PerfStats g_perfStages[PERF_STAGES];
+extern uint32_t g_perfCounters[PERF_COUNTERS];
+extern const char *g_perfStageNames[PERF_STAGES];
+extern const char *g_perfCounterNames[PERF_COUNTERS];
+
+#else
+
+#define PERF_DECLARE(t)
+#define PERF_START(t)
+#define PERF_STOP(stage, t)
+#define PERF_LAP(t, total)
+#define PERF_ADD(stage, ticks)
+#define PERF_COUNT(counter, n)
+
+#endif
+
+#endif
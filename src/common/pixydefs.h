@@ -30,6 +30,7 @@
 #define PIXY_ERROR_INVALID_PARAMETER        -150
 #define PIXY_ERROR_CHIRP                    -151
 #define PIXY_ERROR_INVALID_COMMAND          -152
+#define PIXY_ERROR_SOCKET                   -153
 
 #ifndef END
 #ifdef __x86_64__
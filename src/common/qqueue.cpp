@@ -94,6 +94,11 @@ void Qqueue::flush()
 {
     uint16_t len = m_fields->produced - m_fields->consumed;
 
+    // the frames we threw away are done with, except the one the M0 may still be
+    // filling, which is released when it's unpacked
+    m_fields->released = m_fields->frames;
+    m_fields->windowCols = m_fields->windowRows = 0;
+
     m_fields->consumed += len;
     m_fields->readIndex += len;
     if (m_fields->readIndex>=QQ_MEM_SIZE)
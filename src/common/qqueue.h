@@ -23,6 +23,25 @@ struct QqueueFields;
 #define QQ_SIZE       0x3000
 #define QQ_MEM_SIZE  ((QQ_SIZE-sizeof(struct QqueueFields)+sizeof(Qval))/sizeof(Qval))
 
+// Frames are handed from the M0 to the M4 whole.  Each one ends with 0xffffffff,
+// the M0 counts the frames it has finished and the M4 counts the ones it's done
+// with.  There are two slots, the frame the M4 is working on and the one the M0 is
+// filling, so the M0 lets a frame go by rather than start a third.
+#define QQ_SLOTS      2
+
+// The M4 can ask for frames to be segmented in a window only, windowCols and
+// windowRows below, 0 for the whole frame.  The M0 starts each frame it segments
+// that way with the two, so the M4 knows what it's getting.  They're Qvals of
+// model 0, which no segment has: the window's first column or row and how many,
+// where a segment has its begin column and length.  Rows have bit 21 set.  Only
+// the window's rows are sent, segments in them can still go outside its columns.
+#define QQ_WINDOW_ROWS_FLAG      (1<<21)
+#define QQ_WINDOW_COLS(left, width)  ((Qval)(left)<<3 | (Qval)(width)<<12)
+#define QQ_WINDOW_ROWS(top, height)  ((Qval)(top)<<3 | (Qval)(height)<<12 | QQ_WINDOW_ROWS_FLAG)
+#define QQ_WINDOW_START(qval)    (((qval)>>3)&0x1ff)
+#define QQ_WINDOW_LEN(qval)      (((qval)>>12)&0x1ff)
+#define QQ_WINDOW_QVALS          2
+
 struct QqueueFields
 {
     uint16_t readIndex;
@@ -31,6 +50,14 @@ struct QqueueFields
     uint16_t produced;
     uint16_t consumed;
 
+    uint16_t frames; // finished by the M0
+    uint16_t released; // done with by the M4
+    uint16_t skipped; // let go by, no slot or no room
+    uint16_t truncated; // ended early, the queue filled up
+
+    Qval windowCols; // set by the M4 for the frames to come
+    Qval windowRows;
+
     // (array size below doesn't matter-- we're just going to cast a pointer to this struct)
     Qval data[1]; // data
 };
@@ -48,6 +75,23 @@ public:
 	{
 		return m_fields->produced - m_fields->consumed;
 	}
+    // after the frame's 0xffffffff has been dequeued and we're done with it
+    void releaseFrame()
+    {
+        m_fields->released++;
+    }
+    // the window frames are segmented in from the next one the M0 starts, width 0
+    // for whole frames, which flush() goes back to
+    void setWindow(uint16_t left, uint16_t top, uint16_t width, uint16_t height)
+    {
+        if (width==0 || height==0)
+            m_fields->windowCols = m_fields->windowRows = 0;
+        else
+        {
+            m_fields->windowCols = QQ_WINDOW_COLS(left, width);
+            m_fields->windowRows = QQ_WINDOW_ROWS(top, height);
+        }
+    }
 #ifndef PIXY
     int enqueue(Qval val);
 #endif
@@ -63,6 +107,8 @@ private:
 
 uint32_t qq_enqueue(Qval val);
 uint16_t qq_free(void);
+uint32_t qq_beginFrame(uint16_t room);
+void qq_endFrame(uint32_t complete);
 
 extern struct QqueueFields *g_qqueue;
 
@@ -0,0 +1,252 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <stdlib.h>
+#include "runfilter.h"
+
+RunFilter::RunFilter()
+{
+    m_minLength = 0;
+    m_maxGap = 0;
+    m_vertical = 0;
+    m_mem = NULL;
+    m_first = 0;
+    m_row = -1;
+    m_out = NULL;
+    m_outLen = 0;
+}
+
+RunFilter::~RunFilter()
+{
+    delete [] m_mem;
+}
+
+void RunFilter::setParams(uint8_t minLength, uint8_t maxGap, uint8_t vertical)
+{
+    int i;
+
+    m_minLength = minLength;
+    m_maxGap = maxGap;
+    m_vertical = vertical;
+    m_row = -1;
+    m_outLen = 0;
+
+    // the rows' memory, once it's needed
+    if (enabled() && m_mem==NULL)
+    {
+        m_mem = new SSegment[(RF_ROWS+RF_OUT_ROWS)*RF_MAX_ROW_SEGMENTS];
+        for (i=0; i<RF_ROWS; i++)
+        {
+            m_rows[i].len = 0;
+            m_rows[i].segs = m_mem + i*RF_MAX_ROW_SEGMENTS;
+        }
+        m_out = m_mem + RF_ROWS*RF_MAX_ROW_SEGMENTS;
+    }
+}
+
+// NULL if it's not a row of this frame, or hasn't come in yet
+RunRow *RunFilter::getRow(int16_t row)
+{
+    if (row<m_first || row>m_row)
+        return NULL;
+    return &m_rows[row%RF_ROWS];
+}
+
+void RunFilter::beginRow(int16_t row)
+{
+    if (m_row<0)
+        m_first = row;
+    else
+        finishRow(m_row);
+    m_row = row;
+    m_rows[row%RF_ROWS].len = 0;
+}
+
+void RunFilter::add(const SSegment &s)
+{
+    RunRow *row;
+
+    if (m_row<0)
+        return;
+    row = &m_rows[m_row%RF_ROWS];
+    if (row->len<RF_MAX_ROW_SEGMENTS)
+        row->segs[row->len++] = s;
+}
+
+void RunFilter::endFrame()
+{
+    if (m_row<0)
+        return;
+
+    finishRow(m_row);
+    // the last rows have nothing below them
+    if (m_vertical&RF_VERTICAL_CLOSE)
+    {
+        close(m_row);
+        closed(m_row);
+    }
+    if (m_vertical&RF_VERTICAL_OPEN)
+        open(m_row);
+    m_row = -1;
+}
+
+uint16_t RunFilter::take(SSegment **segs)
+{
+    uint16_t len = m_outLen;
+
+    *segs = m_out;
+    m_outLen = 0;
+    return len;
+}
+
+// row is all here, the row before it can be closed
+void RunFilter::finishRow(int16_t row)
+{
+    horizontal(getRow(row));
+    if (m_vertical&RF_VERTICAL_CLOSE)
+    {
+        if (row>m_first)
+        {
+            close(row-1);
+            closed(row-1);
+        }
+    }
+    else
+        closed(row);
+}
+
+// row is closed, the row before it can be opened
+void RunFilter::closed(int16_t row)
+{
+    if (m_vertical&RF_VERTICAL_OPEN)
+    {
+        if (row>m_first)
+            open(row-1);
+    }
+    else
+        output(getRow(row));
+}
+
+void RunFilter::horizontal(RunRow *row)
+{
+    uint16_t i, n;
+    int16_t last[8]; // each model's last run so far
+    SSegment *segs = row->segs;
+
+    if (m_maxGap)
+    {
+        for (i=0; i<8; i++)
+            last[i] = -1;
+        for (i=0, n=0; i<row->len; i++)
+        {
+            if (last[segs[i].model]>=0 &&
+                (int)segs[i].startCol - (int)segs[last[segs[i].model]].endCol <= m_maxGap)
+            {
+                if (segs[i].endCol>segs[last[segs[i].model]].endCol)
+                    segs[last[segs[i].model]].endCol = segs[i].endCol;
+            }
+            else
+            {
+                last[segs[i].model] = n;
+                segs[n++] = segs[i];
+            }
+        }
+        row->len = n;
+    }
+    if (m_minLength>1)
+    {
+        for (i=0, n=0; i<row->len; i++)
+        {
+            if (segs[i].endCol - segs[i].startCol >= m_minLength)
+                segs[n++] = segs[i];
+        }
+        row->len = n;
+    }
+}
+
+static inline bool overlap(const SSegment &a, const SSegment &b)
+{
+    return a.model==b.model && a.startCol<=b.endCol && b.startCol<=a.endCol;
+}
+
+// a run of s's model in row that overlaps it (rows are in column order)
+static bool supported(const RunRow *row, const SSegment &s)
+{
+    uint16_t i;
+
+    if (row==NULL)
+        return false;
+    for (i=0; i<row->len && row->segs[i].startCol<=s.endCol; i++)
+    {
+        if (overlap(row->segs[i], s))
+            return true;
+    }
+    return false;
+}
+
+void RunFilter::close(int16_t row)
+{
+    RunRow *prev=getRow(row-1), *cur=getRow(row), *next=getRow(row+1);
+    uint16_t i, j, len;
+    SSegment fill, s;
+
+    if (prev==NULL || next==NULL)
+        return;
+
+    // where runs above and below overlap and there's nothing of theirs in between
+    for (i=0, len=cur->len; i<prev->len; i++)
+    {
+        for (j=0; j<next->len && next->segs[j].startCol<=prev->segs[i].endCol; j++)
+        {
+            if (!overlap(prev->segs[i], next->segs[j]))
+                continue;
+            fill.model = prev->segs[i].model;
+            fill.row = row;
+            fill.startCol = prev->segs[i].startCol>next->segs[j].startCol ? prev->segs[i].startCol : next->segs[j].startCol;
+            fill.endCol = prev->segs[i].endCol<next->segs[j].endCol ? prev->segs[i].endCol : next->segs[j].endCol;
+            if (!supported(cur, fill) && cur->len<RF_MAX_ROW_SEGMENTS)
+                cur->segs[cur->len++] = fill;
+        }
+    }
+    // back into column order
+    for (i=len; i<cur->len; i++)
+    {
+        s = cur->segs[i];
+        for (j=i; j>0 && cur->segs[j-1].startCol>s.startCol; j--)
+            cur->segs[j] = cur->segs[j-1];
+        cur->segs[j] = s;
+    }
+}
+
+void RunFilter::open(int16_t row)
+{
+    RunRow *prev=getRow(row-1), *cur=getRow(row), *next=getRow(row+1);
+    uint16_t i;
+
+    for (i=0; i<cur->len; i++)
+    {
+        if ((supported(prev, cur->segs[i]) || supported(next, cur->segs[i])) &&
+            m_outLen<RF_OUT_ROWS*RF_MAX_ROW_SEGMENTS)
+            m_out[m_outLen++] = cur->segs[i];
+    }
+}
+
+void RunFilter::output(const RunRow *row)
+{
+    uint16_t i;
+
+    for (i=0; i<row->len && m_outLen<RF_OUT_ROWS*RF_MAX_ROW_SEGMENTS; i++)
+        m_out[m_outLen++] = row->segs[i];
+}
@@ -0,0 +1,85 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+#ifndef RUNFILTER_H
+#define RUNFILTER_H
+
+#include <stdint.h>
+#include "blob.h"
+
+// Cleans up a frame's run-length segments a row at a time on their way from the
+// Qqueue to the blob assemblers, so noise doesn't turn into lots of little blobs
+// that combine2() then has to merge back together.  Within a row, runs of a
+// signature closer than maxGap columns are joined and runs shorter than minLength
+// are dropped.  Between rows, "close" fills a one-row gap between runs of a
+// signature in the rows above and below, and "open" drops a run with nothing of
+// its signature in the row above or below, after closing.  Each of the two holds
+// rows back by one.  Lengths and gaps are in pixels the way the M0 measures them,
+// a segment's endCol is its startCol plus its length.
+#define RF_MAX_ROW_SEGMENTS   80 // the M0 sends at most 64 in a row, any more are dropped
+#define RF_ROWS               5 // the row coming in and up to 4 held back
+#define RF_OUT_ROWS           3 // at most this many come out at once, at the end of a frame
+#define RF_VERTICAL_OPEN      0x01
+#define RF_VERTICAL_CLOSE     0x02
+
+struct RunRow
+{
+    uint16_t len;
+    SSegment *segs;
+};
+
+class RunFilter
+{
+public:
+    RunFilter();
+    ~RunFilter();
+
+    void setParams(uint8_t minLength, uint8_t maxGap, uint8_t vertical);
+    bool enabled()
+    {
+        return m_vertical || m_maxGap || m_minLength>1;
+    }
+
+    // every row of the frame in order, empty or not, then its segments in column
+    // order, then endFrame()
+    void beginRow(int16_t row);
+    void add(const SSegment &s);
+    void endFrame();
+
+    // the segments that have made it through so far, row by row, which are then gone
+    uint16_t take(SSegment **segs);
+
+private:
+    RunRow *getRow(int16_t row);
+    void finishRow(int16_t row);
+    void closed(int16_t row);
+    void horizontal(RunRow *row);
+    void close(int16_t row);
+    void open(int16_t row);
+    void output(const RunRow *row);
+
+    uint8_t m_minLength;
+    uint8_t m_maxGap;
+    uint8_t m_vertical;
+
+    SSegment *m_mem;
+    RunRow m_rows[RF_ROWS]; // by row number, round robin
+    int16_t m_first; // the frame's first row
+    int16_t m_row; // the row coming in, -1 between frames
+
+    SSegment *m_out;
+    uint16_t m_outLen;
+};
+
+#endif // RUNFILTER_H
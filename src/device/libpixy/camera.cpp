@@ -17,6 +17,10 @@
 #include <pixyvals.h>
 #include "camera.h"
 #include "param.h"
+#include "misc.h"
+
+#define CAM_STREAM_HEADROOM     64 // in front of a streamed frame, for the progress word and the first band's header
+#define CAM_STREAM_TIMEOUT      100000 // us to wait for the M0 to grab more rows
 
 static const ProcModule g_module[] =
 {
@@ -174,7 +178,9 @@ static uint8_t g_awb = 1;
 static uint8_t g_aec = 1;
 static uint8_t g_lightMode = 0;
 static uint8_t g_brightness = CAM_BRIGHTNESS_DEFAULT;
+static uint8_t g_bandRows = 0;
 static ChirpProc g_getFrameM0 = -1;
+static ChirpProc g_getFrameRowsM0 = -1;
 
 static const uint8_t g_baseRegs[] =
 {
@@ -279,6 +285,9 @@ int cam_init()
 	if (g_getFrameM0<0)
 		return -1;
 
+	// optional, cam_streamFrameChirp() sends whole frames without it
+	g_getFrameRowsM0 = g_chirpM0->getProc("getFrameRows", NULL);
+
 	cam_loadParams();
 
 	return 0;
@@ -474,10 +483,9 @@ int cam_testPattern(const uint8_t &enable)
 	return 0;
 }
 
-int32_t cam_getFrame(uint8_t *memory, uint32_t memSize, uint8_t type, uint16_t xOffset, uint16_t yOffset, uint16_t xWidth, uint16_t yWidth)
+static int32_t cam_checkFrame(uint32_t memSize, uint8_t type, uint16_t xOffset, uint16_t yOffset, uint16_t xWidth, uint16_t yWidth)
 {
 	int32_t res;
-	int32_t responseInt = -1;
 
 	if (xWidth*yWidth>memSize)
 		return -2;
@@ -503,7 +511,15 @@ int32_t cam_getFrame(uint8_t *memory, uint32_t memSize, uint8_t type, uint16_t x
 		return -3;
 
 	// check mode, set if necessary
-	if ((res=cam_setMode(type&0x0f))<0)
+	return cam_setMode(type&0x0f);
+}
+
+int32_t cam_getFrame(uint8_t *memory, uint32_t memSize, uint8_t type, uint16_t xOffset, uint16_t yOffset, uint16_t xWidth, uint16_t yWidth)
+{
+	int32_t res;
+	int32_t responseInt = -1;
+
+	if ((res=cam_checkFrame(memSize, type, xOffset, yOffset, xWidth, yWidth))<0)
 		return res;
 
 	// forward call to M0, get frame
@@ -542,6 +558,76 @@ int32_t cam_getFrameChirpFlags(const uint8_t &type, const uint16_t &xOffset, con
 	return result;
 }
 
+// Like cam_getFrameChirpFlags(), but the frame goes out in bands of rows (BA8B) while the M0 is
+// still grabbing the rest, so the host sees the top of the frame sooner.  Each band's header
+// is written over the end of the band before it, which has already gone out, and those pixels
+// are put back once the band is sent so the frame is whole for g_rawFrame.  This only works
+// if the header lands 4-byte aligned, so widths that aren't a multiple of 4 are sent whole, as
+// is everything if "Frame band rows" is 0.
+int32_t cam_streamFrameChirp(const uint8_t &type, const uint16_t &xOffset, const uint16_t &yOffset, const uint16_t &xWidth, const uint16_t &yWidth, Chirp *chirp, uint8_t renderFlags)
+{
+	int32_t res, len;
+	uint32_t rows, sent, timer;
+	int32_t responseInt = -1;
+	volatile uint32_t *progress = (volatile uint32_t *)SRAM1_LOC;
+	uint8_t *frame = (uint8_t *)SRAM1_LOC + CAM_STREAM_HEADROOM;
+	uint8_t *band;
+	uint8_t save[CAM_STREAM_HEADROOM];
+
+	if (g_bandRows==0 || g_getFrameRowsM0<0 || (xWidth&0x03))
+		return cam_getFrameChirpFlags(type, xOffset, yOffset, xWidth, yWidth, chirp, renderFlags);
+
+	// the header is the same length for every band, find out what it is
+	len = Chirp::serialize(chirp, frame, SRAM1_SIZE-CAM_STREAM_HEADROOM, HTYPE(FOURCC('B','A','8','B')), HINT8(renderFlags), UINT16(xWidth), UINT16(yWidth), UINT16(0), UINTS8_NO_COPY(0), END);
+	if (len<0 || len>CAM_STREAM_HEADROOM-4)
+		return cam_getFrameChirpFlags(type, xOffset, yOffset, xWidth, yWidth, chirp, renderFlags);
+
+	if ((res=cam_checkFrame(SRAM1_SIZE-CAM_STREAM_HEADROOM, type, xOffset, yOffset, xWidth, yWidth))<0)
+		return res;
+
+	// the M0 counts rows in *progress as it grabs them
+	*progress = 0;
+	if ((res=g_chirpM0->callAsync(g_getFrameRowsM0, 
+		UINT8(type), UINT32((uint32_t)frame), UINT16(xOffset), UINT16(yOffset), UINT16(xWidth), UINT16(yWidth), UINT32((uint32_t)progress), END_OUT_ARGS))<0)
+		return res;
+
+	for (sent=0, setTimer(&timer); sent<yWidth; )
+	{
+		rows = *progress;
+		if (rows==CAM_ROWS_ERROR)
+			break;
+		// wait for a full band, or the end of the frame
+		if (rows<yWidth && rows-sent<g_bandRows)
+		{
+			if (getTimer(timer)>CAM_STREAM_TIMEOUT)
+				break;
+			continue;
+		}
+		// send whatever has come in, which is more than a band if we've fallen behind
+		band = frame + sent*xWidth;
+		memcpy(save, band-len, len);
+		Chirp::serialize(chirp, band-len, SRAM1_SIZE-(band-len-(uint8_t *)SRAM1_LOC), HTYPE(FOURCC('B','A','8','B')), HINT8(renderFlags), UINT16(xWidth), UINT16(yWidth), UINT16(sent), UINTS8_NO_COPY((rows-sent)*xWidth), END);
+		res = chirp->useBuffer(band-len, len+(rows-sent)*xWidth);
+		memcpy(band-len, save, len);
+		if (res<0)
+			break;
+		sent = rows;
+		setTimer(&timer);
+	}
+
+	// the M0's response is still coming, even if we gave up on it
+	g_chirpM0->getResponse(g_chirpM0->lastTag(), &responseInt, END_IN_ARGS);
+
+	if (responseInt==0)
+	{
+		g_rawFrame.m_pixels = frame;
+		g_rawFrame.m_width = xWidth;
+		g_rawFrame.m_height = yWidth;
+	}
+
+	return responseInt;
+}
+
 int32_t cam_setRegister(const uint8_t &reg, const uint8_t &value)
 {
   	g_sccb->Write(reg, value);
@@ -589,6 +675,9 @@ void cam_loadParams()
 	prm_add("AWB Value", PRM_FLAG_HEX_FORMAT | PRM_FLAG_ADVANCED, 
 		"@c Camera Sets the Auto White Balance value.  The parameter only applies when AWB Enable=0. Use the command \"cam_getWBV\" to get the current value (default 0x808080)", UINT32(0x808080), END);
 
+	prm_add("Frame band rows", PRM_FLAG_ADVANCED, 
+		"@c Camera Sets how many rows of a raw video frame to send at a time while the rest of the frame is still being grabbed.  0 sends whole frames once they're grabbed, which older versions of PixyMon need (default 0)", UINT8(0), END);
+
 	uint8_t brightness, aec, awb;
 	uint32_t ecv, wbv;
 	prm_get("Brightness", &brightness, END);
@@ -596,6 +685,7 @@ void cam_loadParams()
 	prm_get("AEC Value", &ecv, END);
 	prm_get("AWB Enable", &awb, END);
 	prm_get("AWB Value", &wbv, END);
+	prm_get("Frame band rows", &g_bandRows, END);
 	cam_setBrightness(brightness);
 	cam_setAEC(aec);
 	if (!aec)
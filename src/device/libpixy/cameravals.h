@@ -41,4 +41,6 @@
 #define CAM_GRAB_M1R1           (CAM_RES1<<4 | CAM_MODE1)
 #define CAM_GRAB_M1R2           (CAM_RES2<<4 | CAM_MODE1)
 
+#define CAM_ROWS_ERROR          0xffffffff // getFrameRows progress if the grab failed
+
 #endif
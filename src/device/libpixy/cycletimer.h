@@ -17,6 +17,7 @@
 #define CYCLETIMER_H
 #include "lpc_types.h"
 #include "lpc43xx.h"
+#include "pixyvals.h"
 
 #define CTIMER_DECLARE() \
   uint32_t ct_start; \
@@ -31,4 +32,10 @@
 #define CTIMER_GET() \
    ct_diff
 
+// TIMER1 runs free at the core clock
+#define CTIMER_TICKS() \
+  LPC_TIMER1->TC
+
+#define CTIMER_TICKS_PER_US    CLKFREQ_US
+
 #endif
@@ -16,6 +16,9 @@
 #include "chirp.h"
 #include "frame_m0.h"
 
+// getFrameRows() points this at the M4's progress word, the number of rows in memory so far
+static volatile uint32_t *g_rows = 0;
+
 #define CAM_PCLK_MASK   0x2000
 
 #define ALIGN(v, n)  ((uint32_t)v&((n)-1) ? ((uint32_t)v&~((n)-1))+(n) : (uint32_t)v)
@@ -524,7 +527,11 @@ void grabM0R0(uint32_t xoffset, uint32_t yoffset, uint32_t xwidth, uint32_t ywid
 
 	skipLines(yoffset);
 	for (line=0; line<ywidth; line++, memory+=xwidth)
+	{
 		lineM0((uint32_t *)&CAM_PORT, memory, xoffset, xwidth); // wait, grab, wait
+		if (g_rows)
+			*g_rows = line+1;
+	}
 }
 
 void grabM1R1(uint32_t xoffset, uint32_t yoffset, uint32_t xwidth, uint32_t ywidth, uint8_t *memory)
@@ -536,7 +543,11 @@ void grabM1R1(uint32_t xoffset, uint32_t yoffset, uint32_t xwidth, uint32_t ywid
 
 	skipLines(yoffset);
 	for (line=0; line<ywidth; line++, memory+=xwidth)
+	{
 		lineM1R1((uint32_t *)&CAM_PORT, memory, xoffset, xwidth); // wait, grab, wait
+		if (g_rows)
+			*g_rows = line+1;
+	}
 }
 
 void grabM1R2(uint32_t xoffset, uint32_t yoffset, uint32_t xwidth, uint32_t ywidth, uint8_t *memory)
@@ -563,6 +574,9 @@ void grabM1R2(uint32_t xoffset, uint32_t yoffset, uint32_t xwidth, uint32_t ywid
 		lineM1R2((uint32_t *)&CAM_PORT, lineStore+xwidth, xoffset, xwidth); // wait, grab, wait
 		lineM1R2Merge((uint32_t *)&CAM_PORT, lineStore, memory, xoffset, xwidth); // wait, grab, wait
 		lineM1R2Merge((uint32_t *)&CAM_PORT, lineStore+xwidth, memory+xwidth, xoffset, xwidth); // wait, grab, wait
+		// the first merge wrote row 0, so rows up to line+2 are in
+		if (g_rows)
+			*g_rows = line+3<ywidth ? line+3 : ywidth;
 	}					
 }
 
@@ -592,12 +606,28 @@ int32_t getFrame(uint8_t *type, uint32_t *memory, uint16_t *xoffset, uint16_t *y
 	return 0;
 }
 
+// Same as getFrame, but keeps the word at rows up to date with how many rows have been grabbed,
+// so the M4 can send the top of the frame while the bottom is still coming in.  It ends up at
+// the height, or CAM_ROWS_ERROR.
+int32_t getFrameRows(uint8_t *type, uint32_t *memory, uint16_t *xoffset, uint16_t *yoffset, uint16_t *xwidth, uint16_t *ywidth, uint32_t *rows)
+{
+	int32_t res;
+	uint16_t height = *ywidth;
+
+	g_rows = (volatile uint32_t *)*rows;
+	*g_rows = 0;
+	res = getFrame(type, memory, xoffset, yoffset, xwidth, ywidth);
+	*g_rows = res<0 ? CAM_ROWS_ERROR : height;
+	g_rows = 0;
 
+	return res;
+}
 
 
 int frame_init(void)
 {
 	chirpSetProc("getFrame", (ProcPtr)getFrame);
+	chirpSetProc("getFrameRows", (ProcPtr)getFrameRows);
 		
 	return 0;	
 }
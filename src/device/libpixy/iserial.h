@@ -62,6 +62,24 @@ public:
 		return 1;
 	}
 
+	// up to len elements, what's there if there are fewer
+	int read(BufType *data, uint32_t len)
+	{
+		uint32_t i, n = receiveLen();
+
+		if (len<n)
+			n = len;
+		for (i=0; i<n; i++)
+		{
+			data[i] = m_buf[m_read++];
+			if (m_read==m_size)
+				m_read = 0;
+		}
+		m_consumed += n;
+
+		return n;
+	}
+
 	inline int write(BufType data)
 	{
 		if (freeLen()<=0)
@@ -76,6 +94,24 @@ public:
 		return 1;
 	}
 
+	// up to len elements, as many as there's room for
+	int write(const BufType *data, uint32_t len)
+	{
+		uint32_t i, n = freeLen();
+
+		if (len<n)
+			n = len;
+		for (i=0; i<n; i++)
+		{
+			m_buf[m_write++] = data[i];
+			if (m_write==m_size)
+				m_write = 0;
+		}
+		m_produced += n;
+
+		return n;
+	}
+
 	uint32_t m_size;
 	BufType *m_buf;
 	uint32_t m_read;
@@ -103,7 +139,10 @@ public:
 		delete [] m_buf;
 	}
 
-	int read(BufType *data)
+	// What's left of the current chunk, getting the next one from the callback if it's
+	// all gone.  An ISR can send straight from here and consume() what it sent, rather
+	// than going through read() an element at a time.
+	int peek(const BufType **data)
 	{
 		if (m_len==0)
 		{
@@ -112,12 +151,49 @@ public:
 				return 0;
 		 	m_read = 0;
 		}
-		*data = m_buf[m_read++];
-		m_len--;
+		*data = m_buf + m_read;
+
+		return m_len;
+	}
+
+	inline void consume(uint32_t len)
+	{
+		m_read += len;
+		m_len -= len;
+	}
+
+	int read(BufType *data)
+	{
+		const BufType *chunk;
+
+		if (peek(&chunk)==0)
+			return 0;
+		*data = *chunk;
+		consume(1);
 
 		return 1;
 	}
 
+	// up to len elements, across as many chunks as it takes
+	int read(BufType *data, uint32_t len)
+	{
+		uint32_t i, n, total;
+		const BufType *chunk;
+
+		for (total=0; total<len; total+=n)
+		{
+			if ((n=peek(&chunk))==0)
+				break;
+			if (n>len-total)
+				n = len-total;
+			for (i=0; i<n; i++)
+				data[total+i] = chunk[i];
+			consume(n);
+		}
+
+		return total;
+	}
+
 	uint32_t m_size;
 	BufType *m_buf;
 	uint32_t m_read;
@@ -87,6 +87,13 @@ uint32_t getTimer(uint32_t timer)
 	return result;
 }
 
+// Called by the scheduler when there's nothing to do.  The M0 and the serial and USB
+// flags are polled, and nothing interrupts us on a timer, so there's no event to
+// sleep on and we go straight back to polling.
+void waitEvent(void)
+{
+}
+
 void showError(uint8_t num, uint32_t color, const char *message)
 {
 	int i;
@@ -29,6 +29,7 @@ void delayus(uint32_t us);
 void delayms(uint32_t ms);
 void setTimer(uint32_t *timer);
 uint32_t getTimer(uint32_t timer);
+void waitEvent(void);
 void showError(uint8_t num, uint32_t color, const char *message);
 
 
@@ -14,6 +14,7 @@
 //
 
 #include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 #include "param.h"
 #include "pixytypes.h"
@@ -28,6 +29,13 @@
 #define PRM_FLASH_LOC	  			(FLASH_BEGIN + FLASH_SIZE - PRM_ALLOCATED_LEN)  // last sectors
 #define PRM_ENDREC_OFFSET 			((PRM_ALLOCATED_LEN/PRM_MAX_LEN)*PRM_MAX_LEN)  // last sector
 #define PRM_ENDREC	      			(PRM_FLASH_LOC + PRM_ENDREC_OFFSET)  // last sector
+#define PRM_BULK_REC_LEN			(PRM_MAX_LEN + CRP_MAX_ARGS + 32) // serialized record, worst case
+#define PRM_BULK_HEADER_LEN			16 // the records' array type and length, and CRP_BUFPAD
+#define PRM_NUM_RECS				(PRM_ENDREC_OFFSET/PRM_MAX_LEN)
+#define PRM_RECS_PER_SECTOR			(FLASH_SECTOR_SIZE/PRM_MAX_LEN)
+#define PRM_NUM_SECTORS				(PRM_ALLOCATED_LEN/FLASH_SECTOR_SIZE)
+#define PRM_HASH_LEN				256 // power of 2, larger than PRM_NUM_RECS
+#define PRM_MAX_STAGED				4 // sectors a transaction can hold in RAM, 64 records
 
 static const ProcModule g_module[] =
 {
@@ -71,6 +79,39 @@ static const ProcModule g_module[] =
 	"@p index of parameter"
 	"@r 0 if success, negative if error"
 	},
+	{
+	"prm_getAllBulk",
+	(ProcPtr)prm_getAllBulk, 
+	{END}, 
+	"Get all information of all parameters in one call. "
+	"Returned data is a sequence of records, each consisting of a 32-bit length followed by "
+	"the same values prm_getAll returns (flags, argument list, id, description, value), serialized. "
+	"Records are padded to a 4-byte boundary."
+	"@r number of parameters if success, negative if error"
+	},
+	{
+	"prm_begin",
+	(ProcPtr)prm_begin, 
+	{END}, 
+	"Begin parameter transaction. Parameters set after this are held in RAM and written to flash "
+	"together by prm_commit, which must follow."
+	"@r 0 if success, negative if error"
+	},
+	{
+	"prm_commit",
+	(ProcPtr)prm_commit, 
+	{END}, 
+	"Commit parameter transaction, writing each modified flash sector once. "
+	"If any parameter couldn't be set, none are written."
+	"@r 0 if success, -2 if the transaction was discarded, negative if error"
+	},
+	{
+	"prm_abort",
+	(ProcPtr)prm_abort, 
+	{END}, 
+	"Abort parameter transaction, discarding the parameters set since prm_begin"
+	"@r 0 if success, negative if error"
+	},
 	END
 };
 
@@ -84,8 +125,102 @@ struct ParamRecord
 	uint8_t data[PRM_DATA_LEN];
 };
 
+// Records are found through a hash index (record number+1, 0 if empty) instead of
+// scanning flash.  Records in sectors that are being modified (see prm_begin()) live 
+// in RAM copies of those sectors until prm_commit().
+static uint16_t g_numRecs = 0;
+static uint8_t g_index[PRM_HASH_LEN];
+static uint8_t *g_staged[PRM_NUM_SECTORS];
+static uint8_t g_numStaged = 0;
+static bool g_failed = false; // a sector couldn't be staged, the transaction can only be thrown away
+static uint8_t g_depth = 0;
+static uint16_t g_transaction = 0; // counts outermost prm_begin()'s, never 0
+
+static uint32_t prm_hash(const char *id)
+{
+	uint32_t hash = 2166136261u; // FNV-1a
+
+	while(*id)
+	{
+		hash ^= (uint8_t)*id++;
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+static ParamRecord *prm_record(uint32_t i)
+{
+	uint32_t sector = i/PRM_RECS_PER_SECTOR;
+
+	if (g_staged[sector])
+		return (ParamRecord *)(g_staged[sector] + (i%PRM_RECS_PER_SECTOR)*PRM_MAX_LEN);
+	return (ParamRecord *)(PRM_FLASH_LOC + i*PRM_MAX_LEN);
+}
+
+// return RAM copy of record, copying its sector out of flash if we haven't already
+static ParamRecord *prm_stage(uint32_t i)
+{
+	uint32_t sector = i/PRM_RECS_PER_SECTOR;
+
+	if (g_staged[sector]==NULL)
+	{
+		if (g_numStaged>=PRM_MAX_STAGED || (g_staged[sector]=(uint8_t *)malloc(FLASH_SECTOR_SIZE))==NULL)
+		{
+			g_failed = true;
+			return NULL;
+		}
+		g_numStaged++;
+		memcpy(g_staged[sector], (void *)(PRM_FLASH_LOC + sector*FLASH_SECTOR_SIZE), FLASH_SECTOR_SIZE);
+	}
+	return prm_record(i);
+}
+
+static void prm_unstage()
+{
+	uint32_t i;
+
+	for (i=0; i<PRM_NUM_SECTORS; i++)
+	{
+		free(g_staged[i]);
+		g_staged[i] = NULL;
+	}
+	g_numStaged = 0;
+}
+
+static void prm_index(uint32_t i)
+{
+	uint32_t h;
+
+	for (h=prm_hash((char *)prm_record(i)->data); g_index[h&(PRM_HASH_LEN-1)]; h++);
+	g_index[h&(PRM_HASH_LEN-1)] = i+1;
+}
+
+static int prm_lookup(const char *id)
+{
+	uint32_t h;
+	uint8_t i;
+
+	for (h=prm_hash(id); (i=g_index[h&(PRM_HASH_LEN-1)]); h++)
+	{
+		if (strcmp(id, (char *)prm_record(i-1)->data)==0)
+			return i-1;
+	}
+	return -1;
+}
+
+static void prm_buildIndex()
+{
+	ParamRecord *rec;
+
+	memset(g_index, 0, sizeof(g_index));
+	for (g_numRecs=0, rec=(ParamRecord *)PRM_FLASH_LOC; rec->crc!=0xffff && rec<(ParamRecord *)PRM_ENDREC; g_numRecs++, rec++)
+		prm_index(g_numRecs);
+}
+
 int prm_init(Chirp *chirp)
 {
+	prm_buildIndex();
+
 	// check integrity
 	if (!prm_verifyAll())
 	{
@@ -125,61 +260,116 @@ uint32_t prm_getDataOffset(const ParamRecord *rec)
 	return offset; 
 }
 
+ParamRecord *prm_find(const char *id)
+{
+	int i = prm_lookup(id);
+
+	if (i<0)
+		return NULL;
+	return prm_record(i);
+}
+
 int32_t prm_getInfo(const char *id, Chirp *chirp)
 {
 	ParamRecord *rec;
 
-	for (rec=(ParamRecord *)PRM_FLASH_LOC; rec->crc!=0xffff && rec<(ParamRecord *)PRM_ENDREC; rec++)
-	{
-		if(strcmp(id, (char *)rec->data)==0)
-		{
-			CRP_RETURN(chirp, STRING(prm_getDesc(rec)));
-			return 0;
-		}
-	}
-	return -1;	
+	rec = prm_find(id);
+	if (rec==NULL)
+		return -1;
+
+	CRP_RETURN(chirp, STRING(prm_getDesc(rec)));
+	return 0;
 }
 
 
 int32_t  prm_getAll(const uint16_t &index, Chirp *chirp)
 {
 	int res;
-	uint16_t i;
 	uint8_t *data, argList[CRP_MAX_ARGS];
 	ParamRecord *rec;
 
-	for (i=0, rec=(ParamRecord *)PRM_FLASH_LOC; rec->crc!=0xffff && rec<(ParamRecord *)PRM_ENDREC; i++, rec++)
+	if (index>=g_numRecs)
+		return -1;
+
+	rec = prm_record(index);
+	data = (uint8_t *)rec+prm_getDataOffset(rec);
+	res = Chirp::getArgList(data, rec->len, argList);
+	if (res<0)
+		return res;
+	CRP_RETURN(chirp, UINT32(rec->flags), STRING(argList), STRING(prm_getId(rec)), STRING(prm_getDesc(rec)),  UINTS8(rec->len, data), END);
+	return 0;
+}
+
+
+int32_t prm_getAllBulk(Chirp *chirp)
+{
+	int res, hlen;
+	uint32_t i, len, offset;
+	uint8_t *buf, *data, argList[CRP_MAX_ARGS];
+	ParamRecord *rec;
+
+	if (g_numRecs==0)
+		return -1;
+
+	// The records are serialized straight into chirp's buffer, after the array's type and
+	// length.  Serializing them elsewhere for CRP_RETURN to copy would take the heap twice over.
+	len = PRM_BULK_HEADER_LEN + g_numRecs*PRM_BULK_REC_LEN;
+	buf = chirp->returnBuffer(len);
+	if (buf==NULL)
+		return -2;
+	hlen = Chirp::serialize(NULL, buf, len, UINTS8_NO_COPY(0), END);
+	if (hlen<0)
+		return hlen;
+
+	for (i=0, offset=hlen; i<g_numRecs; i++)
 	{
-		if(i==index)
-		{
-			data = (uint8_t *)rec+prm_getDataOffset(rec);
-			res = Chirp::getArgList(data, rec->len, argList);
-			if (res<0)
-				return res;
-			CRP_RETURN(chirp, UINT32(rec->flags), STRING(argList), STRING(prm_getId(rec)), STRING(prm_getDesc(rec)),  UINTS8(rec->len, data), END);
-			return 0;
-		}
+		rec = prm_record(i);
+		data = (uint8_t *)rec+prm_getDataOffset(rec);
+		res = Chirp::getArgList(data, rec->len, argList);
+		if (res<0)
+			return res;
+		res = Chirp::serialize(NULL, buf+offset+4, PRM_BULK_REC_LEN-4, UINT32(rec->flags), STRING(argList), STRING(prm_getId(rec)), 
+			STRING(prm_getDesc(rec)), UINTS8(rec->len, data), END);
+		if (res<0)
+			return res;
+		*(uint32_t *)(buf+offset) = res;
+		offset += res+4;
+		ALIGN(offset, 4);
 	}
-	return -1;	
-}
 
+	// now that we know how long the array is
+	Chirp::serialize(NULL, buf, len, UINTS8_NO_COPY(offset-hlen), END);
+	chirp->returnArgs(offset);
+
+	return g_numRecs;
+}
 
 int prm_format()
 {
 	flash_erase(PRM_FLASH_LOC, PRM_ALLOCATED_LEN);
+	// anything staged or indexed is gone
+	prm_unstage();
+	g_failed = false;
+	g_depth = 0;
+	g_numRecs = 0;
+	memset(g_index, 0, sizeof(g_index));
 	cprintf("All parameters have been erased and restored to their defaults!\n");
 	g_dirty = true;
 	return 0;
 }
 
-uint16_t prm_crc(const ParamRecord *rec)
+static uint16_t prm_crc(const ParamRecord *rec, bool legacy)
 {
 	uint16_t crc;
 
 	if (rec->len>PRM_MAX_LEN)
 		return 0;
 
-	crc = Chirp::calcCrc((uint8_t *)rec+2, rec->len+prm_getDataOffset(rec)-2); // +2, -2 because we don't include crc 
+	// +2, -2 because we don't include crc
+	if (legacy)
+		crc = Chirp::calcCrc((uint8_t *)rec+2, rec->len+prm_getDataOffset(rec)-2);
+	else
+		crc = Chirp::calcCrc16((uint8_t *)rec+2, rec->len+prm_getDataOffset(rec)-2);
 
 	// crc can't equal 0xffff
 	if (crc==0xffff)
@@ -188,52 +378,24 @@ uint16_t prm_crc(const ParamRecord *rec)
 	return crc;
 }
 
-ParamRecord *prm_find(const char *id, uint8_t *buf=NULL)
-{
-	ParamRecord *rec, *begin, *end;
-
-	if (buf)
-	{
-		begin =  (ParamRecord *)buf;
-		end = (ParamRecord *)(buf+FLASH_SECTOR_SIZE);
-	}
-	else
-	{
-		begin =	(ParamRecord *)PRM_FLASH_LOC;
-		end = (ParamRecord *)PRM_ENDREC;
-	}
-	
-	for (rec=begin; rec->crc!=0xffff && rec<end; rec++)
-	{
-		if(strcmp(id, (char *)rec->data)==0)
-			return rec;
-	}
-	return NULL;
-}
-
-uint32_t prm_nextFree()
+uint16_t prm_crc(const ParamRecord *rec)
 {
-	ParamRecord *rec;
-
-	for (rec=(ParamRecord *)PRM_FLASH_LOC; rec->crc!=0xffff && rec<(ParamRecord *)PRM_ENDREC; rec++);
-
-	if (rec>=(ParamRecord *)PRM_ENDREC)
-		return NULL;
-	return (uint32_t)rec; 
+	return prm_crc(rec, false);
 }
 
 bool prm_verifyRecord(const ParamRecord *rec)
 {	
-	return prm_crc(rec)==rec->crc;
+	// records written by older firmware have the sum
+	return prm_crc(rec)==rec->crc || prm_crc(rec, true)==rec->crc;
 }
 
 bool prm_verifyAll()
 {
-	ParamRecord *rec;
+	uint32_t i;
 
-	for (rec=(ParamRecord *)PRM_FLASH_LOC; rec->crc!=0xffff && rec<(ParamRecord *)PRM_ENDREC; rec++)
+	for (i=0; i<g_numRecs; i++)
 	{
-		if (prm_verifyRecord(rec)==false)
+		if (prm_verifyRecord(prm_record(i))==false)
 			return false;
 	}
 
@@ -252,58 +414,114 @@ int32_t prm_set(const char *id, ...)
 	if (res<0)
 		return res;
 
-	prm_setChirp(id, res, buf);
+	return prm_setChirp(id, res, buf);
+}
 
+int32_t prm_begin()
+{
+	if (g_depth++==0)
+	{
+		if (++g_transaction==0)
+			g_transaction = 1;
+		g_failed = false;
+	}
 	return 0;
 }
 
-int32_t prm_setChirp(const char *id, const uint32_t &valLen, const uint8_t *val)
+// Back to what's in flash.  Records prm_add() put in staged sectors go too, so the
+// index is rebuilt from flash.
+static void prm_discard()
 {
-	ParamRecord *rec;
-	uint8_t *buf;
-	uint32_t offset;
-	void *sector;
+	prm_unstage();
+	prm_buildIndex();
+	g_failed = false;
+	g_depth = 0;
+	g_dirty = true;
+}
+
+int32_t prm_abort()
+{
+	if (g_depth==0)
+		return -1;
+	prm_discard();
+	return 0;
+}
+
+int32_t prm_end()
+{
+	if (g_depth==0)
+		return 0;
+	g_depth = 1;
+	return prm_commit();
+}
+
+uint16_t prm_transaction()
+{
+	return g_depth ? g_transaction : 0;
+}
+
+int32_t prm_commit()
+{
+	uint32_t i, sector;
 	int32_t res = 0;
 
-	buf = (uint8_t *)malloc(FLASH_SECTOR_SIZE);
+	if (g_depth==0)
+		return -1;
+	if (--g_depth) // nested, outermost commit does the writing
+		return 0;
 
-	if (buf==NULL)
+	// writing only some of the transaction would leave a mix of old and new values
+	if (g_failed)
+	{
+		prm_discard();
 		return -2;
+	}
 
-	rec = prm_find(id);
-
-	if (rec==NULL)
+	for (i=0; i<PRM_NUM_SECTORS; i++)
 	{
-		res = -1;
-		goto end;
+		if (g_staged[i]==NULL)
+			continue;
+		sector = PRM_FLASH_LOC + i*FLASH_SECTOR_SIZE;
+		if (flash_erase(sector, FLASH_SECTOR_SIZE)<0 || flash_program(sector, g_staged[i], FLASH_SECTOR_SIZE)<0)
+			res = -1;
 	}
+	prm_unstage();
+
+	return res;
+}
+
+int32_t prm_setChirp(const char *id, const uint32_t &valLen, const uint8_t *val)
+{
+	ParamRecord *rec;
+	uint32_t offset;
+	int i;
 
-	sector = (void *)FLASH_SECTOR_MASK((uint32_t)rec);
-	memcpy(buf, sector, FLASH_SECTOR_SIZE);
+	i = prm_lookup(id);
+	if (i<0)
+		return -1;
+
+	offset = prm_getDataOffset(prm_record(i));
+	if (offset+valLen>PRM_MAX_LEN)
+		return -3;
 
-	rec = prm_find(id, buf);
+	// if we're not in a transaction, this is a transaction of one
+	prm_begin();
 
+	// once staging has failed, the rest of the transaction is going nowhere
+	rec = g_failed ? NULL : prm_stage(i);
 	if (rec==NULL)
 	{
-		res = -1;
-		goto end;
+		prm_commit();
+		return -2;
 	}
 
-	offset = prm_getDataOffset(rec);	
 	memcpy((uint8_t *)rec+offset, val, valLen);
-
-	 	
 	rec->len = valLen;
 	rec->crc = prm_crc(rec);
-	
-	flash_erase((uint32_t)sector, FLASH_SECTOR_SIZE); 
-	flash_program((uint32_t)sector, buf, FLASH_SECTOR_SIZE);
 
 	g_dirty = true; // set dirty flag
 
-end:
-	free(buf); 	
-	return res;
+	return prm_commit();
 }
 
 int32_t prm_get(const char *id, ...)
@@ -341,7 +559,7 @@ int prm_add(const char *id, uint32_t flags, const char *desc, ...)
 {
 	char buf[PRM_MAX_LEN];
 	int len;
-    uint32_t freeLoc, offset=PRM_HEADER_LEN;
+    uint32_t i, offset=PRM_HEADER_LEN;
     va_list args;
 	ParamRecord *rec = (ParamRecord *)buf;
 
@@ -360,7 +578,7 @@ int prm_add(const char *id, uint32_t flags, const char *desc, ...)
 	}
 	else
 	{
-		*(char *)(rec+offset) = '\0';
+		*((char *)rec+offset) = '\0';
 	 	offset++;
 	}
 
@@ -378,10 +596,21 @@ int prm_add(const char *id, uint32_t flags, const char *desc, ...)
 	rec->len = len;
 	rec->crc = prm_crc(rec); 
 
-	if ((freeLoc=prm_nextFree())==NULL)
+	if (g_numRecs>=PRM_NUM_RECS)
 		return -4;
-	
-	return flash_program(freeLoc, (uint8_t *)rec, len+prm_getDataOffset(rec));	
+	i = g_numRecs;
+
+	// if the sector is staged, add it there, otherwise it goes directly into erased flash
+	len += prm_getDataOffset(rec);
+	if (g_staged[i/PRM_RECS_PER_SECTOR])
+		memcpy(prm_record(i), rec, len);
+	else if (flash_program(PRM_FLASH_LOC + i*PRM_MAX_LEN, (uint8_t *)rec, len)<0)
+		return -5;
+
+	g_numRecs++;
+	prm_index(i);
+
+	return 0;
 }
 
 bool prm_dirty()
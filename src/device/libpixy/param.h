@@ -23,10 +23,22 @@ int prm_init(Chirp *chirp);
 
 int32_t prm_set(const char *id, ...);
 int32_t prm_setChirp(const char *id, const uint32_t &valLen, const uint8_t *val);
+// prm_set() calls between prm_begin() and prm_commit() are staged in RAM and written
+// with one erase/program per flash sector on commit.  These can be nested.  If a
+// sector can't be staged, nothing is written and the outermost commit returns -2.
+// prm_abort() throws the whole transaction away, prm_end() commits it however deeply
+// it's nested.  prm_transaction() identifies the open transaction, 0 if there isn't
+// one, so a transaction a host began and never finished can be ended (see exec.cpp).
+int32_t prm_begin();
+int32_t prm_commit();
+int32_t prm_abort();
+int32_t prm_end();
+uint16_t prm_transaction();
 int32_t prm_get(const char *id, ...);
 int32_t prm_getChirp(const char *id, Chirp *chirp);
 int32_t prm_getInfo(const char *id, Chirp *chirp);
 int32_t prm_getAll(const uint16_t &index, Chirp *chirp);
+int32_t prm_getAllBulk(Chirp *chirp);
 
 void prm_setDirty(bool dirty);
 
@@ -38,6 +38,7 @@ void pixySimpleInit(void);
 
 void cprintf(const char *format, ...);
 void periodic();
+bool usbPending(); // usblink.cpp
 
 extern Chirp *g_chirpUsb;
 extern Chirp *g_chirpM0;
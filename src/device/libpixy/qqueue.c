@@ -35,4 +35,25 @@ uint16_t qq_free(void)
 {
     uint16_t len = g_qqueue->produced - g_qqueue->consumed;
 	return QQ_MEM_SIZE-len;
+}
+
+// 1 if a frame can start, there's a free slot and room for its first room Qvals,
+// otherwise the frame is skipped
+uint32_t qq_beginFrame(uint16_t room)
+{
+	if ((uint16_t)(g_qqueue->frames - g_qqueue->released)>=QQ_SLOTS || qq_free()<room)
+	{
+		g_qqueue->skipped++;
+		return 0;
+	}
+	return 1;
+}
+
+// the caller leaves room for the end of frame marker
+void qq_endFrame(uint32_t complete)
+{
+	qq_enqueue(0xffffffff);
+	g_qqueue->frames++;
+	if (!complete)
+		g_qqueue->truncated++;
 } 
@@ -555,9 +555,10 @@ int32_t getRLSFrame(uint32_t *m0Mem, uint32_t *lut)
 {
 	uint8_t *lut2 = (uint8_t *)*lut;
 	Qval *qvalStore = (Qval *)*m0Mem;
-	uint32_t line;
+	uint32_t line, top, bottom;
 	uint32_t numQvals;
 	uint32_t totalQvals;
+	Qval cols, rows;
 	uint8_t *lineStore;
 	uint8_t *logLut;
 
@@ -571,18 +572,47 @@ int32_t getRLSFrame(uint32_t *m0Mem, uint32_t *lut)
 	 	createLogLut();
 	}
 
-	// don't even attempt to grab lines if we're lacking space...
-	if (qq_free()<MAX_QVALS_PER_LINE)
-		return -1; 
-
-	// indicate start of frame
-	qq_enqueue(0xffffffff); 
+	// wait for the start of the next frame
 	skipLines(0);
-	for (line=0, totalQvals=1; line<CAM_RES2_HEIGHT; line++)  // start totalQvals at 1 because of start of frame value
+	// the window the M4 wants, if any (see qqueue.h)
+	cols = g_qqueue->windowCols;
+	rows = g_qqueue->windowRows;
+	if (rows)
+	{
+		top = QQ_WINDOW_START(rows);
+		bottom = top + QQ_WINDOW_LEN(rows);
+		if (bottom>CAM_RES2_HEIGHT)
+			bottom = CAM_RES2_HEIGHT;
+		if (top>bottom)
+			top = bottom;
+	}
+	else
+	{
+		top = 0;
+		bottom = CAM_RES2_HEIGHT;
+	}
+	// let it go by if the M4 still has both slots or there's no room for its first line
+	// (a line needs room for its beginning and the end of frame too, and the window)
+	if (!qq_beginFrame(MAX_QVALS_PER_LINE+2+QQ_WINDOW_QVALS))
+		return -1;
+	if (cols)
+		qq_enqueue(cols);
+	if (rows)
+	{
+		qq_enqueue(rows);
+		// each of our lines is 2 of the sensor's
+		for (line=0; line<top*2; line++)
+			skipLine();
+	}
+	// the frame ends with the window, the M4 gets it that much sooner
+	for (line=top, totalQvals=0; line<bottom; line++)
 	{
-		// not enough space--- return error
-		if (qq_free()<MAX_QVALS_PER_LINE)
-			return -1; 
+		// not enough space--- end the frame here, the M4 gets what we have
+		if (qq_free()<MAX_QVALS_PER_LINE+2)
+		{
+			qq_endFrame(0);
+			return -1;
+		}
 		// mark beginning of this row (column 0 = 0)
 		// column 1 is the first real column of pixels
 		qq_enqueue(0); 
@@ -595,6 +625,7 @@ int32_t getRLSFrame(uint32_t *m0Mem, uint32_t *lut)
 		g_qqueue->produced += numQvals;
 		totalQvals += numQvals+1; // +1 because of beginning of line 
 	}
+	qq_endFrame(1);
 	return 0;
 }
 
@@ -20,13 +20,24 @@
 #include "analogdig.h"
 #include "conncomp.h"
 #include "param.h"
+#include "perf.h"
 
 static uint8_t g_interface = 0;
+static uint8_t g_protocol = SER_PROTOCOL_V1;
 static Iserial *g_serial = 0;
 
 uint32_t callback(uint8_t *data, uint32_t len)
 {
-	return g_blobs->getBlock(data, len);
+	PERF_DECLARE(timer);
+
+	PERF_START(timer);
+	if (g_protocol>=SER_PROTOCOL_V2)
+		len = g_blobs->getBlockV2(data, len);
+	else
+		len = g_blobs->getBlocks(data, len);
+	PERF_STOP(PERF_SERIAL, timer);
+
+	return len;
 }
 
 
@@ -50,13 +61,21 @@ void ser_loadParams()
 		"@c Interface Sets the I2C address if you are using I2C data out port. (default 0x54)", UINT8(I2C_DEFAULT_SLAVE_ADDR), END);
 	prm_add("UART baudrate", 0, 
 		"@c Interface Sets the UART baudrate if you are using UART data out port. (default 19200)", UINT32(19200), END);
+	prm_add("Data out protocol", 0,
+		"@c Interface Selects the block format, 0=original (14 bytes a block), 1=framed v2 (5 bytes a block, frames have a counter and CRC), 2=framed v2 with delta frames (default 0)", UINT8(SER_PROTOCOL_V1), END);
+	prm_add("Data out keyframe period", 0,
+		"@c Interface Sets how often a whole frame is sent if Data out protocol is 2, every this many frames. (default 10)", UINT8(10), END);
 
-	uint8_t interface, addr;
+	uint8_t interface, addr, period;
 	uint32_t baudrate;
 
 	prm_get("Data out port", &interface, END);
 	ser_setInterface(interface);
 
+	prm_get("Data out protocol", &g_protocol, END);
+	prm_get("Data out keyframe period", &period, END);
+	g_blobs->setKeyframePeriod(g_protocol==SER_PROTOCOL_V2_DELTA ? period : 0);
+
 	prm_get("I2C address", &addr, END);
 	g_i2c0->setSlaveAddr(addr);
 
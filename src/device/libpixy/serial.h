@@ -24,6 +24,11 @@
 #define SER_INTERFACE_ADX     3
 #define SER_INTERFACE_ADY     4
 
+// block formats, "Data out protocol"
+#define SER_PROTOCOL_V1       0
+#define SER_PROTOCOL_V2       1
+#define SER_PROTOCOL_V2_DELTA 2
+
 
 int ser_init();
 int ser_setInterface(uint8_t interface);
@@ -79,8 +79,8 @@ void SSP1_IRQHandler(void)
 
 void Spi::slaveHandler()
 {
-	uint32_t d;
-	uint16_t d16; 
+	uint32_t d, i, len;
+	const uint16_t *data; 
 
 	// toggle SPI_SS so we can receive the next word
 	SS_NEGATE(); // negate SPI_SS
@@ -90,12 +90,14 @@ void Spi::slaveHandler()
 	// clear interrupt
 	LPC_SSP1->ICR = SSP_INTCFG_RX;  
 
-	// fill fifo
+	// fill fifo, straight from the transmit queue's chunk
 	while(LPC_SSP1->SR&SSP_SR_TNF) 
 	{
-		if (m_tq.read(&d16)==0)
+		if ((len=m_tq.peek(&data))==0)
 			break;
-		LPC_SSP1->DR = d16;
+		for (i=0; i<len && (LPC_SSP1->SR&SSP_SR_TNF); i++)
+			LPC_SSP1->DR = data[i];
+		m_tq.consume(i);
 	}
 	
 	// receive data
@@ -19,7 +19,7 @@
 #include "iserial.h"
 
 #define SPI_RECEIVEBUF_SIZE   	16
-#define SPI_TRANSMITBUF_SIZE  	16
+#define SPI_TRANSMITBUF_SIZE  	32
 
 #define SS_ASSERT()  			LPC_SGPIO->GPIO_OUTREG = 0;
 #define SS_NEGATE() 			LPC_SGPIO->GPIO_OUTREG = 1<<14;
@@ -29,8 +29,8 @@ void UART0_IRQHandler(void)
 
 void Uart::irqHandler()
 {
-	uint32_t status;
-	uint8_t i, c;
+	uint32_t status, i, j, len;
+	const uint8_t *data;
 	volatile uint32_t v;
 
 	m_flag = false;
@@ -44,13 +44,16 @@ void Uart::irqHandler()
 		v = m_uart->RBR; // toss...
 	else if (status==UART_IIR_INTID_THRE) // Transmit Holding Empty
 	{
-		for (i=0; i<UART_TX_FIFO_SIZE; i++) // fill transmit FIFO
+		for (i=0; i<UART_TX_FIFO_SIZE; i+=len) // fill transmit FIFO
 		{
-			if (m_tq.read(&c))
-			{
-				m_flag = true;
-				m_uart->THR = c;
-			}
+			if ((len=m_tq.peek(&data))==0)
+				break;
+			if (len>UART_TX_FIFO_SIZE-i)
+				len = UART_TX_FIFO_SIZE-i;
+			for (j=0; j<len; j++)
+				m_uart->THR = data[j];
+			m_tq.consume(len);
+			m_flag = true;
 		}
 	}
 }
@@ -77,7 +80,7 @@ int Uart::close()
 
 int Uart::receive(uint8_t *buf, uint32_t len)
 {
-	return 0;
+	return m_rq.read(buf, len);
 }
 
 int Uart::update()
@@ -24,7 +24,9 @@
 #include "lpc43xx.h"
 #include "misc.h"
 
-#define GBUF_SIZE 64
+#define GBUF_SIZE 512 // a high-speed packet, the longest first transfer chirp negotiates
+
+extern volatile uint32_t DevStatusFS2HS;
 
 uint8_t g_buf[GBUF_SIZE];
 uint32_t g_bufUsed = 0;
@@ -120,6 +122,19 @@ int USBLink::receive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
 }
 
 
+// A packet has come in for the receive service() posted, or there's no receive
+// posted yet (or we're not configured) and service() has to be called to post one.
+bool usbPending()
+{
+	return g_bufUsed==0 || g_recvComplete;
+}
+
+// bulk packet size, which is what chirp's first transfer can grow to
+uint32_t USBLink::blockSize()
+{
+	return DevStatusFS2HS ? 512 : USB_DEV_BUFSIZE;
+}
+
 void USBLink::setTimer()
 {
 	::setTimer(&m_timer);
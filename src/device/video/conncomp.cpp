@@ -172,9 +172,15 @@ void cc_loadParams(void)
 		"@c Signature_creation Sets how inclusive the color code (CC) signatures are with respect to saturation for color codes. Applies during teaching. (default 50.0)", FLT32(50.0), END);
 	prm_add("Color code mode", 0,
 		"Sets the color code mode, 0=disabled, 1=enabled, 2=color codes only, 3=mixed (default 1)", INT8(1), END);
+	prm_add("Min run length", PRM_FLAG_ADVANCED,
+		"@c Noise_filter Sets how many pixels long a run of a signature's color within a row has to be, shorter runs are dropped as noise before blocks are put together. 0 or 1 keeps every run (default 0)", UINT8(0), END);
+	prm_add("Max run gap", PRM_FLAG_ADVANCED,
+		"@c Noise_filter Sets how many pixels apart two runs of a signature's color within a row can be and still be joined into one. 0 leaves them apart (default 0)", UINT8(0), END);
+	prm_add("Vertical run filter", PRM_FLAG_ADVANCED,
+		"@c Noise_filter Sets how runs are filtered between rows, 0=none, 1=open (drop runs with nothing of their signature in the row above or below), 2=close (fill one-row gaps between runs above and below), 3=both (default 0)", UINT8(0), END);
 
 	// load
-	uint8_t ccMode;
+	uint8_t ccMode, minRunLength, maxRunGap, verticalRunFilter;
 	uint16_t maxBlobs, maxBlobsPerModel;
 	uint32_t minArea;
 
@@ -183,6 +189,10 @@ void cc_loadParams(void)
 	prm_get("Min block area", &minArea, END);
 	prm_get("Color code mode", &ccMode, END);
 	g_blobs->setParams(maxBlobs, maxBlobsPerModel, minArea, (ColorCodeMode)ccMode);
+	prm_get("Min run length", &minRunLength, END);
+	prm_get("Max run gap", &maxRunGap, END);
+	prm_get("Vertical run filter", &verticalRunFilter, END);
+	g_blobs->setRunFilter(minRunLength, maxRunGap, verticalRunFilter);
 
 	cc_loadLut();
 
@@ -335,13 +345,19 @@ int32_t cc_clearAllSig()
 
 	memset(&cmodel, 0, sizeof(cmodel));
 
+	// write all signatures to flash at once
+	prm_begin();
    	for (model=1; model<=NUM_MODELS; model++)
 	{
 		sprintf(id, "signature%d", model);
 		res = prm_set(id, INTS8(sizeof(ColorModel), &cmodel), END);
 		if (res<0)
-			return res;			
+			break;			
 	}
+	if (prm_commit()<0 && res>=0)
+		res = -1;
+	if (res<0)
+		return res;
 
 	// update lut
  	cc_loadLut();
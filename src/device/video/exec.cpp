@@ -24,8 +24,10 @@
 #include "serial.h"
 #include "rcservo.h"
 #include "progpt.h"
+#include "tracker.h"
 #include "progchase.h"
 #include "param.h"
+#include "scheduler.h"
 
 static const ProcModule g_module[] =
 {
@@ -213,6 +215,8 @@ static ChirpProc g_runningM0 = -1;
 static ChirpProc g_stopM0 = -1;
 static Program *g_progTable[EXEC_MAX_PROGS];
 static void loadParams();
+static void serviceUsb();
+static void checkParams();
 
 ButtonMachine *g_bMachine = NULL;
 
@@ -229,6 +233,15 @@ int exec_init(Chirp *chirp)
 
 	loadParams();		
 
+	// the main loop's housekeeping, see exec_loop()
+	sched_init();
+	sched_addTask(SCHED_USB, serviceUsb);
+	// The button can grab frames (teaching), which it mustn't do while the M0 is running.
+	// exec_loop() stops the M0 right after the pass that sets g_override, so the button is
+	// only handled in that pass, never in a program's sched_wait().
+	sched_addTask(SCHED_TIMER|SCHED_MAIN, exec_periodic);
+	sched_addTask(0, checkParams);
+
 	return 0;	
 }
 
@@ -289,7 +302,7 @@ int32_t exec_runprog(const uint8_t &progNum)
 		prm_get("Default program", &program, END);
 		if (program==0 || program>EXEC_MAX_PROGS)
 			g_program = 0;
-		if (g_progTable[program-1]!=NULL)
+		else if (g_progTable[program-1]!=NULL)
 			g_program = program-1;
 	}
   	else
@@ -364,6 +377,36 @@ void exec_periodic()
 {
 	periodic();
 	g_override = g_bMachine->handleSignature();
+}
+
+static void serviceUsb()
+{
+	while(g_chirpUsb->service());
+}
+
+static void checkParams()
+{
+	static uint16_t transaction = 0;
+	static uint32_t timer;
+	uint16_t t = prm_transaction();
+
+	// A host that began a transaction and went away would leave every prm_set() after
+	// it, button teaching included, in RAM until power-off.  So what's staged is
+	// committed once the transaction has been open for EXEC_PRM_TIMEOUT.
+	if (t==0)
+		transaction = 0;
+	else if (t!=transaction)
+	{
+		transaction = t;
+		setTimer(&timer);
+	}
+	else if (getTimer(timer)>EXEC_PRM_TIMEOUT)
+	{
+		cprintf("Parameter transaction left open, committing it\n");
+		prm_end();
+		transaction = 0;
+	}
+
 	if (prm_dirty())
 		exec_loadParams();
 }
@@ -396,6 +439,7 @@ void exec_loadParams()
 	cam_loadParams();
 	rcs_loadParams();
 
+	trk_loadParams();
 	ptLoadParams();
 	//chaseLoadParams();
 
@@ -415,7 +459,8 @@ void exec_loop()
 	{
 		connected = g_chirpUsb->connected();
 
-		exec_periodic();
+		// host requests, the button and parameter changes, whichever are due
+		sched_run();
 
 		switch (state)
 		{
@@ -24,6 +24,7 @@
 
 #define EXEC_MAX_PROGS   8
 #define EXEC_VIDEO_PROG  EXEC_MAX_PROGS
+#define EXEC_PRM_TIMEOUT 10000000 // us, a parameter transaction left open longer is committed
 
 typedef int (*ProgFunc)();
 
@@ -30,6 +30,8 @@
 #include "progchase.h"
 #include "param.h"
 #include "serial.h"
+#include "perf.h"
+#include "tracker.h"
 
 // M0 code 
 const // so m0 program goes into RO memory
@@ -58,11 +60,13 @@ int main(void)
 	cc_init(g_chirpUsb);
 	ser_init();
 	exec_init(g_chirpUsb);
+	perf_init(g_chirpUsb);
 
 #if 1
 	// load programs
 
 	exec_addProg(&g_progBlobs);
+	trk_loadParams();
 	ptLoadParams();
 	exec_addProg(&g_progPt);
 #if 0
@@ -19,6 +19,9 @@
 #include "conncomp.h"
 #include "serial.h"
 #include "rcservo.h"
+#include "perf.h"
+#include "scheduler.h"
+#include "tracker.h"
 
 
 Program g_progBlobs =
@@ -44,6 +47,7 @@ int blobsSetup()
 
 	// setup qqueue and M0
 	g_qqueue->flush();
+	trk_reset();
 	exec_runM0(0);
 
 	// flush serial receive queue
@@ -97,23 +101,32 @@ int blobsLoop()
 	BlobA *blobs;
 	BlobB *ccBlobs;
 	uint32_t numBlobs, numCCBlobs;
+	PERF_DECLARE(frame);
+	PERF_DECLARE(timer);
 
+	PERF_START(frame);
 	// create blobs
 	g_blobs->blobify();
+	// where the target's going, the window for the frames after this
+	trk_update(g_blobs);
 
 	// handle received data immediately
 	handleRecv();
 
 	// send blobs
 	g_blobs->getBlobs(&blobs, &numBlobs, &ccBlobs, &numCCBlobs);
+	PERF_START(timer);
 	cc_sendBlobs(g_chirpUsb, blobs, numBlobs, ccBlobs, numCCBlobs);
+	PERF_STOP(PERF_USB, timer);
 
 	ser_getSerial()->update();
 
 	cc_setLED();
+	PERF_STOP(PERF_FRAME, frame);
 	
-	// deal with any latent received data until the next frame comes in
-	while(!g_qqueue->queued())
+	// deal with received data as it comes in until the next frame does, the
+	// scheduler takes care of the host and everything else meanwhile
+	while(sched_wait(SCHED_FRAME|SCHED_SERIAL)==SCHED_SERIAL)
 		handleRecv();
 
 	return 0;
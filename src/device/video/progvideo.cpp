@@ -84,7 +84,7 @@ void sendCMV1(uint8_t renderFlags=RENDER_FLAG_FLUSH)
 int videoLoop()
 {
 	if (g_execArg==0)
-		cam_getFrameChirp(CAM_GRAB_M1R2, 0, 0, CAM_RES2_WIDTH, CAM_RES2_HEIGHT, g_chirpUsb);
+		cam_streamFrameChirp(CAM_GRAB_M1R2, 0, 0, CAM_RES2_WIDTH, CAM_RES2_HEIGHT, g_chirpUsb);
 	else 
 		sendCMV1();
 	return 0;
@@ -0,0 +1,123 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include "pixy_init.h"
+#include "misc.h"
+#include "conncomp.h"
+#include "serial.h"
+#include "scheduler.h"
+
+struct Task
+{
+	uint32_t events;
+	TaskFunc func;
+};
+
+static Task g_tasks[SCHED_MAX_TASKS];
+static uint8_t g_numTasks = 0;
+static uint8_t g_background = 0; // next background task's turn
+static uint32_t g_tick;
+static uint32_t g_mainEvents = 0; // events since the last main pass, for SCHED_MAIN tasks
+
+int sched_init()
+{
+	g_numTasks = 0;
+	g_background = 0;
+	g_mainEvents = 0;
+	setTimer(&g_tick);
+
+	return 0;
+}
+
+int sched_addTask(uint32_t events, TaskFunc task)
+{
+	if (g_numTasks>=SCHED_MAX_TASKS)
+		return -1;
+
+	g_tasks[g_numTasks].events = events;
+	g_tasks[g_numTasks].func = task;
+	g_numTasks++;
+
+	return 0;
+}
+
+static uint32_t poll()
+{
+	uint32_t events = 0;
+
+	if (g_qqueue->queued())
+		events |= SCHED_FRAME;
+	if (ser_getSerial()->receiveLen())
+		events |= SCHED_SERIAL;
+	if (usbPending())
+		events |= SCHED_USB;
+	if (getTimer(g_tick)>=SCHED_TICK_PERIOD)
+	{
+		setTimer(&g_tick);
+		events |= SCHED_TIMER;
+	}
+
+	return events;
+}
+
+uint32_t sched_run(bool main)
+{
+	uint8_t i, n;
+	uint32_t events = poll();
+
+	g_mainEvents |= events;
+
+	// tasks waiting on events, in the order they were added
+	for (i=0; i<g_numTasks; i++)
+	{
+		if (g_tasks[i].events&SCHED_MAIN)
+		{
+			if (main && (g_tasks[i].events&g_mainEvents&~SCHED_MAIN))
+				(*g_tasks[i].func)();
+		}
+		else if (g_tasks[i].events&events)
+			(*g_tasks[i].func)();
+	}
+	if (main)
+		g_mainEvents = 0;
+
+	// then the next background task
+	for (n=0; n<g_numTasks; n++)
+	{
+		i = g_background++;
+		if (g_background>=g_numTasks)
+			g_background = 0;
+		if ((g_tasks[i].events&~SCHED_MAIN)==0 && (main || g_tasks[i].events==0))
+		{
+			(*g_tasks[i].func)();
+			break;
+		}
+	}
+
+	return events;
+}
+
+uint32_t sched_wait(uint32_t events)
+{
+	uint32_t pending;
+
+	while(1)
+	{
+		pending = sched_run(false)&events;
+		if (pending)
+			return pending;
+		waitEvent();
+	}
+}
@@ -0,0 +1,47 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include <inttypes.h>
+
+// A cooperative scheduler for the M4's main loop.  Events are polled from their
+// sources once per pass, tasks run when an event they're waiting on is pending,
+// and background tasks take turns, one per pass, whatever else is going on.
+// Nothing is preempted-- a task runs to completion before the next one starts.
+#define SCHED_FRAME         0x01 // the M0 has queued frame data (Qqueue)
+#define SCHED_SERIAL        0x02 // the serial port has received data
+#define SCHED_USB           0x04 // the host has sent a chirp request
+#define SCHED_TIMER         0x08 // SCHED_TICK_PERIOD has gone by
+// flag: the task only runs in the main loop's own pass, not in the passes a program makes
+// in sched_wait().  The events it waits on are kept for it until then.
+#define SCHED_MAIN          0x80000000
+
+#define SCHED_TICK_PERIOD   10000 // us
+#define SCHED_MAX_TASKS     8
+
+typedef void (*TaskFunc)();
+
+int sched_init();
+// run task in each pass where one of events is pending, or in turn with the other
+// background tasks if events is 0
+int sched_addTask(uint32_t events, TaskFunc task);
+// one pass, returns the events that were pending.  main is false in sched_wait()'s passes.
+uint32_t sched_run(bool main=true);
+// passes until one of events is pending, returns those
+uint32_t sched_wait(uint32_t events);
+
+#endif
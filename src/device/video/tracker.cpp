@@ -0,0 +1,103 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <stdlib.h>
+#include "pixy_init.h"
+#include "cameravals.h"
+#include "param.h"
+#include "conncomp.h"
+#include "blobs.h"
+#include "perf.h"
+#include "tracker.h"
+
+static uint16_t g_signature = 0; // 0, not tracking
+static uint16_t g_margin;
+static bool g_locked = false;
+static int16_t g_x, g_y; // where the target was last frame
+static int16_t g_vx, g_vy; // and how far it had moved since the frame before
+
+void trk_loadParams()
+{
+	prm_add("Tracking signature", 0,
+		"@c Tracking Sets the signature of the target the blobs program tracks.  Once it's found only a window around it is processed, until it's lost, and other blocks are only seen if they're in the window.  0=disabled (default 0)", UINT16(0), END);
+	prm_add("Tracking margin", 0,
+		"@c Tracking Sets how many pixels the tracking window extends past the target in each direction, on top of how far it's moving (default 20)", UINT16(20), END);
+
+	prm_get("Tracking signature", &g_signature, END);
+	prm_get("Tracking margin", &g_margin, END);
+
+	trk_reset();
+}
+
+void trk_reset()
+{
+	g_locked = false;
+	g_qqueue->setWindow(0, 0, 0, 0);
+}
+
+void trk_update(Blobs *blobs)
+{
+	BlobA *blob;
+	int16_t x, y, width, height, left, top, right, bottom;
+
+	if (g_signature==0)
+		return;
+
+	blob = blobs->getMaxBlob(g_signature);
+	if (blob==NULL)
+	{
+		if (g_locked)
+		{
+			trk_reset();
+			PERF_COUNT(PERF_TRACK_LOST, 1);
+		}
+		return;
+	}
+
+	x = (blob->m_left + blob->m_right)/2;
+	y = (blob->m_top + blob->m_bottom)/2;
+	if (g_locked)
+	{
+		g_vx = x - g_x;
+		g_vy = y - g_y;
+	}
+	else
+		g_vx = g_vy = 0;
+	g_x = x;
+	g_y = y;
+	g_locked = true;
+
+	// where it's headed, with room for it to speed up or turn around on the way
+	x += g_vx*TRK_LOOKAHEAD;
+	y += g_vy*TRK_LOOKAHEAD;
+	width = (blob->m_right - blob->m_left)/2 + g_margin + abs(g_vx)*TRK_LOOKAHEAD;
+	height = (blob->m_bottom - blob->m_top)/2 + g_margin + abs(g_vy)*TRK_LOOKAHEAD;
+	left = x - width;
+	right = x + width;
+	top = y - height;
+	bottom = y + height;
+	if (left<0)
+		left = 0;
+	if (right>CAM_RES2_WIDTH)
+		right = CAM_RES2_WIDTH;
+	if (top<0)
+		top = 0;
+	if (bottom>CAM_RES2_HEIGHT)
+		bottom = CAM_RES2_HEIGHT;
+	if (left>=right || top>=bottom) // headed out of the frame
+		trk_reset();
+	else
+		g_qqueue->setWindow(left, top, right-left, bottom-top);
+}
@@ -0,0 +1,37 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef _TRACKER_H
+#define _TRACKER_H
+
+#include <inttypes.h>
+
+class Blobs;
+
+// Tracking for the blobs program.  Once the target (the biggest block of the
+// tracking signature) is found, the M0 segments frames only in a window around
+// where it's headed (see qqueue.h), so there's less to segment, unpack and
+// assemble, and a frame is done with sooner.  Other blocks are only seen if
+// they're in the window.  If the target isn't in its window it's lost, and
+// frames are whole again until it's found.
+#define TRK_LOOKAHEAD       2 // frames, the M0 may have started the next one by the time a window is set
+
+void trk_loadParams();
+// nothing locked, whole frames
+void trk_reset();
+// after blobify(), sets the window for the frames to come
+void trk_update(Blobs *blobs);
+
+#endif
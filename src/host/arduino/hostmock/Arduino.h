@@ -0,0 +1,75 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// Just enough of the Arduino core for the Pixy library to build on a host, see
+// pixyreplay.cpp.  What Pixy sends comes from a file, in the order it would have
+// gone out of the data out port, Serial prints to stdout.
+
+#ifndef _HOSTMOCK_ARDUINO_H
+#define _HOSTMOCK_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool boolean;
+
+// Pixy's side of the port, the stream of 16-bit words it sends, low byte first.
+// Past the end it sends zeros, like Pixy with nothing to say.
+int mock_open(const char *filename);
+uint8_t mock_getByte();
+bool mock_done();
+extern uint32_t mock_transactions; // requestFrom()s, transfer()s or read()s
+
+class MockSerial
+{
+public:
+  void begin(uint32_t baudrate)
+  {
+  }
+  void print(const char *s)
+  {
+    fputs(s, stdout);
+  }
+  void println(const char *s)
+  {
+    puts(s);
+  }
+};
+
+// the UART Pixy is on
+class MockSerial1 : public MockSerial
+{
+public:
+  int available()
+  {
+    return mock_done() ? 0 : 1;
+  }
+  int read()
+  {
+    mock_transactions++;
+    return mock_getByte();
+  }
+};
+
+extern MockSerial Serial;
+extern MockSerial1 Serial1;
+
+inline void delayMicroseconds(unsigned int us)
+{
+}
+
+#endif
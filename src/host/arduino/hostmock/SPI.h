@@ -0,0 +1,68 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef _HOSTMOCK_SPI_H
+#define _HOSTMOCK_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_CLOCK_DIV16 0x01
+
+// Pixy as an SPI slave, it clocks out 16-bit words, high byte first.  Each
+// transfer() is a transaction.
+class SPIClass
+{
+public:
+  void begin()
+  {
+    m_odd = false;
+  }
+  void setClockDivider(uint8_t div)
+  {
+  }
+  uint8_t transfer(uint8_t data)
+  {
+    mock_transactions++;
+    return next();
+  }
+  void transfer(void *buf, size_t count)
+  {
+    uint8_t *buf8 = (uint8_t *)buf;
+
+    mock_transactions++;
+    while (count--)
+      *buf8++ = next();
+  }
+
+private:
+  uint8_t next()
+  {
+    if (m_odd)
+    {
+      m_odd = false;
+      return m_low;
+    }
+    m_low = mock_getByte();
+    m_odd = true;
+    return mock_getByte();
+  }
+
+  bool m_odd;
+  uint8_t m_low;
+};
+
+extern SPIClass SPI;
+
+#endif
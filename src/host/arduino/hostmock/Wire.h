@@ -0,0 +1,61 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef _HOSTMOCK_WIRE_H
+#define _HOSTMOCK_WIRE_H
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH   32
+
+// Pixy as an I2C slave, each requestFrom() is a transaction
+class TwoWire
+{
+public:
+  void begin()
+  {
+    m_len = 0;
+    m_index = 0;
+  }
+  uint8_t requestFrom(int address, int quantity)
+  {
+    if (quantity>BUFFER_LENGTH)
+      quantity = BUFFER_LENGTH;
+    mock_transactions++;
+    for (m_len=0; m_len<quantity; m_len++)
+      m_buf[m_len] = mock_getByte();
+    m_index = 0;
+    return m_len;
+  }
+  int available()
+  {
+    return m_len - m_index;
+  }
+  int read()
+  {
+    if (m_index>=m_len)
+      return -1;
+    return m_buf[m_index++];
+  }
+
+private:
+  uint8_t m_buf[BUFFER_LENGTH];
+  uint8_t m_len;
+  uint8_t m_index;
+};
+
+extern TwoWire Wire;
+
+#endif
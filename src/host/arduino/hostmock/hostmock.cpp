@@ -0,0 +1,53 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "SPI.h"
+
+MockSerial Serial;
+MockSerial1 Serial1;
+TwoWire Wire;
+SPIClass SPI;
+
+uint32_t mock_transactions = 0;
+
+static FILE *g_file = NULL;
+static bool g_done = false;
+
+int mock_open(const char *filename)
+{
+  g_file = fopen(filename, "rb");
+  g_done = false;
+  mock_transactions = 0;
+  return g_file ? 0 : -1;
+}
+
+uint8_t mock_getByte()
+{
+  int c;
+
+  if (g_file==NULL || (c=fgetc(g_file))==EOF)
+  {
+    g_done = true;
+    return 0;
+  }
+  return c;
+}
+
+bool mock_done()
+{
+  return g_done;
+}
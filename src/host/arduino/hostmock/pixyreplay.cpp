@@ -0,0 +1,123 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// pixyreplay -- runs what Pixy sent (pixy-sim -o) through the Arduino library on this
+// machine, over each link as an Arduino would read it, and counts the frames, blocks
+// and bus transactions it took.  The links should all see the same blocks, the
+// buffered ones in far fewer transactions.  -f uses a fixed-size block array.
+
+#include <unistd.h>
+#include "Pixy.h"
+#include "PixyI2C.h"
+#include "PixyUART.h"
+
+#define FIXED_SIZE      20 // blocks, with -f
+#define MAX_CALLS       10000000 // getBlocks() calls, in case the stream never ends
+
+static bool g_verbose = false;
+
+template <class PixyType> static int replay(const char *name, const char *filename)
+{
+  PixyType pixy;
+  uint32_t i, calls, frames=0, blocks=0;
+  uint16_t n;
+
+  if (mock_open(filename)<0)
+  {
+    fprintf(stderr, "pixyreplay: unable to open %s\n", filename);
+    return -1;
+  }
+  pixy.init();
+  for (calls=0; !mock_done() && calls<MAX_CALLS; calls++)
+  {
+    if ((n=pixy.getBlocks())==0)
+      continue;
+    frames++;
+    blocks += n;
+    if (g_verbose)
+    {
+      for (i=0; i<n; i++)
+        pixy.blocks[i].print();
+    }
+  }
+  printf("%-10s %8u frames %8u blocks %10u transactions\n", name, frames, blocks, mock_transactions);
+  return 0;
+}
+
+template <uint16_t FixedSize> static int replayAll(const char *link, const char *filename)
+{
+  static const char *names[] = {"spi", "spibuf", "i2c", "i2cbuf", "uart"};
+  int res = 0;
+  uint32_t i;
+
+  for (i=0; i<sizeof(names)/sizeof(names[0]); i++)
+  {
+    if (link && strcmp(link, names[i]))
+      continue;
+    if (i==0)
+      res |= replay<TPixy<LinkSPI, FixedSize> >(names[i], filename);
+    else if (i==1)
+      res |= replay<TPixy<LinkSPIBuffered, FixedSize> >(names[i], filename);
+    else if (i==2)
+      res |= replay<TPixy<LinkI2C, FixedSize> >(names[i], filename);
+    else if (i==3)
+      res |= replay<TPixy<LinkI2CBuffered, FixedSize> >(names[i], filename);
+    else
+      res |= replay<TPixy<LinkUART, FixedSize> >(names[i], filename);
+  }
+  return res;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: pixyreplay [options] file\n"
+    "  -l link     spi, spibuf, i2c, i2cbuf or uart (default all of them)\n"
+    "  -f          a fixed array of %d blocks\n"
+    "  -v          print the blocks\n",
+    FIXED_SIZE);
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  int c;
+  bool fixed = false;
+  const char *link = NULL;
+
+  while ((c=getopt(argc, argv, "l:fv"))!=-1)
+  {
+    switch (c)
+    {
+    case 'l':
+      link = optarg;
+      break;
+    case 'f':
+      fixed = true;
+      break;
+    case 'v':
+      g_verbose = true;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind!=argc-1)
+    usage();
+
+  if (fixed)
+    return replayAll<FIXED_SIZE>(link, argv[optind])<0 ? 1 : 0;
+  return replayAll<0>(link, argv[optind])<0 ? 1 : 0;
+}
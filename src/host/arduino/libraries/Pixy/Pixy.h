@@ -38,6 +38,7 @@
 #define PIXY_SYNC_BYTE              0x5a
 #define PIXY_SYNC_BYTE_DATA         0x5b
 #define PIXY_OUTBUF_SIZE            6
+#define PIXY_SPI_READ_SIZE          16 // words per transfer, LinkSPIBuffered
 
 class LinkSPI
 {
@@ -99,14 +100,72 @@ class LinkSPI
       addr_ = addr;
     }
 
-  private:
+  protected:
     uint8_t outBuf[PIXY_OUTBUF_SIZE];
     uint8_t outLen;
     uint8_t outIndex;
     uint8_t addr_;
 };
 
+// Reads PIXY_SPI_READ_SIZE words with one SPI.transfer() call rather than two calls
+// a word, and hands them out from there.  Data from send() goes out with the next
+// transfer, a word's sync byte at a time as with LinkSPI.
+class LinkSPIBuffered : public LinkSPI
+{
+  public:
+    void init()
+    {
+      LinkSPI::init();
+      inLen = 0;
+      inIndex = 0;
+    }
+
+    uint16_t getWord()
+    {
+      uint8_t i;
+
+      if (inIndex==inLen)
+      {
+        for (i=0; i<PIXY_SPI_READ_SIZE; i++)
+        {
+          if (outLen)
+          {
+            inBuf[i*2] = PIXY_SYNC_BYTE_DATA;
+            inBuf[i*2+1] = outBuf[outIndex++];
+            if (outIndex==outLen)
+              outLen = 0;
+          }
+          else
+          {
+            inBuf[i*2] = PIXY_SYNC_BYTE;
+            inBuf[i*2+1] = 0;
+          }
+        }
+        SPI.transfer(inBuf, PIXY_SPI_READ_SIZE*2); // in place, what comes back replaces what went out
+        inLen = PIXY_SPI_READ_SIZE;
+        inIndex = 0;
+      }
+      inIndex++;
+
+      return (uint16_t)inBuf[inIndex*2-2]<<8 | inBuf[inIndex*2-1];
+    }
+
+    uint8_t getByte()
+    {
+      // out of step by a byte, what's buffered is no good
+      inLen = 0;
+      inIndex = 0;
+      return LinkSPI::getByte();
+    }
+
+  private:
+    uint8_t inBuf[PIXY_SPI_READ_SIZE*2];
+    uint8_t inLen;
+    uint8_t inIndex;
+};
+
 
 typedef TPixy<LinkSPI> Pixy;
+typedef TPixy<LinkSPIBuffered> PixyBuffered;
 
 #endif
@@ -19,6 +19,12 @@
 #include "TPixy.h"
 #include "Wire.h"
 
+#ifdef BUFFER_LENGTH
+#define PIXY_I2C_READ_SIZE  BUFFER_LENGTH // as much as Wire holds
+#else
+#define PIXY_I2C_READ_SIZE  32
+#endif
+
 class LinkI2C
 {
 public:
@@ -47,10 +53,33 @@ public:
 	return Wire.read();
   }
   
-private:
+protected:
   uint8_t addr;
 };
 
+// Reads PIXY_I2C_READ_SIZE bytes a transaction, a couple of blocks, rather than a
+// transaction a word, and hands them out from Wire's buffer.  Talking to another
+// device in between throws away what's left, which costs a frame.
+class LinkI2CBuffered : public LinkI2C
+{
+public:
+  uint16_t getWord()
+  {
+    uint16_t w;
+
+    w = getByte();
+    w |= (uint16_t)getByte()<<8;
+    return w;
+  }
+  uint8_t getByte()
+  {
+    if (Wire.available()==0 && Wire.requestFrom((int)addr, PIXY_I2C_READ_SIZE)==0)
+      return 0;
+    return Wire.read();
+  }
+};
+
 typedef TPixy<LinkI2C> PixyI2C;
+typedef TPixy<LinkI2CBuffered> PixyI2CBuffered;
 
 #endif
@@ -30,12 +30,25 @@
 #define PIXY_START_WORD             0xaa55
 #define PIXY_START_WORD_CC          0xaa56
 #define PIXY_START_WORDX            0x55aa
+#define PIXY_START_WORD_V2          0xaa57 // "Data out protocol" 1
+#define PIXY_START_WORDX_V2         0x57aa
+#define PIXY_V2_BLOCK_SIZE          5
+#define PIXY_V2_CC_BLOCK_SIZE       8
+#define PIXY_START_WORD_DELTA       0xaa58 // "Data out protocol" 2
+#define PIXY_START_WORDX_DELTA      0x58aa
+#define PIXY_V2_MAX_LEN             902 // blocks in a frame, bytes
+#define PIXY_DELTA_SMALL            1
+#define PIXY_DELTA_LARGE            2
+#define PIXY_DELTA_NEW              3
+#define PIXY_DELTA_ANGLE            0x40
 #define PIXY_DEFAULT_ADDR           0x54  // I2C
 
 enum BlockType
 {
 	NORMAL_BLOCK,
-	CC_BLOCK
+	CC_BLOCK,
+	V2_FRAME,
+	V2_DELTA_FRAME
 };
 
 struct Block 
@@ -68,7 +81,13 @@ struct Block
 
 
 
-template <class LinkType> class TPixy
+// FixedSize is how many blocks the block array holds, or 0 for one that grows as
+// frames need it (up to PIXY_MAXIMUM_ARRAYSIZE).  A fixed array, and the spare one
+// delta frames are decoded into, are part of the object, so nothing is allocated or
+// reallocated in the middle of a frame, and a frame with more blocks than that is cut
+// short.  (Delta frames need all of the last frame, so only their keyframes get
+// through a cut.)
+template <class LinkType, uint16_t FixedSize=0> class TPixy
 {
 public:
   TPixy(uint8_t addr=PIXY_DEFAULT_ADDR);
@@ -79,39 +98,75 @@ public:
   void init();
   
   Block *blocks;
+  uint8_t frame; // counter from the last v2 frame, it skips if frames were dropped
 	
 private:
   boolean getStart();
   void resize();
+  uint16_t getBlocksV2(uint16_t maxBlocks);
+  void getBlockV2(Block *block);
+  uint8_t getByteV2();
+  static uint16_t crc16(uint16_t crc, uint8_t c);
+
+  static const uint16_t maxArraySize = FixedSize ? FixedSize : PIXY_MAXIMUM_ARRAYSIZE;
 
   LinkType link;
   boolean  skipStart;
   BlockType blockType;
   uint16_t blockCount;
   uint16_t blockArraySize;
+  uint16_t v2Word;
+  boolean  v2Odd;
+  uint16_t v2Crc;
+  uint16_t v2Read;
+  Block   *spareBlocks; // for delta frames
+  uint16_t refCount;
+  uint8_t  refFrame;
+  boolean  refValid;
+  Block    fixedBlocks[FixedSize ? FixedSize : 1];
+  Block    fixedSpare[FixedSize ? FixedSize : 1];
 };
 
 
-template <class LinkType> TPixy<LinkType>::TPixy(uint8_t addr)
+template <class LinkType, uint16_t FixedSize> TPixy<LinkType, FixedSize>::TPixy(uint8_t addr)
 {
   skipStart = false;
   blockCount = 0;
-  blockArraySize = PIXY_INITIAL_ARRAYSIZE;
-  blocks = (Block *)malloc(sizeof(Block)*blockArraySize);
+  frame = 0;
+  spareBlocks = NULL;
+  refCount = 0;
+  refFrame = 0;
+  refValid = false;
+  if (FixedSize)
+  {
+    blockArraySize = FixedSize;
+    blocks = fixedBlocks;
+    spareBlocks = fixedSpare;
+  }
+  else
+  {
+    blockArraySize = PIXY_INITIAL_ARRAYSIZE;
+    blocks = (Block *)malloc(sizeof(Block)*blockArraySize);
+  }
   link.setAddress(addr);
 }
 
-template <class LinkType> void TPixy<LinkType>::init()
+template <class LinkType, uint16_t FixedSize> void TPixy<LinkType, FixedSize>::init()
 {
   link.init();
 }
 
-template <class LinkType> TPixy<LinkType>::~TPixy()
+template <class LinkType, uint16_t FixedSize> TPixy<LinkType, FixedSize>::~TPixy()
 {
-  free(blocks);
+  // delta frames swap the two arrays, fixed ones weren't allocated
+  if (FixedSize==0)
+  {
+    free(blocks);
+    free(spareBlocks);
+  }
 }
 
-template <class LinkType> boolean TPixy<LinkType>::getStart()
+template <class LinkType, uint16_t FixedSize> boolean TPixy<LinkType, FixedSize>::getStart()
 {
   uint16_t w, lastw;
  
@@ -135,7 +190,17 @@ template <class LinkType> boolean TPixy<LinkType>::getStart()
       blockType = CC_BLOCK;
       return true;
 	}	
-	else if (w==PIXY_START_WORDX)
+    else if (w==PIXY_START_WORD_V2)
+	{
+      blockType = V2_FRAME;
+      return true;
+	}
+    else if (w==PIXY_START_WORD_DELTA)
+	{
+      blockType = V2_DELTA_FRAME;
+      return true;
+	}
+	else if (w==PIXY_START_WORDX || w==PIXY_START_WORDX_V2 || w==PIXY_START_WORDX_DELTA)
 	{
 	  Serial.println("reorder");
 	  link.getByte(); // resync
@@ -144,13 +209,17 @@ template <class LinkType> boolean TPixy<LinkType>::getStart()
   }
 }
 
-template <class LinkType> void TPixy<LinkType>::resize()
+template <class LinkType, uint16_t FixedSize> void TPixy<LinkType, FixedSize>::resize()
 {
+  if (FixedSize) // it stays the size it is
+    return;
   blockArraySize += PIXY_INITIAL_ARRAYSIZE;
   blocks = (Block *)realloc(blocks, sizeof(Block)*blockArraySize);
+  if (spareBlocks)
+    spareBlocks = (Block *)realloc(spareBlocks, sizeof(Block)*blockArraySize);
 }  
 		
-template <class LinkType> uint16_t TPixy<LinkType>::getBlocks(uint16_t maxBlocks)
+template <class LinkType, uint16_t FixedSize> uint16_t TPixy<LinkType, FixedSize>::getBlocks(uint16_t maxBlocks)
 {
   uint8_t i;
   uint16_t w, checksum, sum;
@@ -163,8 +232,11 @@ template <class LinkType> uint16_t TPixy<LinkType>::getBlocks(uint16_t maxBlocks
   }
   else
 	skipStart = false;
+
+  if (blockType==V2_FRAME || blockType==V2_DELTA_FRAME)
+    return getBlocksV2(maxBlocks);
 	
-  for(blockCount=0; blockCount<maxBlocks && blockCount<PIXY_MAXIMUM_ARRAYSIZE;)
+  for(blockCount=0; blockCount<maxBlocks && blockCount<maxArraySize;)
   {
     checksum = link.getWord();
     if (checksum==PIXY_START_WORD) // we've reached the beginning of the next frame
@@ -183,7 +255,7 @@ template <class LinkType> uint16_t TPixy<LinkType>::getBlocks(uint16_t maxBlocks
     else if (checksum==0)
       return blockCount;
     
-	if (blockCount>blockArraySize)
+	if (blockCount>=blockArraySize)
 		resize();
 	
 	block = blocks + blockCount;
@@ -213,9 +285,172 @@ template <class LinkType> uint16_t TPixy<LinkType>::getBlocks(uint16_t maxBlocks
 	else
       return blockCount;
   }
+  return blockCount;
+}
+
+// the v2 frame after its start word, see Blobs::encodeFrame() and encodeDeltaFrame()
+// in Pixy's firmware.  The whole frame is kept (as much of it as the array holds),
+// whatever maxBlocks is, since the next delta frame may change any of it.
+template <class LinkType, uint16_t FixedSize> uint16_t TPixy<LinkType, FixedSize>::getBlocksV2(uint16_t maxBlocks)
+{
+  uint16_t w, count, len, crc, n, ref;
+  uint8_t c, flags, nibble, refCounter=0, next[16];
+  boolean delta = blockType==V2_DELTA_FRAME;
+  Block block, *frameBlocks, *swap;
+
+  w = link.getWord();
+  len = link.getWord();
+  crc = link.getWord();
+  if (len>PIXY_V2_MAX_LEN)
+    return 0;
+  count = w>>8;
+  // the crc covers the header after the start word, but not itself
+  v2Crc = crc16(crc16(crc16(crc16(0xffff, w&0xff), w>>8), len&0xff), len>>8);
+  v2Odd = false;
+  v2Read = 0;
+
+  while (count>blockArraySize && blockArraySize<maxArraySize)
+    resize();
+  // a delta frame needs the last one while it's decoded, so it goes in the spare array
+  if (delta)
+  {
+    if (spareBlocks==NULL)
+      spareBlocks = (Block *)malloc(sizeof(Block)*blockArraySize);
+    frameBlocks = spareBlocks;
+    refCounter = getByteV2();
+    getByteV2();
+    memset(next, 0, sizeof(next));
+  }
+  else
+    frameBlocks = blocks;
+
+  for (n=0; v2Read<len; n++)
+  {
+    if (delta)
+    {
+      flags = getByteV2();
+      nibble = flags&0x0f;
+      // the last frame's next block with this signature
+      for (ref=next[nibble]; ref<refCount && (blocks[ref].signature>7 ? 0 : blocks[ref].signature)!=nibble; ref++);
+      next[nibble] = ref+1;
+      if (((flags>>4)&0x03)==PIXY_DELTA_NEW)
+        getBlockV2(&block);
+      else if (ref<refCount)
+      {
+        block = blocks[ref];
+        if (((flags>>4)&0x03)==PIXY_DELTA_SMALL)
+        {
+          c = getByteV2();
+          block.x += (int8_t)(c<<4)>>4;
+          block.y += (int8_t)c>>4;
+          c = getByteV2();
+          block.width += (int8_t)(c<<4)>>4;
+          block.height += (int8_t)c>>4;
+        }
+        else if (((flags>>4)&0x03)==PIXY_DELTA_LARGE)
+        {
+          block.x += (int8_t)getByteV2();
+          block.y += (int8_t)getByteV2();
+          block.width += (int8_t)getByteV2();
+          block.height += (int8_t)getByteV2();
+        }
+        if (flags&PIXY_DELTA_ANGLE)
+          block.angle += (int8_t)getByteV2();
+      }
+      else // nothing to change, we've lost track
+        break;
+    }
+    else
+      getBlockV2(&block);
+
+    if (frameBlocks && n<blockArraySize)
+      frameBlocks[n] = block;
+  }
+  while (v2Read<len) // rest of a bad frame, it'll fail the crc
+    getByteV2();
+
+  if (v2Crc!=crc || v2Read!=len || n!=count || frameBlocks==NULL ||
+      (delta && (!refValid || refCounter!=refFrame)))
+  {
+    if (!delta) // the last frame has been written over
+      refValid = false;
+    if (v2Crc!=crc)
+      Serial.println("crc error");
+    return 0;
+  }
+  if (delta)
+  {
+    swap = blocks;
+    blocks = spareBlocks;
+    spareBlocks = swap;
+  }
+  frame = w&0xff;
+  refFrame = frame;
+  refCount = n<blockArraySize ? n : blockArraySize;
+  refValid = true;
+  blockCount = refCount<maxBlocks ? refCount : maxBlocks;
+
+  return blockCount;
+}
+
+// a block as Blobs::encodeFrame() packs it
+template <class LinkType, uint16_t FixedSize> void TPixy<LinkType, FixedSize>::getBlockV2(Block *block)
+{
+  uint32_t bits;
+  uint8_t i, b[PIXY_V2_CC_BLOCK_SIZE];
+
+  for (i=0; i<PIXY_V2_BLOCK_SIZE; i++)
+    b[i] = getByteV2();
+  bits = b[0] | (uint32_t)b[1]<<8 | (uint32_t)b[2]<<16 | (uint32_t)b[3]<<24;
+  block->signature = bits&0x0f;
+  block->x = (bits>>4)&0x1ff;
+  block->y = (bits>>13)&0xff;
+  block->width = (bits>>21)&0x1ff;
+  block->height = (bits>>30) | (uint16_t)(b[4]&0x3f)<<2;
+  block->angle = 0;
+  if (block->signature==0) // color code, 3 more bytes
+  {
+    for (; i<PIXY_V2_CC_BLOCK_SIZE; i++)
+      b[i] = getByteV2();
+    block->signature = b[5] | (uint16_t)(b[6]&0x7f)<<8;
+    block->angle = b[6]>>7 | (uint16_t)b[7]<<1;
+    if (block->angle&0x100) // 9-bit signed
+      block->angle |= 0xfe00;
+  }
+}
+
+template <class LinkType, uint16_t FixedSize> uint8_t TPixy<LinkType, FixedSize>::getByteV2()
+{
+  uint8_t c;
+
+  // words come in the order Pixy sends them, whatever the link, so bytes are low then high
+  if (v2Odd)
+    c = v2Word>>8;
+  else
+  {
+    v2Word = link.getWord();
+    c = v2Word&0xff;
+  }
+  v2Odd = !v2Odd;
+  v2Crc = crc16(v2Crc, c);
+  v2Read++;
+
+  return c;
+}
+
+// same crc as Pixy's (CRC-16/CCITT), a bit at a time to save the Arduino's memory
+template <class LinkType, uint16_t FixedSize> uint16_t TPixy<LinkType, FixedSize>::crc16(uint16_t crc, uint8_t c)
+{
+  uint8_t i;
+
+  crc ^= (uint16_t)c<<8;
+  for (i=0; i<8; i++)
+    crc = crc&0x8000 ? (crc<<1)^0x1021 : crc<<1;
+
+  return crc;
 }
 
-template <class LinkType> int8_t TPixy<LinkType>::setServos(uint16_t s0, uint16_t s1)
+template <class LinkType, uint16_t FixedSize> int8_t TPixy<LinkType, FixedSize>::setServos(uint16_t s0, uint16_t s1)
 {
   uint8_t outBuf[6];
    
@@ -41,16 +41,41 @@ extern "C"
     int16_t  angle;
   };
 
+  /**
+    @brief Receives raw video frames from the "video" program a band of rows
+           at a time.  With the "Frame band rows" camera parameter set, bands
+           come in while Pixy is still grabbing the rest of the frame, otherwise
+           each frame is one band.  Called from libpixy's receive thread.
+    @param[in] width   Frame width
+    @param[in] height  Frame height
+    @param[in] row     First row of the band, 0 starts a new frame
+    @param[in] rows    Rows in the band
+    @param[in] pixels  Band's pixels (8-bit Bayer), good until the handler returns
+  */
+  typedef void (*pixy_frame_band_handler)(uint16_t width, uint16_t height, uint16_t row, uint16_t rows, const uint8_t * pixels);
+
   /**
     @brief Creates a connection with Pixy and listens for Pixy messages.
+           If the PIXY_ADDRESS environment variable is set, connects to it
+           as pixy_init_address() does instead of looking for Pixy on USB.
     @return  0                         Success
     @return  PIXY_ERROR_USB_IO         USB Error: I/O
     @return  PIXY_ERROR_NOT_FOUND      USB Error: Pixy not found
     @return  PIXY_ERROR_USB_BUSY       USB Error: Busy
     @return  PIXY_ERROR_USB_NO_DEVICE  USB Error: No device
+    @return  PIXY_ERROR_SOCKET         Socket Error: Unable to connect
   */
   int pixy_init();
 
+  /**
+    @brief Creates a connection with a Pixy that's served over a socket, by
+           pixyrelay on the machine it's plugged into, or by pixy-sim.
+    @param[in] address  "host:port", or the path of a Unix socket, NULL for USB.
+    @return  0                         Success
+    @return  PIXY_ERROR_SOCKET         Socket Error: Unable to connect
+  */
+  int pixy_init_address(const char *address);
+
   /**
     @brief      Copies up to 'max_blocks' number of Blocks to the address pointed
                 to by 'blocks'.
@@ -69,13 +94,67 @@ extern "C"
   int pixy_get_blocks(uint16_t max_blocks, struct Block * blocks);
 
   /**
-    @brief      Send a command to Pixy.
+    @brief      Send a command to Pixy.  Pointers it returns in the response
+                values (a frame's pixels, say) stay good until the next command.
     @param[in]  name  Chirp remote procedure call identifier string.
     @return     -1    Error
 
   */
   int pixy_command(const char *name, ...);
 
+  /**
+    @brief      Send a command to Pixy without waiting for its response, so several
+                commands (servo positions and LED color, say) can be in flight at once.
+    @param[in]  name  Chirp remote procedure call identifier string, followed by the
+                      call's arguments and END_OUT_ARGS.
+    @return     Positive  Ticket to pass to pixy_command_result()
+    @return     Negative  Error
+  */
+  int pixy_command_async(const char *name, ...);
+
+  /**
+    @brief      Wait for the response to a command sent with pixy_command_async().
+    @param[in]  ticket  Value returned by pixy_command_async(), followed by pointers
+                        for the response values and END_IN_ARGS.
+    @return     0         Success
+    @return     Negative  Error
+  */
+  int pixy_command_result(int ticket, ...);
+
+  /**
+    @brief      Send several commands to Pixy in one round trip, for setting a servo
+                pair and the LED color together, say.  Pixy runs them in order and
+                sends all of their responses back at once.  Older firmware doesn't
+                support this and returns an error.
+    @param[in]  name  Chirp remote procedure call identifier string, followed by the
+                      call's arguments and END_OUT_ARGS, then the next command's name
+                      and arguments, and so on, ending with NULL:
+
+                      pixy_command_batch("rcs_setPos", CRP_UINT8, 0, CRP_UINT16, 500, END_OUT_ARGS,
+                                         "rcs_setPos", CRP_UINT8, 1, CRP_UINT16, 500, END_OUT_ARGS,
+                                         "led_set", CRP_INT32, 0xff0000, END_OUT_ARGS, NULL);
+    @return     Positive  Number of commands run, see pixy_command_batch_result()
+    @return     Negative  Error
+  */
+  int pixy_command_batch(const char *name, ...);
+
+  /**
+    @brief      Get the response to one of the commands sent with pixy_command_batch().
+                The responses stay around until the next batch.
+    @param[in]  index  Which command, counting from 0, followed by pointers for the
+                       response values and END_IN_ARGS.
+    @return     0         Success
+    @return     Negative  Error
+  */
+  int pixy_command_batch_result(int index, ...);
+
+  /**
+    @brief      Set the handler that raw video frames are handed to as they arrive.
+    @param[in]  handler  See pixy_frame_band_handler, NULL for none (the default).
+                         Once this returns, the old handler isn't being called.
+  */
+  void pixy_set_frame_band_handler(pixy_frame_band_handler handler);
+
   /**
     @brief Terminates connection with Pixy.
   */
@@ -17,14 +17,14 @@
 #define __CHIRPRECEIVER_HPP__
 
 #include "chirp.hpp"
-#include "usblink.h"
+#include "link.h"
 #include "interpreter.hpp"
 
 class ChirpReceiver : public Chirp
 {
   public:
 
-    ChirpReceiver(USBLink * link, Interpreter * interpreter);
+    ChirpReceiver(Link * link, Interpreter * interpreter);
 
   private:
     
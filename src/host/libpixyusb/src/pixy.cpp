@@ -1,9 +1,22 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "pixy.h"
 #include "pixyinterpreter.hpp"
 
 PixyInterpreter interpreter;
 
+static int pixy_initialized = false;
+
+// Typed version of pixy_command(): the arguments go out as C++ values and the   //
+// response values are type checked, see chirptyped.hpp.                        //
+template <typename... Out, typename... In>
+static int pixy_typed_command(const char *name, const std::tuple<Out...> &out, In *... in)
+{
+  if(!pixy_initialized) return -1;
+
+  return interpreter.send_typed_command(name, out, in...);
+}
+
 // Pixy C API //
 
 extern "C" 
@@ -20,16 +33,20 @@ extern "C"
     { PIXY_ERROR_USB_NOT_FOUND,   "USB Error: Target not found" },
     { PIXY_ERROR_CHIRP,           "Chirp Protocol Error" },
     { PIXY_ERROR_INVALID_COMMAND, "Pixy Error: Invalid command" },
+    { PIXY_ERROR_SOCKET,          "Socket Error: Unable to connect" },
     { 0,                          0 }
   };
 
-  static int pixy_initialized = false;
-
   int pixy_init()
+  {
+    return pixy_init_address(getenv("PIXY_ADDRESS"));
+  }
+
+  int pixy_init_address(const char *address)
   {
     int return_value;
 
-    return_value = interpreter.init();
+    return_value = interpreter.init(address);
 
     if(return_value == 0) 
     {
@@ -58,6 +75,67 @@ extern "C"
     return return_value;
   }
 
+  int pixy_command_async(const char *name, ...)
+  {
+    va_list arguments;
+    int     return_value;
+
+    if(!pixy_initialized) return -1;
+
+    va_start(arguments, name);
+    return_value = interpreter.send_command_async(name, arguments);
+    va_end(arguments);
+
+    return return_value;
+  }
+
+  int pixy_command_result(int ticket, ...)
+  {
+    va_list arguments;
+    int     return_value;
+
+    if(!pixy_initialized) return -1;
+
+    va_start(arguments, ticket);
+    return_value = interpreter.get_command_result(ticket, arguments);
+    va_end(arguments);
+
+    return return_value;
+  }
+
+  int pixy_command_batch(const char *name, ...)
+  {
+    va_list arguments;
+    int     return_value;
+
+    if(!pixy_initialized) return -1;
+
+    va_start(arguments, name);
+    return_value = interpreter.send_command_batch(name, arguments);
+    va_end(arguments);
+
+    return return_value;
+  }
+
+  int pixy_command_batch_result(int index, ...)
+  {
+    va_list arguments;
+    int     return_value;
+
+    if(!pixy_initialized) return -1;
+
+    va_start(arguments, index);
+    return_value = interpreter.get_batch_result(index, arguments);
+    va_end(arguments);
+
+    return return_value;
+  }
+
+  void pixy_set_frame_band_handler(pixy_frame_band_handler handler)
+  {
+    interpreter.set_frame_band_handler(handler);
+  }
+
   void pixy_close()
   {
     if(!pixy_initialized) return;
@@ -95,7 +173,7 @@ extern "C"
     // Pack the RGB value //
     RGB = blue + (green << 8) + (red << 16);
 
-    return_value = pixy_command("led_set", CRP_INT32, RGB, END_OUT_ARGS, &chirp_response, END_IN_ARGS);
+    return_value = pixy_typed_command("led_set", std::make_tuple(RGB), &chirp_response);
 
     return return_value;
   }
@@ -105,7 +183,7 @@ extern "C"
     int chirp_response;
     int return_value;
 
-    return_value = pixy_command("led_setMaxCurrent", CRP_INT32, current, END_OUT_ARGS, &chirp_response, END_IN_ARGS);
+    return_value = pixy_typed_command("led_setMaxCurrent", std::make_tuple(current), &chirp_response);
 
     return return_value;
   }
@@ -115,7 +193,7 @@ extern "C"
     int      return_value;
     uint32_t chirp_response;
 
-    return_value = pixy_command("led_getMaxCurrent", END_OUT_ARGS, &chirp_response, END_IN_ARGS);
+    return_value = pixy_typed_command("led_getMaxCurrent", std::make_tuple(), &chirp_response);
 
     if (return_value < 0) {
       // Error //
@@ -270,7 +348,7 @@ extern "C"
     int chirp_response;
     int return_value;
 
-    return_value = pixy_command("rcs_getPos", CRP_INT8, channel, END_OUT_ARGS, &chirp_response, END_IN_ARGS);
+    return_value = pixy_typed_command("rcs_getPos", std::make_tuple(channel), &chirp_response);
 
     if (return_value < 0) {
       // Error //
@@ -290,7 +368,7 @@ extern "C"
       return PIXY_ERROR_INVALID_PARAMETER;
     }   
 
-    return_value = pixy_command("rcs_setPos", CRP_INT8, channel, CRP_INT16, position, END_OUT_ARGS, &chirp_response, END_IN_ARGS);
+    return_value = pixy_typed_command("rcs_setPos", std::make_tuple(channel, position), &chirp_response);
 
     return return_value;
   }
@@ -304,37 +382,36 @@ extern "C"
       return PIXY_ERROR_INVALID_PARAMETER;
     }
 
-    return_value = pixy_command("rcs_setFreq", CRP_INT16, frequency, END_OUT_ARGS, &chirp_response, END_IN_ARGS);
+    return_value = pixy_typed_command("rcs_setFreq", std::make_tuple(frequency), &chirp_response);
 
     return return_value;
   }
 
   int pixy_get_firmware_version(uint16_t * major, uint16_t * minor, uint16_t * build)
   {
-    uint16_t * pixy_version;
-    uint32_t   version_length;
+    chirp::Array<uint16_t> pixy_version;
     uint32_t   response;
-    uint16_t   version[3];
     int        return_value;
-    int        chirp_response;
 
     if(major == 0 || minor == 0 || build == 0) {
       // Error: Null pointer //
       return PIXY_ERROR_INVALID_PARAMETER;
     }
 
-    return_value = pixy_command("version",  END_OUT_ARGS, &response, &version_length, &pixy_version, END_IN_ARGS);
+    return_value = pixy_typed_command("version", std::make_tuple(), &response, &pixy_version);
 
     if (return_value < 0) {
       // Error //
       return return_value;
     }
 
-    memcpy((void *) version, pixy_version, 3 * sizeof(uint16_t));
+    if (pixy_version.len < 3) {
+      return PIXY_ERROR_CHIRP;
+    }
 
-    *major = version[0];
-    *minor = version[1];
-    *build = version[2];
+    *major = pixy_version.data[0];
+    *minor = pixy_version.data[1];
+    *build = pixy_version.data[2];
 
     return 0;
   }
@@ -22,9 +22,11 @@ PixyInterpreter::PixyInterpreter()
   thread_die_  = false;
   thread_dead_ = true;
   receiver_    = 0;
+  response_buffer_ = 0;
+  band_handler_    = 0;
 }
 
-int PixyInterpreter::init()
+int PixyInterpreter::init(const char * address)
 {
   int USB_return_value;
 
@@ -34,13 +36,26 @@ int PixyInterpreter::init()
     return 0;
   }
 
-  USB_return_value = link_.open();
+  if (address) {
+    // Pixy is on the other end of a socket (pixyrelay or pixy-sim) //
+    if (socket_link_.open(address) < 0) {
+      return PIXY_ERROR_SOCKET;
+    }
+    receiver_ = new ChirpReceiver(&socket_link_, this);
+  } else {
+    USB_return_value = link_.open();
+
+    if(USB_return_value < 0) {
+      return USB_return_value;
+    }
 
-  if(USB_return_value < 0) {
-    return USB_return_value;
+    receiver_ = new ChirpReceiver(&link_, this);
   }
 
-  receiver_ = new ChirpReceiver(&link_, this);
+  // Fetch Pixy's procedure table so send_command() can look up procedures   //
+  // locally instead of asking Pixy each time. If the firmware is too old to //
+  // support this, getProc() keeps asking Pixy.                              //
+  receiver_->getProcTable();
 
   // Create the interpreter thread //
 
@@ -59,7 +74,11 @@ void PixyInterpreter::close()
     thread_die_ = true;
     thread_.join();
   }
-    
+
+  if (response_buffer_) {
+    response_buffer_->release();
+    response_buffer_ = 0;
+  }
   delete receiver_;
 }
 
@@ -129,6 +148,130 @@ int PixyInterpreter::send_command(const char * name, va_list args)
   return_value = receiver_->call(SYNC, procedure_id, arguments); 
   va_end(arguments);
 
+  if (return_value >= 0) {
+    hold_response();
+  }
+
+  // Mutual exclusion for receiver_ object (Unlock) //
+  chirp_access_mutex_.unlock();
+
+  return return_value;
+}
+
+void PixyInterpreter::hold_response()
+{
+  if (response_buffer_) {
+    response_buffer_->release();
+  }
+  response_buffer_ = receiver_->holdBuffer();
+}
+
+int PixyInterpreter::send_command_async(const char * name, va_list args)
+{
+  ChirpProc procedure_id;
+  int       return_value;
+  va_list   arguments;
+
+  va_copy(arguments, args);
+
+  // Mutual exclusion for receiver_ object (Lock) //
+  chirp_access_mutex_.lock();
+
+  procedure_id = receiver_->getProc(name);
+
+  if (procedure_id == -1) {
+    return_value = PIXY_ERROR_INVALID_COMMAND;
+  } else {
+    // Send the call, the response is picked up by get_command_result() //
+    return_value = receiver_->call(PIPELINED, procedure_id, arguments);
+    if (return_value >= 0) {
+      return_value = receiver_->lastTag();
+    }
+  }
+  va_end(arguments);
+
+  // Mutual exclusion for receiver_ object (Unlock) //
+  chirp_access_mutex_.unlock();
+
+  return return_value;
+}
+
+int PixyInterpreter::get_command_result(int ticket, va_list args)
+{
+  int     return_value;
+  va_list arguments;
+
+  if (ticket <= 0 || ticket > 0xff) {
+    return PIXY_ERROR_INVALID_PARAMETER;
+  }
+
+  va_copy(arguments, args);
+
+  // Mutual exclusion for receiver_ object (Lock) //
+  chirp_access_mutex_.lock();
+
+  // Blocks and XDATA that arrive in the meantime are handled as usual //
+  return_value = receiver_->getResponse(ticket, arguments);
+  va_end(arguments);
+
+  // Mutual exclusion for receiver_ object (Unlock) //
+  chirp_access_mutex_.unlock();
+
+  return return_value;
+}
+
+int PixyInterpreter::send_command_batch(const char * name, va_list args)
+{
+  ChirpProc procedure_id;
+  int       return_value = 0;
+  va_list   arguments;
+
+  va_copy(arguments, args);
+
+  // Mutual exclusion for receiver_ object (Lock) //
+  chirp_access_mutex_.lock();
+
+  receiver_->batchBegin();
+
+  // Each command's arguments end with END_OUT_ARGS, then comes the next name //
+  for (; name != NULL && return_value >= 0; name = va_arg(arguments, const char *)) {
+    procedure_id = receiver_->getProc(name);
+    if (procedure_id == -1) {
+      return_value = PIXY_ERROR_INVALID_COMMAND;
+    } else {
+      return_value = receiver_->batchAdd(procedure_id, &arguments);
+    }
+  }
+  va_end(arguments);
+
+  if (return_value >= 0) {
+    // Blocks and XDATA that arrive in the meantime are handled as usual //
+    return_value = receiver_->batchCall();
+  }
+
+  // Mutual exclusion for receiver_ object (Unlock) //
+  chirp_access_mutex_.unlock();
+
+  return return_value;
+}
+
+int PixyInterpreter::get_batch_result(int index, va_list args)
+{
+  int     return_value;
+  va_list arguments;
+
+  if (index < 0) {
+    return PIXY_ERROR_INVALID_PARAMETER;
+  }
+
+  va_copy(arguments, args);
+
+  // Mutual exclusion for receiver_ object (Lock) //
+  chirp_access_mutex_.lock();
+
+  return_value = receiver_->batchResponse(index, arguments);
+  va_end(arguments);
+
   // Mutual exclusion for receiver_ object (Unlock) //
   chirp_access_mutex_.unlock();
 
@@ -176,6 +319,14 @@ void PixyInterpreter::interpret_data(void * chirp_data[])
         switch(chirp_type) {
 
           case FOURCC('B', 'A', '8', '1'):
+            // A whole frame is a band that starts at the top //
+            interpret_band(* static_cast<uint16_t *>(chirp_data[2]), * static_cast<uint16_t *>(chirp_data[3]), 0,
+                           * static_cast<uint32_t *>(chirp_data[4]), static_cast<uint8_t *>(chirp_data[5]));
+            break;
+          case FOURCC('B', 'A', '8', 'B'):
+            interpret_band(* static_cast<uint16_t *>(chirp_data[2]), * static_cast<uint16_t *>(chirp_data[3]),
+                           * static_cast<uint16_t *>(chirp_data[4]), * static_cast<uint32_t *>(chirp_data[5]),
+                           static_cast<uint8_t *>(chirp_data[6]));
             break;
           case FOURCC('C', 'C', 'Q', '1'):
             break;
@@ -206,6 +357,27 @@ void PixyInterpreter::interpret_data(void * chirp_data[])
   } 
 }
 
+void PixyInterpreter::set_frame_band_handler(pixy_frame_band_handler handler)
+{
+  // Wait for a call to the old handler to finish //
+  band_handler_mutex_.lock();
+  band_handler_ = handler;
+  band_handler_mutex_.unlock();
+}
+
+void PixyInterpreter::interpret_band(uint16_t width, uint16_t height, uint16_t row, uint32_t length, const uint8_t * pixels)
+{
+  if (width == 0 || length % width != 0 || row + length / width > height) {
+    return;
+  }
+
+  band_handler_mutex_.lock();
+  if (band_handler_) {
+    band_handler_(width, height, row, length / width, pixels);
+  }
+  band_handler_mutex_.unlock();
+}
+
 void PixyInterpreter::interpret_CCB1(void * CCB1_data[])
 {
   uint32_t   number_of_blobs;
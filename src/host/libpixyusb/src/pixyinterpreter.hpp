@@ -22,8 +22,10 @@
 #include "pixytypes.h"
 #include "pixy.h"
 #include "usblink.h"
+#include "socketlink.h"
 #include "interpreter.hpp"
 #include "chirpreceiver.hpp"
+#include "chirptyped.hpp"
 
 #define PIXY_BLOCK_CAPACITY         250
 
@@ -40,11 +42,14 @@ class PixyInterpreter : public Interpreter
               capture and store Pixy 'block' object data 
               which can be retreived using the getBlocks()
               method.
+       @param[in] address  Socket address to reach Pixy at (see
+                           socketlink.h), NULL for USB.
        @return   0    Success
        @return  -1    Error: Unable to open pixy USB device
+       @return  PIXY_ERROR_SOCKET  Error: Unable to connect to address
 
     */
-    int init();
+    int init(const char * address = 0);
     
     /**
       @brief  Terminates the USB connection to Pixy and
@@ -84,16 +89,104 @@ class PixyInterpreter : public Interpreter
     */
     int send_command(const char * name, ...);
 
+    /**
+      @brief         Sends a command to Pixy with typed arguments (see chirptyped.hpp).
+      @param[in]     name       Remote procedure call identifier string.
+      @param[in]     out        Arguments to send.
+      @param[out]    in         Where to put the response values, the response int first.
+      @return        Negative   Error
+    */
+    template <typename... Out, typename... In>
+    int send_typed_command(const char * name, const std::tuple<Out...> & out, In *... in)
+    {
+      ChirpProc procedure_id;
+      int       return_value;
+
+      // Mutual exclusion for receiver_ object (Lock) //
+      chirp_access_mutex_.lock();
+
+      procedure_id = receiver_->getProc(name);
+
+      if (procedure_id == -1) {
+        return_value = PIXY_ERROR_INVALID_COMMAND;
+      } else {
+        return_value = chirp::call(receiver_, procedure_id, out, in...);
+        if (return_value >= 0) {
+          hold_response();
+        }
+      }
+
+      // Mutual exclusion for receiver_ object (Unlock) //
+      chirp_access_mutex_.unlock();
+
+      return return_value;
+    }
+
+    /**
+      @brief         Sends a command to Pixy without waiting for the response.
+      @param[in]     name       Remote procedure call identifier string.
+      @param[in]     arguments  Output argument list, terminated by END_OUT_ARGS.
+      @return        Positive   Ticket for get_command_result()
+      @return        Negative   Error
+    */
+    int send_command_async(const char * name, va_list arguments);
+
+    /**
+      @brief         Waits for the response to a command sent with send_command_async().
+      @param[in]     ticket     Value returned by send_command_async().
+      @param[in,out] arguments  Input argument list, terminated by END_IN_ARGS.
+      @return        Negative   Error
+    */
+    int get_command_result(int ticket, va_list arguments);
+
+    /**
+      @brief         Sends several commands to Pixy in one chirp, and waits for all of
+                     their responses, which also come back in one.
+      @param[in]     name       Remote procedure call identifier string of the first command.
+      @param[in]     arguments  Its output argument list, terminated by END_OUT_ARGS, then
+                                the next command's name and arguments, and so on, ending
+                                with a NULL name.
+      @return        Positive   Number of commands sent, see get_batch_result()
+      @return        Negative   Error
+    */
+    int send_command_batch(const char * name, va_list arguments);
+
+    /**
+      @brief         Copies the response to one of the commands sent with send_command_batch().
+      @param[in]     index      Which command, counting from 0.
+      @param[in,out] arguments  Input argument list, terminated by END_IN_ARGS.
+      @return        Negative   Error
+    */
+    int get_batch_result(int index, va_list arguments);
+
+    /**
+      @brief         Sets the handler raw video frames are passed to, band by band.
+      @param[in]     handler    NULL for none.
+    */
+    void set_frame_band_handler(pixy_frame_band_handler handler);
+
   private:
     
     ChirpReceiver *    receiver_;
     USBLink            link_;
+    SocketLink         socket_link_;
     boost::thread      thread_;
     bool               thread_die_;
     bool               thread_dead_;
     std::vector<Block> blocks_;
     boost::mutex       blocks_access_mutex_;
     boost::mutex       chirp_access_mutex_;
+    ChirpBuffer *      response_buffer_;
+    pixy_frame_band_handler band_handler_;
+    boost::mutex       band_handler_mutex_;
+
+    /**
+      @brief  Holds on to the buffer the last response came in, so the pointers
+              into it that a command returned (a frame, say) stay good until the
+              next command, while the interpreter thread receives into another.
+              Call with chirp_access_mutex_ locked.
+    */
+    void hold_response();
 
     /**
       @brief  Interpreter thread entry point.
@@ -127,6 +220,17 @@ class PixyInterpreter : public Interpreter
     */
     void interpret_CCB2(void * data[]);
 
+    /**
+      @brief Passes a band of a raw frame to the band handler, if there is one.
+
+      @param[in] width   Frame width.
+      @param[in] height  Frame height.
+      @param[in] row     First row of the band.
+      @param[in] length  Length of the band in bytes.
+      @param[in] pixels  The band.
+    */
+    void interpret_band(uint16_t width, uint16_t height, uint16_t row, uint32_t length, const uint8_t * pixels);
+
     /**
       @brief Adds blocks with normal signatures to the PixyInterpreter
              'blocks_' buffer.
@@ -0,0 +1,440 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include "socketlink.h"
+
+#ifndef MSG_NOSIGNAL // macOS, we set SO_NOSIGPIPE instead
+#define MSG_NOSIGNAL 0
+#endif
+
+#define SOCKET_READ_SIZE     0x10000
+
+// Fills in addr for address, see socketlink.h.  Returns the address family, or -1.
+static int getAddress(const char *address, bool passive, struct sockaddr_storage *addr, socklen_t *addrLen)
+{
+  struct addrinfo hints, *info;
+  std::string host, port;
+  const char *colon;
+
+  memset(addr, 0, sizeof(*addr));
+  if (strchr(address, '/'))
+  {
+    struct sockaddr_un *un = (struct sockaddr_un *)addr;
+
+    if (strlen(address)>=sizeof(un->sun_path))
+      return -1;
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, address);
+    *addrLen = sizeof(*un);
+    return AF_UNIX;
+  }
+
+  if ((colon=strrchr(address, ':'))==NULL)
+    return -1;
+  host.assign(address, colon-address);
+  port = colon+1;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (passive)
+    hints.ai_flags = AI_PASSIVE;
+  if (getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(), &hints, &info)!=0)
+    return -1;
+  memcpy(addr, info->ai_addr, info->ai_addrlen);
+  *addrLen = info->ai_addrlen;
+  freeaddrinfo(info);
+
+  return AF_INET;
+}
+
+// chirp's calls are small and each one waits for its response, so don't hold them back
+static void setOptions(int fd, int family)
+{
+  int one = 1;
+
+  if (family==AF_INET)
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+SocketLink::SocketLink(uint32_t blockSize)
+{
+  m_fd = -1;
+  m_shutdown = false;
+  m_listenFd = -1;
+  m_family = AF_INET;
+  m_blockSize = blockSize;
+  // the socket doesn't lose or corrupt anything
+  m_flags = LINK_FLAG_ERROR_CORRECTED;
+  m_rqHead = 0;
+  m_headerLen = 0;
+  m_frameLeft = 0;
+  m_timer = 0;
+  m_sentBytes = 0;
+  m_recvBytes = 0;
+  m_sends = 0;
+}
+
+SocketLink::~SocketLink()
+{
+  close();
+  if (m_listenFd>=0)
+    ::close(m_listenFd);
+}
+
+int SocketLink::open(const char *address)
+{
+  struct sockaddr_storage addr;
+  socklen_t addrLen;
+  int family;
+
+  close();
+  if ((family=getAddress(address, false, &addr, &addrLen))<0)
+    return LINK_RESULT_ERROR;
+  if ((m_fd=socket(family, SOCK_STREAM, 0))<0)
+    return LINK_RESULT_ERROR;
+  if (connect(m_fd, (struct sockaddr *)&addr, addrLen)<0)
+  {
+    close();
+    return LINK_RESULT_ERROR;
+  }
+  m_shutdown = false;
+  setOptions(m_fd, family);
+
+  return LINK_RESULT_OK;
+}
+
+int SocketLink::listen(const char *address)
+{
+  struct sockaddr_storage addr;
+  socklen_t addrLen;
+  int family, one = 1;
+
+  if (m_listenFd>=0)
+    ::close(m_listenFd);
+  if ((family=getAddress(address, true, &addr, &addrLen))<0)
+    return LINK_RESULT_ERROR;
+  if ((m_listenFd=socket(family, SOCK_STREAM, 0))<0)
+    return LINK_RESULT_ERROR;
+  if (family==AF_UNIX)
+    unlink(address); // left over from last time
+  else
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (bind(m_listenFd, (struct sockaddr *)&addr, addrLen)<0 || ::listen(m_listenFd, 1)<0)
+  {
+    ::close(m_listenFd);
+    m_listenFd = -1;
+    return LINK_RESULT_ERROR;
+  }
+  m_family = family;
+
+  return LINK_RESULT_OK;
+}
+
+int SocketLink::accept(uint16_t timeoutMs)
+{
+  struct pollfd pfd = {m_listenFd, POLLIN, 0};
+  int res;
+
+  if (m_listenFd<0)
+    return LINK_RESULT_ERROR;
+  if ((res=poll(&pfd, 1, timeoutMs ? timeoutMs : -1))<=0)
+    return res==0 || errno==EINTR ? LINK_RESULT_ERROR_RECV_TIMEOUT : LINK_RESULT_ERROR;
+  close();
+  if ((m_fd=::accept(m_listenFd, NULL, NULL))<0)
+    return LINK_RESULT_ERROR;
+  m_shutdown = false;
+  setOptions(m_fd, m_family);
+
+  return LINK_RESULT_OK;
+}
+
+void SocketLink::close()
+{
+  if (m_fd>=0)
+    ::close(m_fd);
+  m_fd = -1;
+  // anything left over from the last peer is no good to the next one
+  m_rq.clear();
+  m_rqHead = 0;
+  m_frames.clear();
+  m_headerLen = 0;
+  m_frameLeft = 0;
+}
+
+void SocketLink::shutdown()
+{
+  if (m_fd>=0)
+    ::shutdown(m_fd, SHUT_RDWR); // wakes up a wait() in the other thread
+  m_shutdown = true;
+}
+
+uint64_t SocketLink::now()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (uint64_t)tv.tv_sec*1000000 + tv.tv_usec;
+}
+
+// >0 if fd is ready, 0 if it wasn't in time (-1 waits forever)
+int SocketLink::wait(short events, int timeoutMs)
+{
+  struct pollfd pfd = {m_fd, events, 0};
+  int res;
+
+  if ((res=poll(&pfd, 1, timeoutMs))<0)
+    return errno==EINTR ? 0 : LINK_RESULT_ERROR;
+  return res;
+}
+
+int SocketLink::send(const uint8_t *data, uint32_t len, uint16_t timeoutMs)
+{
+  uint8_t header[4];
+  uint32_t word, sent, total = len+4;
+  struct iovec iov[2];
+  struct msghdr msg;
+  ssize_t res;
+
+  if (!connected())
+    return LINK_RESULT_ERROR;
+
+  word = len;
+  if (m_blockSize && len%m_blockSize) // a short packet would end it
+    word |= SOCKET_FRAME_END;
+  header[0] = word;
+  header[1] = word>>8;
+  header[2] = word>>16;
+  header[3] = word>>24;
+
+  // header and data together, so a small send is one segment on the wire
+  for (sent=0; sent<total; sent+=res)
+  {
+    memset(&msg, 0, sizeof(msg));
+    if (sent<4)
+    {
+      iov[0].iov_base = header+sent;
+      iov[0].iov_len = 4-sent;
+      iov[1].iov_base = (void *)data;
+      iov[1].iov_len = len;
+      msg.msg_iovlen = 2;
+    }
+    else
+    {
+      iov[0].iov_base = (void *)(data+sent-4);
+      iov[0].iov_len = total-sent;
+      msg.msg_iovlen = 1;
+    }
+    msg.msg_iov = iov;
+    if ((res=sendmsg(m_fd, &msg, MSG_NOSIGNAL|MSG_DONTWAIT))<0)
+    {
+      // the peer has gone away
+      if (errno!=EAGAIN && errno!=EWOULDBLOCK && errno!=EINTR)
+      {
+        shutdown();
+        return LINK_RESULT_ERROR;
+      }
+      // the timeout is for the socket being continuously full
+      if ((res=wait(POLLOUT, timeoutMs ? timeoutMs : -1))<=0)
+        return res<0 ? res : LINK_RESULT_ERROR_SEND_TIMEOUT;
+      res = 0;
+    }
+  }
+  m_sentBytes += len;
+  m_sends++;
+
+  return len;
+}
+
+// Splits what came in into frames.
+int SocketLink::parse(const uint8_t *data, uint32_t len)
+{
+  uint32_t word, n;
+
+  while (len)
+  {
+    if (m_frameLeft==0) // header
+    {
+      m_header[m_headerLen++] = *data++;
+      len--;
+      if (m_headerLen<4)
+        continue;
+      m_headerLen = 0;
+      word = m_header[0] | (m_header[1]<<8) | (m_header[2]<<16) | ((uint32_t)m_header[3]<<24);
+      Frame frame = {0, false, (word&SOCKET_FRAME_END)!=0};
+      m_frameLeft = word&~SOCKET_FRAME_END;
+      if (m_frameLeft>SOCKET_FRAME_MAX)
+        return LINK_RESULT_ERROR;
+      frame.whole = m_frameLeft==0;
+      m_frames.push_back(frame);
+    }
+    else
+    {
+      n = len<m_frameLeft ? len : m_frameLeft;
+      m_rq.insert(m_rq.end(), data, data+n);
+      m_frames.back().len += n;
+      m_frameLeft -= n;
+      if (m_frameLeft==0)
+        m_frames.back().whole = true;
+      data += n;
+      len -= n;
+    }
+  }
+  return LINK_RESULT_OK;
+}
+
+// Reads whatever has come in, waiting up to timeoutMs for something to.
+int SocketLink::fill(uint16_t timeoutMs)
+{
+  uint8_t buf[SOCKET_READ_SIZE];
+  ssize_t n;
+  int res;
+
+  if (!connected())
+    return LINK_RESULT_ERROR;
+  if ((res=wait(POLLIN, timeoutMs))<=0)
+    return res;
+  if ((n=recv(m_fd, buf, sizeof(buf), MSG_DONTWAIT))<=0)
+  {
+    if (n<0 && (errno==EAGAIN || errno==EWOULDBLOCK || errno==EINTR))
+      return 0;
+    shutdown(); // peer has gone away
+    return LINK_RESULT_ERROR;
+  }
+  m_recvBytes += n;
+  if (parse(buf, n)<0)
+  {
+    shutdown();
+    return LINK_RESULT_ERROR;
+  }
+  return n;
+}
+
+// How much a receive of len gets: len, or less if a frame ending in a short packet
+// comes first, or 0 if neither is here yet.  Same as LoopbackLink in pixysim.
+uint32_t SocketLink::transfer(uint32_t len)
+{
+  std::deque<Frame>::iterator i;
+  uint32_t n;
+
+  for (i=m_frames.begin(), n=0; i!=m_frames.end(); i++)
+  {
+    n += i->len;
+    if (n>=len)
+      return len;
+    if (!i->whole)
+      break;
+    if (i->end)
+      return n;
+  }
+  return 0;
+}
+
+void SocketLink::consume(uint8_t *data, uint32_t len)
+{
+  uint32_t n;
+
+  memcpy(data, &m_rq[m_rqHead], len);
+  m_rqHead += len;
+  if (m_rqHead==m_rq.size())
+  {
+    m_rq.clear();
+    m_rqHead = 0;
+  }
+  else if (m_rqHead>SOCKET_READ_SIZE && m_rqHead>m_rq.size()/2)
+  {
+    m_rq.erase(m_rq.begin(), m_rq.begin()+m_rqHead);
+    m_rqHead = 0;
+  }
+
+  do
+  {
+    n = len<m_frames.front().len ? len : m_frames.front().len;
+    m_frames.front().len -= n;
+    len -= n;
+    if (m_frames.front().len==0 && m_frames.front().whole)
+      m_frames.pop_front();
+  } while (len);
+}
+
+int SocketLink::receive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
+{
+  uint32_t got;
+  uint64_t elapsed, start = now();
+  int res;
+
+  // all (or up to a short packet) or nothing, 0 if we're polling-- same as LoopbackLink
+  while ((got=transfer(len))==0)
+  {
+    elapsed = (now()-start)/1000;
+    if (timeoutMs && elapsed>=timeoutMs)
+      return LINK_RESULT_ERROR_RECV_TIMEOUT;
+    if ((res=fill(timeoutMs ? timeoutMs-elapsed : 0))<0)
+      return res;
+    if (res==0 && timeoutMs==0)
+      return 0;
+  }
+  consume(data, got);
+
+  return got;
+}
+
+int SocketLink::receiveFrame(uint8_t *data, uint32_t len, uint16_t timeoutMs)
+{
+  uint32_t n;
+  uint64_t elapsed, start = now();
+  int res;
+
+  while (m_frames.empty() || (!m_frames.front().whole && m_frames.front().len<len))
+  {
+    elapsed = (now()-start)/1000;
+    if (elapsed>=timeoutMs)
+      return 0;
+    if ((res=fill(timeoutMs-elapsed))<0)
+      return res;
+  }
+  n = len<m_frames.front().len ? len : m_frames.front().len;
+  if (n)
+    consume(data, n);
+  else if (m_frames.front().whole)
+    m_frames.pop_front();
+
+  return n;
+}
+
+void SocketLink::setTimer()
+{
+  m_timer = now();
+}
+
+uint32_t SocketLink::getTimer()
+{
+  return (now()-m_timer)/1000;
+}
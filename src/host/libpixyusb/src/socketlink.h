@@ -0,0 +1,101 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef __SOCKETLINK_H__
+#define __SOCKETLINK_H__
+
+#include <deque>
+#include <vector>
+#include "link.h"
+
+// A Link over a TCP or Unix domain socket, for reaching a Pixy on another machine
+// through pixyrelay, or a simulated one (pixy-sim -l).  Addresses are "host:port",
+// ":port" (localhost to open, any interface to listen), or a Unix socket path, which
+// needs a '/' in it.
+//
+// Chirp counts on USB's transfer boundaries: a bulk transfer that isn't a whole
+// number of packets ends in a short packet, and a receive stops there even if it
+// asked for more.  So each send() goes out as a frame, a 4-byte length with
+// SOCKET_FRAME_END set if it ended in a short packet, followed by the data, and
+// receive() returns what it asked for, or up to the end of such a frame, or nothing.
+#define SOCKET_FRAME_END     0x80000000
+#define SOCKET_FRAME_MAX     0x100000 // longer is garbage, we're out of sync
+
+class SocketLink : public Link
+{
+public:
+  SocketLink(uint32_t blockSize=64);
+  ~SocketLink();
+
+  int open(const char *address);
+  int listen(const char *address);
+  int accept(uint16_t timeoutMs); // wait for a peer after listen(), one at a time
+  void close(); // the peer, we keep listening
+  // Stops sends and receives on the peer without closing it, so another thread still
+  // using it sees an error instead of someone else's fd.  Errors do this too, close()
+  // is left to whoever owns the link.
+  void shutdown();
+  bool connected()
+  {
+    return m_fd>=0 && !m_shutdown;
+  }
+  // what ends in a short packet on this end, the USB link's packet size for a relay
+  void setBlockSize(uint32_t blockSize)
+  {
+    m_blockSize = blockSize;
+  }
+
+  virtual int send(const uint8_t *data, uint32_t len, uint16_t timeoutMs);
+  virtual int receive(uint8_t *data, uint32_t len, uint16_t timeoutMs);
+  virtual void setTimer();
+  virtual uint32_t getTimer();
+
+  // The next frame as it was sent (or len bytes of it, the rest comes next time), for
+  // passing frames on as-is.  0 if there isn't one after timeoutMs.
+  int receiveFrame(uint8_t *data, uint32_t len, uint16_t timeoutMs);
+
+  uint64_t m_sentBytes;
+  uint64_t m_recvBytes;
+  uint32_t m_sends;
+
+private:
+  struct Frame
+  {
+    uint32_t len; // what's arrived so far
+    bool whole;
+    bool end;
+  };
+
+  int fill(uint16_t timeoutMs);
+  int parse(const uint8_t *data, uint32_t len);
+  uint32_t transfer(uint32_t len);
+  void consume(uint8_t *data, uint32_t len);
+  int wait(short events, int timeoutMs);
+  static uint64_t now();
+
+  int m_fd;
+  volatile bool m_shutdown;
+  int m_listenFd;
+  int m_family;
+  std::vector<uint8_t> m_rq;
+  uint32_t m_rqHead;
+  std::deque<Frame> m_frames;
+  uint8_t m_header[4];
+  uint32_t m_headerLen;
+  uint32_t m_frameLeft;
+  uint64_t m_timer;
+};
+
+#endif
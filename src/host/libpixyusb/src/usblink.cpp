@@ -40,6 +40,7 @@ int USBLink::open()
 {
     int set_config_return_value;
     int claim_interface_return_value;
+    int max_packet_size;
 
     libusb_init(&m_context);
 
@@ -69,6 +70,10 @@ int USBLink::open()
 #ifdef __LINUX__
     libusb_reset_device(m_handle);
 #endif
+    // 512 if we're high-speed, chirp negotiates its first transfer up to this
+    max_packet_size = libusb_get_max_packet_size(libusb_get_device(m_handle), 0x82);
+    if (max_packet_size > 0)
+        m_blockSize = max_packet_size;
     return 0;
 }
 
@@ -104,7 +109,8 @@ int USBLink::receive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
 #ifdef __MACOS__
         libusb_clear_halt(m_handle, 0x82);
 #endif
-        printf("libusb_bulk_read %d\n", res);
+        if (res!=LIBUSB_ERROR_TIMEOUT) // polling, not a problem
+            printf("libusb_bulk_read %d\n", res);
         return res;
     }
     return transferred;
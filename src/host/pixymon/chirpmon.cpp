@@ -19,11 +19,13 @@
 #include "chirpmon.h"
 #include "interpreter.h"
 
-ChirpMon::ChirpMon(Interpreter *interpreter, USBLink *link)
+ChirpMon::ChirpMon(Interpreter *interpreter, Link *link)
 {
     m_hinterested = true;
     m_client = true;
     m_interpreter = interpreter;
+    m_recvStart = NULL;
+    m_recvEnd = NULL;
 
     if (setLink(link)<0)
         throw std::runtime_error("Unable to connect to device.");
@@ -45,6 +47,8 @@ int ChirpMon::serviceChirp()
     {
         if ((res=recvChirp(&type, &recvProc, args, true))<0)
             return res;
+        if (res==CRP_RES_STORED) // pipelined response, someone's waiting for it in getResponse()
+            continue;
         handleChirp(type, recvProc, args);
         if (type&CRP_RESPONSE)
             break;
@@ -55,6 +59,10 @@ int ChirpMon::serviceChirp()
 
 int ChirpMon::handleChirp(uint8_t type, ChirpProc proc, void *args[])
 {
+    // remember where the received data ends (responses have the response int in front of the data)
+    m_recvStart = m_buf;
+    m_recvEnd = m_buf + (type&CRP_RESPONSE ? m_headerLen-4 : m_headerLen) + m_len;
+
     if (type==CRP_RESPONSE)
     {
         m_interpreter->handleResponse(args);
@@ -64,11 +72,41 @@ int ChirpMon::handleChirp(uint8_t type, ChirpProc proc, void *args[])
     return Chirp::handleChirp(type, proc, args);
 }
 
+// handle the i'th response of the last batchCall() like any other response
+int ChirpMon::handleBatchResponse(uint32_t i)
+{
+    void *args[CRP_MAX_ARGS+1];
+    int len;
+
+    if ((len=batchArgs(i, args))<0)
+        return len;
+    m_recvStart = (uint8_t *)args[0] - 4;
+    m_recvEnd = m_recvStart + len;
+    m_interpreter->handleResponse(args);
+
+    return 0;
+}
+
 void ChirpMon::handleXdata(void *data[])
 {
     m_interpreter->handleData(data);
 }
 
+// Returns the serialized form of the chirp we're handling, starting with arg and running
+// to the end of the data.  arg needs to be a 32-bit scalar (e.g. a type hint) so that the
+// returned data is 4-byte aligned and can be passed to deserializeParse() as-is.
+int ChirpMon::getRawData(void *arg, uint8_t **data, uint32_t *len)
+{
+    uint8_t *start = (uint8_t *)arg - 4;
+
+    if (m_recvEnd==NULL || start<m_recvStart || start>=m_recvEnd)
+        return -1;
+
+    *data = start;
+    *len = m_recvEnd - start;
+    return 0;
+}
+
 int ChirpMon::sendChirp(uint8_t type, ChirpProc proc)
 {   // this is only called when we call call()
     int res;
@@ -19,7 +19,7 @@
 #include <chirp.hpp>
 
 class Interpreter;
-class USBLink;
+class Link;
 
 struct ChirpCallData
 {
@@ -45,10 +45,12 @@ struct ChirpCallData
 class ChirpMon : public Chirp
 {
 public:
-    ChirpMon(Interpreter *interpreter, USBLink *link);
+    ChirpMon(Interpreter *interpreter, Link *link);
     virtual ~ChirpMon();
 
     int serviceChirp();
+    int getRawData(void *arg, uint8_t **data, uint32_t *len);
+    int handleBatchResponse(uint32_t i);
 
     friend class Interpreter;
 
@@ -61,6 +63,8 @@ private:
     int execute(const ChirpCallData &data);
 
     Interpreter *m_interpreter;
+    uint8_t *m_recvStart;
+    uint8_t *m_recvEnd;
 };
 
 #endif // CHIRPTHREAD_H
@@ -13,6 +13,7 @@
 // end license header
 //
 
+#include <stdlib.h>
 #include <stdexcept>
 #include <QMessageBox>
 #include <QFile>
@@ -25,6 +26,7 @@
 #include "console.h"
 #include "mainwindow.h"
 #include "renderer.h"
+#include "playback.h"
 #include "sleeper.h"
 #include "pixymon.h"
 
@@ -47,6 +49,7 @@ Interpreter::Interpreter(ConsoleWidget *console, VideoWidget *video, ParameterDB
     m_chirp = NULL;
 
     m_renderer = new Renderer(m_video, this);
+    m_playback = new Playback(m_renderer, this);
 
     connect(m_console, SIGNAL(textLine(QString)), this, SLOT(command(QString)));
     connect(m_console, SIGNAL(controlKey(Qt::Key)), this, SLOT(controlKey(Qt::Key)));
@@ -56,6 +59,7 @@ Interpreter::Interpreter(ConsoleWidget *console, VideoWidget *video, ParameterDB
     connect(this, SIGNAL(prompt(QString)), m_console, SLOT(prompt(QString)));
     connect(this, SIGNAL(videoInput(VideoWidget::InputMode)), m_video, SLOT(acceptInput(VideoWidget::InputMode)));
     connect(m_video, SIGNAL(selection(int,int,int,int)), this, SLOT(handleSelection(int,int,int,int)));
+    connect(&m_recorder, SIGNAL(error(QString)), m_console, SLOT(error(QString)));
 
     m_run = true;
     start();
@@ -69,6 +73,8 @@ Interpreter::~Interpreter()
     clearLocalProgram();
     if (m_chirp)
         delete m_chirp;
+    m_recorder.close();
+    delete m_playback;
     delete m_renderer;
     qDebug("done");
 }
@@ -315,9 +321,60 @@ void Interpreter::handleResponse(void *args[])
     handleData(args+1);
 }
 
+// A frame that came in bands (BA8B) is recorded once it's whole, as BA81, so playback
+// and anything else that reads recordings sees the same frames either way.
+void Interpreter::recordRawFrame(uint8_t renderFlags)
+{
+    int len;
+    Frame8 &frame = m_renderer->m_rawFrame;
+    QByteArray data(frame.m_width*frame.m_height+CRP_MAX_HEADER_LEN, 0);
+
+    len = Chirp::serialize(NULL, (uint8_t *)data.data(), data.size(), HTYPE(FOURCC('B','A','8','1')), HINT8(renderFlags),
+                           UINT16(frame.m_width), UINT16(frame.m_height), UINTS8(frame.m_width*frame.m_height, frame.m_pixels), END);
+    if (len>0)
+        m_recorder.record(FOURCC('B','A','8','1'), (uint8_t *)data.data(), len);
+}
+
+// perf_get's table, times in microseconds, the histogram buckets are <16us, <64us, ...
+// (see common/perf.h)
+QString Interpreter::printPerf(void *args[])
+{
+    uint32_t i, j, ticks, stages, counters, *stats, *counts;
+    QStringList stageNames, counterNames;
+    QString print, line;
+
+    if (args[0]==NULL || args[3]==NULL || args[6]==NULL)
+        return "bad perf data\n";
+    ticks = *(uint32_t *)args[0];
+    if (ticks==0)
+        ticks = 1;
+    stageNames = QString((char *)args[1]).split(' ', QString::SkipEmptyParts);
+    stages = *(uint32_t *)args[2]/12;
+    stats = (uint32_t *)args[3];
+    counterNames = QString((char *)args[4]).split(' ', QString::SkipEmptyParts);
+    counters = *(uint32_t *)args[5];
+    counts = (uint32_t *)args[6];
+
+    print = "performance:\n";
+    print += QString("%1 %2 %3 %4 %5  histogram\n").arg("", -10).arg("count", 8).arg("min", 8).arg("avg", 8).arg("max", 8);
+    for (i=0; i<stages && i<(uint32_t)stageNames.size(); i++, stats+=12)
+    {
+        line = QString("%1 %2 %3 %4 %5 ").arg(stageNames[i], -10).arg(stats[0], 8).arg(stats[1]/ticks, 8)
+                .arg(stats[2]/ticks, 8).arg(stats[3]/ticks, 8);
+        for (j=4; j<12; j++)
+            line += " " + QString::number(stats[j]);
+        print += line + "\n";
+    }
+    for (i=0; i<counters && i<(uint32_t)counterNames.size(); i++)
+        print += counterNames[i] + " " + QString::number(counts[i]) + (i<counters-1 ? ", " : "\n");
+
+    return print;
+}
+
 void Interpreter::handleData(void *args[])
 {
     uint8_t type;
+    uint32_t fourcc;
     QColor color = CW_DEFAULT_COLOR;
 
     if (args[0])
@@ -325,8 +382,30 @@ void Interpreter::handleData(void *args[])
         type = Chirp::getType(args[0]);
         if (type==CRP_TYPE_HINT)
         {
-            m_print += printType(*(uint32_t *)args[0]) + " frame data\n";
-            m_renderer->render(*(uint32_t *)args[0], args+1);
+            fourcc = *(uint32_t *)args[0];
+            if (fourcc==FOURCC('P','R','F','1'))
+                m_print += printPerf(args+1);
+            else if (fourcc==FOURCC('B','A','8','B'))
+            {
+                // bands until the last one aren't printed, so they don't wait on the gui thread
+                if (m_renderer->render(fourcc, args+1)<=0)
+                    return;
+                if (m_recorder.recording())
+                    recordRawFrame(*(uint8_t *)args[1]);
+                m_print += printType(fourcc) + " frame data\n";
+            }
+            else
+            {
+                m_print += printType(fourcc) + " frame data\n";
+                if (m_recorder.recording())
+                {
+                    uint8_t *data;
+                    uint32_t len;
+                    if (m_chirp->getRawData(args[0], &data, &len)>=0)
+                        m_recorder.record(fourcc, data, len);
+                }
+                m_renderer->render(fourcc, args+1);
+            }
         }
         else if (type==CRP_HSTRING)
         {
@@ -507,10 +586,25 @@ void Interpreter::run()
         ChirpProc versionProc;
         uint16_t *version;
         uint32_t verLen, responseInt;
+        Link *link = &m_link;
 
+#ifndef __WINDOWS__
+        // a Pixy somewhere else, through pixyrelay
+        const char *address = getenv("PIXY_ADDRESS");
+        if (address && *address)
+        {
+            if (m_socketLink.open(address)<0)
+                throw std::runtime_error("Unable to connect to PIXY_ADDRESS.");
+            link = &m_socketLink;
+        }
+        else
+#endif
         if (m_link.open()<0)
             throw std::runtime_error("Unable to open USB device.");
-        m_chirp = new ChirpMon(this, &m_link);        
+        m_chirp = new ChirpMon(this, link);        
+        // get the whole procedure table in one go so the getProc()'s below don't each need a
+        // round trip (older firmware doesn't support this, and getProc() falls back)
+        m_chirp->getProcTable();
 
         // get version and compare
         versionProc = m_chirp->getProc("version");
@@ -535,6 +629,9 @@ void Interpreter::run()
         m_get_param = m_chirp->getProc("prm_get");
         m_getAll_param = m_chirp->getProc("prm_getAll");
         m_set_param = m_chirp->getProc("prm_set");
+        m_getAllBulk_param = m_chirp->getProc("prm_getAllBulk");
+        m_begin_param = m_chirp->getProc("prm_begin");
+        m_commit_param = m_chirp->getProc("prm_commit");
 
         if (m_exec_run<0 || m_exec_running<0 || m_exec_stop<0 || m_exec_get_action<0 ||
                 m_get_param<0 || m_getAll_param<0 || m_set_param<0)
@@ -567,6 +664,7 @@ void Interpreter::run()
             msleep(1); // give config thread time to run
         }
         handlePendingCommand();
+        m_playback->renderPending();
         if (!m_running)
         {
             if (m_localProgramRunning)
@@ -584,7 +682,9 @@ void Interpreter::run()
                             handleHelp();
                         else
                         {
-                            res = call(m_argv, true);
+                            // send as much of the scriptlet as we can in one go
+                            if (m_programming || m_commandList.size()==0 || (res=callBatch())==0)
+                                res = call(m_argv, true);
                             if (res<0)
                             {
                                 if (m_programming)
@@ -768,6 +868,10 @@ void Interpreter::command(const QString &command)
         emit videoInput(VideoWidget::REGION);
         m_argvHost = words;
     }
+    else if (words[0]=="record")
+        handleRecord(words);
+    else if (words[0]=="play" || words[0]=="seek")
+        handlePlay(words);
 #if 0
     else if (words[0]=="set")
     {
@@ -788,6 +892,55 @@ end:
     prompt();
 }
 
+// record <filename> | record stop
+void Interpreter::handleRecord(const QStringList &argv)
+{
+    if (argv.size()<2)
+        emit textOut(m_recorder.recording() ? "Recording, " + QString::number(m_recorder.frames()) + " frames.\n" : "Not recording.\n");
+    else if (argv[1]=="stop")
+    {
+        if (m_recorder.close()<0)
+            emit error("Error writing recording, it ends at the last frame written.\n");
+        emit textOut("Recorded " + QString::number(m_recorder.frames()-m_recorder.dropped()) + " frames, " +
+                     QString::number(m_recorder.dropped()) + " dropped.\n");
+    }
+    else if (m_recorder.open(argv[1])<0)
+        emit error("Unable to open " + argv[1] + " for recording.\n");
+    else
+        emit textOut("Recording to " + argv[1] + ".\n");
+}
+
+// play <filename> [fast] | play [fast] | play stop | seek <frame>
+void Interpreter::handlePlay(const QStringList &argv)
+{
+    int res;
+    bool realtime = !argv.contains("fast");
+
+    if (argv[0]=="seek")
+    {
+        if (argv.size()<2 || m_playback->seek(argv[1].toUInt())<0)
+            emit error("Frame out of range (" + QString::number(m_playback->frames()) + " frames).\n");
+        return;
+    }
+    if (argv.size()>1 && argv[1]=="stop")
+    {
+        m_playback->stop();
+        emit textOut("Stopped at frame " + QString::number(m_playback->frame()) + ".\n");
+        return;
+    }
+    if (argv.size()>1 && argv[1]!="fast")
+    {
+        if ((res=m_playback->open(argv[1]))<0)
+        {
+            emit error("Unable to open " + argv[1] + " for playback.\n");
+            return;
+        }
+        emit textOut("Playing " + QString::number(res) + " frames from " + argv[1] + ".\n");
+    }
+    if (m_playback->play(realtime)<0)
+        emit error("Nothing to play.\n");
+}
+
 void Interpreter::controlKey(Qt::Key key)
 {
     m_command = "";
@@ -901,13 +1054,121 @@ uint16_t *Interpreter::getVersion()
     return m_version;
 }
 
+// Put the command's args in args (type, value, type, value...) the way callAsync() takes
+// them.  m_argTypes needs to be set up for the command (augmentProcInfo()).  Returns -1 if
+// there's an arg that isn't an integer, -2 if one doesn't parse.
+int Interpreter::parseArgs(const QStringList &argv, int args[])
+{
+    int i, j, base;
+    bool ok;
+
+    for (i=0, j=0; m_argTypes[i]; i++)
+    {
+        if (argv.size()>i+1)
+        {
+            if (m_argTypes[i]==CRP_INT8 || m_argTypes[i]==CRP_INT16 || m_argTypes[i]==CRP_INT32)
+            {
+                args[j++] = m_argTypes[i];
+                if (argv[i+1].left(2)=="0x")
+                    base = 16;
+                else
+                    base = 10;
+                args[j++] = argv[i+1].toInt(&ok, base);
+                if (!ok)
+                    return -2;
+            }
+#if 0
+            else if (m_argTypes[i]==CRP_STRING)
+            {
+                args[j++] = m_argTypes[i];
+                // string goes where?  can't cast pointer to int...
+            }
+#endif
+            else
+            {
+                // deal with non-integer types
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Send m_argv and the scriptlet commands after it in m_commandList in one chirp, as many
+// as have all of their args (nothing to ask the user for) and parse.  Returns how many
+// were sent, 0 if there aren't at least 2 (call() then takes it from here, one at a time).
+int Interpreter::callBatch()
+{
+    ChirpProc proc;
+    ProcInfo info;
+    ArgList list;
+    QStringList argv;
+    QStringList commands;
+    int args[20];
+    int i, n, res;
+
+    m_chirp->batchBegin();
+    for (n=0; n<SCRIPT_BATCH_MAX && n<=m_commandList.size(); n++)
+    {
+        if (n==0)
+            argv = m_argv;
+        else
+        {
+            commands << m_commandList[n-1];
+            argv = m_commandList[n-1].split(QRegExp("[\\s(),\\t]"), QString::SkipEmptyParts);
+        }
+        if (argv.size()<1 || argv[0]=="help" || (proc=m_chirp->getProc(argv[0].toLocal8Bit()))<0 ||
+                m_chirp->getProcInfo(proc, &info)<0)
+            break;
+        getArgs(&info, &list);
+        if ((int)list.size()>argv.size()-1)
+            break;
+        augmentProcInfo(&info);
+        memset(args, 0, sizeof(args));
+        if (parseArgs(argv, args)<0 ||
+                m_chirp->batchAdd(proc, args[0], args[1], args[2], args[3], args[4], args[5], args[6],
+                                  args[7], args[8], args[9], args[10], args[11], args[12], args[13], args[14], args[15],
+                                  args[16], args[17], args[18], args[19], END_OUT_ARGS)<0)
+            break;
+    }
+    if (n<2)
+        return 0;
+
+    res = m_chirp->batchCall();
+    // older firmware doesn't do batches, it's one at a time then
+    if (res==CRP_RES_ERROR)
+        return 0;
+    // check for cable disconnect
+    if (res<0)
+    {
+        if (!m_notified)
+        {
+            m_notified = true;
+            emit connected(PIXY, false);
+        }
+        return res;
+    }
+
+    // print each command's response as if it had been run by itself
+    for (i=0; i<n; i++)
+    {
+        if (i>0)
+        {
+            emit textOut(PROMPT " " + commands[i-1]);
+            m_commandList.removeFirst();
+        }
+        m_chirp->handleBatchResponse(i);
+    }
+
+    return n;
+}
+
 int Interpreter::call(const QStringList &argv, bool interactive)
 {
     ChirpProc proc;
     ProcInfo info;
     int args[20];
-    int i, j, k, n, base, res;
-    bool ok;
+    int i, k, n, res;
     uint type;
     ArgList list;
 
@@ -983,37 +1244,11 @@ int Interpreter::call(const QStringList &argv, bool interactive)
 
         augmentProcInfo(&info);
         // if we have all the args we need, parse, put in args array
-        for (i=0, j=0; m_argTypes[i]; i++)
+        if ((res=parseArgs(argv, args))<0)
         {
-            if (argv.size()>i+1)
-            {
-                if (m_argTypes[i]==CRP_INT8 || m_argTypes[i]==CRP_INT16 || m_argTypes[i]==CRP_INT32)
-                {
-                    args[j++] = m_argTypes[i];
-                    if (argv[i+1].left(2)=="0x")
-                        base = 16;
-                    else
-                        base = 10;
-                    args[j++] = argv[i+1].toInt(&ok, base);
-                    if (!ok)
-                    {
-                        emit error("argument didn't parse.\n");
-                        return -1;
-                    }
-                }
-#if 0
-                else if (m_argTypes[i]==CRP_STRING)
-                {
-                    args[j++] = m_argTypes[i];
-                    // string goes where?  can't cast pointer to int...
-                }
-#endif
-                else
-                {
-                    // deal with non-integer types
-                    return -1;
-                }
-            }
+            if (res==-2)
+                emit error("argument didn't parse.\n");
+            return -1;
         }
 #if 0
         // print helpful chirp argument string
@@ -1095,6 +1330,92 @@ void Interpreter::augmentProcInfo(ProcInfo *info)
 }
 
 
+void Interpreter::addParam(uint32_t flags, uint8_t *argList, char *id, char *desc, uint32_t len, uint8_t *data)
+{
+    QString category;
+    QString sdesc(desc);
+
+    // deal with param category
+    QStringList words = QString(desc).split(QRegExp("\\s+"));
+    int i = words.indexOf("@c");
+    if (i>=0 && words.size()>i+1)
+    {
+        category = words[i+1];
+        sdesc = sdesc.remove("@c "); // remove form description
+        sdesc = sdesc.remove(category + " "); // remove from description
+        category = category.replace('_', ' '); // make it look prettier
+    }
+    else
+        category = CD_GENERAL;
+
+    Parameter parameter(id, (PType)argList[0], "("+printArgType(argList[0], flags)+") "+sdesc);
+    parameter.setProperty(PP_CATEGORY, category);
+    parameter.setProperty(PP_FLAGS, flags);
+    if (strlen((char *)argList)>1)
+    {
+        QByteArray a((char *)data, len);
+        parameter.set(a);
+    }
+    else
+    {
+        if (argList[0]==CRP_INT8 || argList[0]==CRP_INT16 || argList[0]==CRP_INT32)
+        {
+            int32_t val = 0;
+            Chirp::deserialize(data, len, &val, END);
+            parameter.set(val);
+        }
+        else if (argList[0]==CRP_FLT32)
+        {
+            float val;
+            Chirp::deserialize(data, len, &val, END);
+            parameter.set(val);
+        }
+        else // not sure what to do with it, so we'll save it as binary
+        {
+            QByteArray a((char *)data, len);
+            parameter.set(a);
+        }
+    }
+    m_pixyParameters.add(parameter);
+}
+
+// get all parameters in a single call, returns negative if firmware doesn't support it
+int Interpreter::loadParamsBulk()
+{
+    char *id, *desc;
+    uint32_t len, recLen, paramLen, flags;
+    int response, res, pass;
+    uint8_t *data, *argList, *bulk, *rec;
+
+    if (m_getAllBulk_param<0)
+        return -1;
+
+    res = m_chirp->callSync(m_getAllBulk_param, END_OUT_ARGS, &response, &len, &bulk, END_IN_ARGS);
+    if (res<0 || response<0)
+        return -1;
+
+    // Records are a 32-bit length followed by the serialized values, padded to 4 bytes.
+    // They're all decoded before any is added, so if one is bad, handleLoadParams() loads
+    // the parameters one at a time into a list that doesn't have half of them already.
+    for (pass=0; pass<2; pass++)
+    {
+        for (rec=bulk; rec+sizeof(uint32_t)<=bulk+len; rec+=recLen)
+        {
+            recLen = *(uint32_t *)rec;
+            if (rec+sizeof(uint32_t)+recLen>bulk+len)
+                return -1;
+            if (Chirp::deserialize(rec+sizeof(uint32_t), recLen, &flags, &argList, &id, &desc, &paramLen, &data, END)<0)
+                return -1;
+            if (pass==1)
+                addParam(flags, argList, id, desc, paramLen, data);
+            recLen += sizeof(uint32_t);
+            ALIGN(recLen, 4);
+        }
+    }
+
+    return response;
+}
+
 void Interpreter::handleLoadParams()
 {
     qDebug("loading...");
@@ -1106,74 +1427,33 @@ void Interpreter::handleLoadParams()
     uint8_t *data, *argList;
     int running;
 
-    // if we're running, stop so this doesn't take too long....
-    // (ie it would proceed with 1 property to returned frame, which could take 1 second or 2)
-    running = m_running;
-    if (running==1) // only if we're running and not in forced state (running==2)
-        sendStop();
-
-    for (i=0; true; i++)
+    if (loadParamsBulk()<0)
     {
-        QString category;
-
-        res = m_chirp->callSync(m_getAll_param, UINT16(i), END_OUT_ARGS, &response, &flags, &argList, &id, &desc, &len, &data, END_IN_ARGS);
-        if (res<0)
-            break;
-
-        if (response<0)
-            break;
+        // older firmware, get parameters one at a time
+        // if we're running, stop so this doesn't take too long....
+        // (ie it would proceed with 1 property to returned frame, which could take 1 second or 2)
+        running = m_running;
+        if (running==1) // only if we're running and not in forced state (running==2)
+            sendStop();
+
+        for (i=0; true; i++)
+        {
+            res = m_chirp->callSync(m_getAll_param, UINT16(i), END_OUT_ARGS, &response, &flags, &argList, &id, &desc, &len, &data, END_IN_ARGS);
+            if (res<0)
+                break;
 
-        QString sdesc(desc);
+            if (response<0)
+                break;
 
-        // deal with param category
-        QStringList words = QString(desc).split(QRegExp("\\s+"));
-        int i = words.indexOf("@c");
-        if (i>=0 && words.size()>i+1)
-        {
-            category = words[i+1];
-            sdesc = sdesc.remove("@c "); // remove form description
-            sdesc = sdesc.remove(category + " "); // remove from description
-            category = category.replace('_', ' '); // make it look prettier
+            addParam(flags, argList, id, desc, len, data);
         }
-        else
-            category = CD_GENERAL;
 
-        Parameter parameter(id, (PType)argList[0], "("+printArgType(argList[0], flags)+") "+sdesc);
-        parameter.setProperty(PP_CATEGORY, category);
-        parameter.setProperty(PP_FLAGS, flags);
-        if (strlen((char *)argList)>1)
-        {
-            QByteArray a((char *)data, len);
-            parameter.set(a);
-        }
-        else
+        // if we're running, we've stopped, now resume
+        if (running==1)
         {
-            if (argList[0]==CRP_INT8 || argList[0]==CRP_INT16 || argList[0]==CRP_INT32)
-            {
-                int32_t val = 0;
-                Chirp::deserialize(data, len, &val, END);
-                parameter.set(val);
-            }
-            else if (argList[0]==CRP_FLT32)
-            {
-                float val;
-                Chirp::deserialize(data, len, &val, END);
-                parameter.set(val);
-            }
-            else // not sure what to do with it, so we'll save it as binary
-            {
-                QByteArray a((char *)data, len);
-                parameter.set(a);
-            }
+            sendRun();
+            m_fastPoll = false; // turn off fast polling...
         }
-        m_pixyParameters.add(parameter);
-    }
-
-    // if we're running, we've stopped, now resume
-    if (running==1)
-    {
-        sendRun();
-        m_fastPoll = false; // turn off fast polling...
     }
 
     qDebug("loaded");
@@ -1186,10 +1466,25 @@ void Interpreter::handleLoadParams()
 }
 
 
+// collect the responses to pipelined prm_set calls, even after one fails
+int Interpreter::getSetParamResponses(uint8_t *tags, int n)
+{
+    int i, res, response, result = 0;
+
+    for (i=0; i<n; i++)
+    {
+        res = m_chirp->getResponse(tags[i], &response, END_IN_ARGS);
+        if (res<0 || response<0)
+            result = -1;
+    }
+    return result;
+}
+
 void Interpreter::handleSaveParams()
 {
-    int i;
+    int i, n;
     int res, response;
+    uint8_t tags[PARAM_PIPELINE_DEPTH];
     bool dirty, running;
 
     // if we're running, stop so this doesn't take too long....
@@ -1200,7 +1495,13 @@ void Interpreter::handleSaveParams()
 
     Parameters &parameters = m_pixyParameters.parameters();
 
-    for (i=0, dirty=false; i<parameters.size(); i++)
+    // have Pixy write all of the parameters to flash at once, if it can
+    if (m_begin_param>=0 && m_commit_param>=0)
+        m_chirp->callSync(m_begin_param, END_OUT_ARGS, &response, END_IN_ARGS);
+
+    // send the prm_set calls back to back and collect the responses behind them, so we
+    // don't wait out a USB round trip for each parameter
+    for (i=0, n=0, res=0, dirty=false; i<parameters.size(); i++)
     {
         uint8_t buf[0x100];
 
@@ -1234,14 +1535,31 @@ void Interpreter::handleSaveParams()
             else
                 continue; // don't know what to do!
 
-            res = m_chirp->callSync(m_set_param, STRING(id), UINTS8(len, buf), END_OUT_ARGS, &response, END_IN_ARGS);
-            if (res<0 || response<0)
+            res = m_chirp->callPipelined(m_set_param, STRING(id), UINTS8(len, buf), END_OUT_ARGS);
+            if (res>=0)
+                tags[n++] = m_chirp->lastTag();
+            if (res>=0 && n==PARAM_PIPELINE_DEPTH)
+            {
+                res = getSetParamResponses(tags, n);
+                n = 0;
+            }
+            if (res<0)
             {
                 emit error("There was a problem setting a parameter.");
                 break;
             }
         }
     }
+    // collect what's still in flight
+    if (getSetParamResponses(tags, n)<0 && res>=0)
+        emit error("There was a problem setting a parameter.");
+
+    if (m_begin_param>=0 && m_commit_param>=0)
+    {
+        res = m_chirp->callSync(m_commit_param, END_OUT_ARGS, &response, END_IN_ARGS);
+        if (res<0 || response<0)
+            emit error("There was a problem saving parameters.");
+    }
 
     // if we're running, we've stopped, now resume
     if (running==1)
@@ -29,15 +29,22 @@
 #include "connectevent.h"
 #include "disconnectevent.h"
 #include "usblink.h"
+#ifndef __WINDOWS__
+#include "socketlink.h"
+#endif
 #include "parameters.h"
+#include "recorder.h"
 
 #define PROMPT  ">"
 #define RUN_POLL_PERIOD_SLOW   500 // msecs
 #define RUN_POLL_PERIOD_FAST   10  // msecs
+#define PARAM_PIPELINE_DEPTH   8   // prm_set calls in flight while saving
+#define SCRIPT_BATCH_MAX       16  // scriptlet commands sent together in one chirp
 #define CD_GENERAL             "General"
 
 class ConsoleWidget;
 class Renderer;
+class Playback;
 
 enum CommandType {STOP, RUN, GET_ACTION, LOAD_PARAMS, SAVE_PARAMS};
 
@@ -113,8 +120,11 @@ private:
     void handleCall(const QStringList &argv);
     void listProgram();
     int call(const QStringList &argv, bool interactive=false);
+    int parseArgs(const QStringList &argv, int args[]);
+    int callBatch();
     void handleResponse(void *args[]);
     void handleData(void *args[]);
+    void recordRawFrame(uint8_t renderFlags);
 
     int addProgram(ChirpCallData data);
     int addProgram(const QStringList &argv);
@@ -130,21 +140,33 @@ private:
     void prompt();
 
     void handleSaveParams(); // save to Pixy
+    int getSetParamResponses(uint8_t *tags, int n);
     void handleLoadParams(); // load from Pixy
+    int loadParamsBulk();
+    void addParam(uint32_t flags, uint8_t *argList, char *id, char *desc, uint32_t len, uint8_t *data);
+
+    void handleRecord(const QStringList &argv);
+    void handlePlay(const QStringList &argv);
 
     QStringList getSections(const QString &id, const QString &string);
     int getArgs(const ProcInfo *info, ArgList *argList);
     QString printProc(const ProcInfo *info,  int level=0);
     QString printArgType(uint8_t *type, int &index);
     QString printArgType(uint8_t type, uint32_t flags);
+    QString printPerf(void *args[]);
 
     void augmentProcInfo(ProcInfo *info);
 
     ConsoleWidget *m_console;
     VideoWidget *m_video;
     Renderer *m_renderer;
+    Recorder m_recorder;
+    Playback *m_playback;
 
     USBLink m_link;
+#ifndef __WINDOWS__
+    SocketLink m_socketLink; // if PIXY_ADDRESS is set, see socketlink.h
+#endif
 
     // for thread
     QMutex m_mutexProg;
@@ -160,7 +182,10 @@ private:
     ChirpProc m_exec_get_action;
     ChirpProc m_get_param;
     ChirpProc m_getAll_param;
+    ChirpProc m_getAllBulk_param; // negative if firmware doesn't have it
     ChirpProc m_set_param;
+    ChirpProc m_begin_param; // negative if firmware doesn't have these
+    ChirpProc m_commit_param;
 
     // for program
     bool m_programming;
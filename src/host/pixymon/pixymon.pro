@@ -27,12 +27,16 @@ SOURCES += main.cpp\
     ../../common/colorlut.cpp \
     ../../common/blob.cpp \
     ../../common/blobs.cpp \
+    ../../common/runfilter.cpp \
+    ../../common/fixmath.cpp \
     processblobs.cpp \
     ../../common/qqueue.cpp \
     configdialog.cpp \
     aboutdialog.cpp \
     parameters.cpp \
-    paramfile.cpp
+    paramfile.cpp \
+    recorder.cpp \
+    playback.cpp
 
 HEADERS  += mainwindow.h \
     videowidget.h \
@@ -55,6 +59,8 @@ HEADERS  += mainwindow.h \
     ../../common/blobs.h \
     ../../common/blob.h \
     ../../common/blobs.h \
+    ../../common/runfilter.h \
+    ../../common/fixmath.h \
     processblobs.h \
     ../../common/qqueue.h \
     pixymon.h \
@@ -63,10 +69,15 @@ HEADERS  += mainwindow.h \
     sleeper.h \
     aboutdialog.h \
     parameters.h \
-    paramfile.h
+    paramfile.h \
+    recorder.h \
+    playback.h
 
 INCLUDEPATH += ../../common
 
+# Pixy builds with FIXED_MATH, so the same color models make the same LUT here
+DEFINES += FIXED_MATH
+
 QMAKE_CXXFLAGS_DEBUG += -O0
 QMAKE_CXXFLAGS += -Wno-unused-parameter
 QMAKE_CXXFLAGS += -mno-ms-bitfields
@@ -103,6 +114,13 @@ unix:!macx {
    
 }
 
+# a Pixy on another machine, through pixyrelay (see PIXY_ADDRESS in interpreter.cpp)
+unix {
+    SOURCES += ../libpixyusb/src/socketlink.cpp
+    HEADERS += ../libpixyusb/src/socketlink.h
+    INCLUDEPATH += ../libpixyusb/src
+}
+
 RESOURCES += \
     resources.qrc
 
@@ -0,0 +1,323 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include "playback.h"
+#include "renderer.h"
+
+// The arguments each format has on the wire, which Renderer::render() takes as given.
+// b, w and l are 1, 2 and 4-byte scalars, B, W, L and F are arrays of them and of
+// floats, each a length followed by the data.
+static const struct
+{
+    uint32_t type;
+    const char *args;
+} g_formats[] =
+{
+    {FOURCC('B','A','8','1'), "bwwB"},
+    {FOURCC('B','A','8','B'), "bwwwB"},
+    {FOURCC('C','C','Q','1'), "bwwL"},
+    {FOURCC('C','C','B','1'), "bwwW"},
+    {FOURCC('C','C','B','2'), "bwwWW"},
+    {FOURCC('C','M','V','1'), "bFwwB"}
+};
+
+// A recording is just a file, so before args go to the renderer they have to be
+// the ones it expects, and all inside the record, which ends at end.
+static bool checkArgs(uint32_t type, void *args[], const uint8_t *end)
+{
+    uint32_t i, a;
+    uint8_t argType, size;
+    const char *format = NULL;
+
+    for (i=0; i<sizeof(g_formats)/sizeof(g_formats[0]); i++)
+    {
+        if (g_formats[i].type==type)
+            format = g_formats[i].args;
+    }
+    if (format==NULL)
+        return false;
+
+    for (a=0; *format; format++, a++)
+    {
+        if (args[a]==NULL)
+            return false;
+        argType = Chirp::getType(args[a]);
+        size = *format=='b' || *format=='B' ? 1 : *format=='w' || *format=='W' ? 2 : 4;
+        if ((argType&0x0f)!=size || (*format=='F')!=((argType&CRP_FLT)!=0))
+            return false;
+        if (*format>='a') // scalar
+        {
+            if ((argType&CRP_ARRAY) || (uint8_t *)args[a]+size>end)
+                return false;
+        }
+        else // length, then data
+        {
+            if (!(argType&CRP_ARRAY) || (uint8_t *)args[a]+sizeof(uint32_t)>end || args[a+1]==NULL ||
+                    (uint64_t)(end-(uint8_t *)args[a+1])<(uint64_t)*(uint32_t *)args[a]*size)
+                return false;
+            a++;
+        }
+    }
+
+    return args[a]==NULL;
+}
+
+Playback::Playback(Renderer *renderer, QThread *renderThread)
+{
+    m_renderer = renderer;
+    m_renderThread = renderThread;
+    m_map = NULL;
+    m_size = 0;
+    m_index = NULL;
+    m_numFrames = 0;
+    m_pending = -1;
+    m_frame = 0;
+    m_seeked = false;
+    m_realtime = true;
+    m_run = false;
+}
+
+Playback::~Playback()
+{
+    close();
+}
+
+int Playback::open(const QString &filename)
+{
+    const RecordFileHeader *header;
+    const RecordTrailer *trailer;
+
+    close();
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return -1;
+    m_size = m_file.size();
+    if (m_size<sizeof(RecordFileHeader) || (m_map=m_file.map(0, m_size))==NULL)
+    {
+        m_file.close();
+        return -1;
+    }
+
+    header = (const RecordFileHeader *)m_map;
+    if (header->m_magic!=REC_MAGIC || header->m_version!=REC_VERSION)
+    {
+        close();
+        return -2;
+    }
+
+    // use trailing index if it's there and sane, otherwise walk the records
+    trailer = (const RecordTrailer *)(m_map + m_size - sizeof(RecordTrailer));
+    if (m_size>=sizeof(RecordFileHeader)+sizeof(RecordTrailer) && trailer->m_magic==REC_INDEX_MAGIC &&
+            trailer->m_indexOffset>=sizeof(RecordFileHeader) &&
+            trailer->m_indexOffset+(uint64_t)trailer->m_numFrames*sizeof(uint64_t)+sizeof(RecordTrailer)==m_size &&
+            checkIndex((const uint64_t *)(m_map + trailer->m_indexOffset), trailer->m_numFrames))
+    {
+        m_index = (const uint64_t *)(m_map + trailer->m_indexOffset);
+        m_numFrames = trailer->m_numFrames;
+    }
+    else
+        buildIndex();
+
+    m_frame = 0;
+    return m_numFrames;
+}
+
+void Playback::close()
+{
+    stop();
+
+    // renderThread might be rendering from the map
+    QMutexLocker locker(&m_mutex);
+    m_pending = -1;
+    if (m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = NULL;
+    }
+    m_file.close();
+    m_index = NULL;
+    m_builtIndex.clear();
+    m_numFrames = 0;
+    m_frame = 0;
+}
+
+int Playback::buildIndex()
+{
+    uint64_t offset, size;
+    const RecordHeader *header;
+
+    m_builtIndex.clear();
+    for (offset=sizeof(RecordFileHeader); offset+sizeof(RecordHeader)<=m_size; offset+=size)
+    {
+        header = (const RecordHeader *)(m_map + offset);
+        size = sizeof(RecordHeader) + header->m_len;
+        ALIGN(size, REC_ALIGN);
+        if (header->m_len==0 || offset+sizeof(RecordHeader)+header->m_len>m_size)
+            break; // truncated record, ignore it and everything after
+        m_builtIndex.push_back(offset);
+    }
+
+    m_numFrames = m_builtIndex.size();
+    m_index = m_numFrames ? &m_builtIndex[0] : NULL;
+    qDebug("playback: no index, found %d frames", m_numFrames);
+
+    return m_numFrames;
+}
+
+// every entry has to point at a whole record, same test buildIndex() applies
+bool Playback::checkIndex(const uint64_t *index, uint32_t numFrames)
+{
+    uint32_t i;
+    const RecordHeader *header;
+
+    for (i=0; i<numFrames; i++)
+    {
+        if (index[i]<sizeof(RecordFileHeader) || index[i]>m_size-sizeof(RecordHeader))
+            return false;
+        header = (const RecordHeader *)(m_map + index[i]);
+        if (header->m_len==0 || index[i]+sizeof(RecordHeader)+header->m_len>m_size)
+            return false;
+    }
+    return true;
+}
+
+const RecordHeader *Playback::record(uint32_t frame)
+{
+    if (frame>=m_numFrames)
+        return NULL;
+    return (const RecordHeader *)(m_map + m_index[frame]);
+}
+
+int Playback::render(uint32_t frame)
+{
+    const RecordHeader *header;
+    void *args[CRP_MAX_ARGS+1];
+
+    if ((header=record(frame))==NULL)
+        return -1;
+    if (Chirp::deserializeParse((uint8_t *)header+sizeof(RecordHeader), header->m_len, args)<0 ||
+            args[0]==NULL || Chirp::getType(args[0])!=CRP_TYPE_HINT ||
+            !checkArgs(*(uint32_t *)args[0], args+1, (uint8_t *)header+sizeof(RecordHeader)+header->m_len))
+    {
+        qDebug("playback: frame %u is bad", frame);
+        return -1;
+    }
+
+    return m_renderer->render(*(uint32_t *)args[0], args+1);
+}
+
+// with m_mutex locked
+void Playback::show(uint32_t frame)
+{
+    if (m_renderThread->isRunning())
+        m_pending = frame;
+    else
+        render(frame);
+}
+
+void Playback::renderPending()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_pending<0)
+        return;
+    render(m_pending);
+    m_pending = -1;
+    m_rendered.wakeAll();
+}
+
+int Playback::play(bool realtime)
+{
+    if (m_numFrames==0)
+        return -1;
+    stop();
+    m_realtime = realtime;
+    if (m_frame>=m_numFrames)
+        m_frame = 0;
+    m_seeked = true;
+    m_run = true;
+    start();
+
+    return 0;
+}
+
+void Playback::stop()
+{
+    m_run = false;
+    wait();
+}
+
+int Playback::seek(uint32_t frame)
+{
+    if (frame>=m_numFrames)
+        return -1;
+
+    QMutexLocker locker(&m_mutex);
+    m_frame = frame;
+    m_seeked = true;
+    // if we're not playing, show the frame we've landed on
+    if (!isRunning())
+        show(m_frame);
+
+    return 0;
+}
+
+void Playback::run()
+{
+    QElapsedTimer timer;
+    const RecordHeader *header;
+    uint64_t start = 0;
+    int64_t delay;
+
+    while(m_run)
+    {
+        m_mutex.lock();
+        if (m_frame>=m_numFrames)
+        {
+            m_mutex.unlock();
+            break;
+        }
+        header = record(m_frame);
+        if (m_seeked) // restart the clock from the frame we're on
+        {
+            start = header->m_timestamp;
+            timer.start();
+            m_seeked = false;
+        }
+        m_mutex.unlock();
+
+        if (m_realtime)
+        {
+            // wait in small steps so stop() and seek() stay responsive
+            while (m_run && !m_seeked &&
+                   (delay=(int64_t)(header->m_timestamp-start)-timer.nsecsElapsed()/1000)>0)
+                usleep(delay>10000 ? 10000 : delay);
+            if (m_seeked)
+                continue;
+        }
+
+        // one frame at a time, so fast playback doesn't just skip to the end
+        m_mutex.lock();
+        show(m_frame++);
+        while (m_run && m_pending>=0 && m_renderThread->isRunning())
+            m_rendered.wait(&m_mutex, 10);
+        m_mutex.unlock();
+    }
+    m_run = false;
+}
@@ -0,0 +1,89 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <vector>
+#include "recorder.h"
+
+class Renderer;
+
+// Plays back a file written by Recorder.  The file is memory-mapped and frames are
+// deserialized in place, so seeking to any frame is just an index lookup.
+//
+// Renderer isn't thread-safe, so frames are rendered by renderThread, the one that
+// renders live frames, when it calls renderPending().  If it isn't running (there's
+// no Pixy) they're rendered here.
+class Playback : public QThread
+{
+    Q_OBJECT
+
+public:
+    Playback(Renderer *renderer, QThread *renderThread);
+    ~Playback();
+
+    int open(const QString &filename);
+    void close();
+
+    // realtime=true plays at the recorded frame rate, otherwise as fast as we can render
+    int play(bool realtime);
+    void stop();
+    int seek(uint32_t frame);
+    // called by renderThread to render the frame we're waiting to show, if any
+    void renderPending();
+
+    uint32_t frames()
+    {
+        return m_numFrames;
+    }
+    uint32_t frame()
+    {
+        return m_frame;
+    }
+
+protected:
+    virtual void run();
+
+private:
+    int buildIndex();
+    bool checkIndex(const uint64_t *index, uint32_t numFrames);
+    const RecordHeader *record(uint32_t frame);
+    int render(uint32_t frame);
+    void show(uint32_t frame);
+
+    Renderer *m_renderer;
+    QThread *m_renderThread;
+    QFile m_file;
+    uint8_t *m_map;
+    uint64_t m_size;
+    const uint64_t *m_index;
+    std::vector<uint64_t> m_builtIndex; // used if file has no trailer
+    uint32_t m_numFrames;
+
+    QMutex m_mutex;
+    QWaitCondition m_rendered;
+    int64_t m_pending; // frame for renderThread to render, -1 if none
+    uint32_t m_frame;
+    bool m_seeked;
+    bool m_realtime;
+    bool m_run;
+};
+
+#endif // PLAYBACK_H
@@ -22,6 +22,9 @@ ProcessBlobs::ProcessBlobs(Interpreter *interpreter)
     m_qq = new Qqueue();
     m_blobs = new Blobs(m_qq);
     m_qMem = new uint32_t[0x10000];
+    m_minRunLength = 0;
+    m_maxRunGap = 0;
+    m_verticalRunFilter = 0;
 
     connect(m_interpreter, SIGNAL(paramChange()), this, SLOT(handleParamChange()));
 }
@@ -193,8 +196,15 @@ void ProcessBlobs::handleParamChange()
         m_minArea = variant->toUInt();
     if ((variant=m_interpreter->m_pixyParameters.value("Color code mode")))
         m_ccMode = variant->toUInt();
+    if ((variant=m_interpreter->m_pixyParameters.value("Min run length")))
+        m_minRunLength = variant->toUInt();
+    if ((variant=m_interpreter->m_pixyParameters.value("Max run gap")))
+        m_maxRunGap = variant->toUInt();
+    if ((variant=m_interpreter->m_pixyParameters.value("Vertical run filter")))
+        m_verticalRunFilter = variant->toUInt();
 
     // update
     m_blobs->setParams(m_maxBlobs, m_maxBlobsPerModel, m_minArea, (ColorCodeMode)m_ccMode);
+    m_blobs->setRunFilter(m_minRunLength, m_maxRunGap, m_verticalRunFilter);
 }
 
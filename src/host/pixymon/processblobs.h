@@ -48,6 +48,9 @@ private:
     uint16_t m_maxBlobsPerModel;
     uint32_t m_minArea;
     uint8_t m_ccMode;
+    uint8_t m_minRunLength;
+    uint8_t m_maxRunGap;
+    uint8_t m_verticalRunFilter;
 };
 
 #endif // PROCESSBLOBS_H
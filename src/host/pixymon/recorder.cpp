@@ -0,0 +1,190 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <QDebug>
+#include <QMutexLocker>
+#include "recorder.h"
+
+Recorder::Recorder()
+{
+    m_offset = 0;
+    m_queued = 0;
+    m_frames = 0;
+    m_dropped = 0;
+    m_failed = false;
+    m_recording = false;
+    m_run = false;
+}
+
+Recorder::~Recorder()
+{
+    close();
+}
+
+int Recorder::open(const QString &filename)
+{
+    RecordFileHeader header;
+
+    if (m_recording)
+        return -1;
+    close(); // one that stopped on a write error
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return -1;
+
+    header.m_magic = REC_MAGIC;
+    header.m_version = REC_VERSION;
+    header.m_reserved = 0;
+    if (m_file.write((char *)&header, sizeof(header))!=sizeof(header))
+    {
+        m_file.close();
+        return -1;
+    }
+
+    m_offset = sizeof(header);
+    m_index.clear();
+    m_queued = 0;
+    m_frames = 0;
+    m_dropped = 0;
+    m_failed = false;
+    m_timer.start();
+    m_run = true;
+    m_recording = true;
+    start();
+
+    return 0;
+}
+
+int Recorder::close()
+{
+    int res;
+
+    // the I/O thread stops recording on a write error, but the file's still open
+    if (!m_file.isOpen())
+        return 0;
+
+    m_recording = false;
+
+    // let I/O thread drain the queue and exit
+    m_mutex.lock();
+    m_run = false;
+    m_wait.wakeAll();
+    m_mutex.unlock();
+    wait();
+
+    res = writeIndex();
+    m_file.close();
+
+    return m_failed ? -1 : res;
+}
+
+int Recorder::record(uint32_t type, const uint8_t *data, uint32_t len)
+{
+    RecordHeader header;
+    uint32_t size;
+
+    if (!m_recording)
+        return -1;
+
+    size = sizeof(header) + len;
+    ALIGN(size, REC_ALIGN);
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_recording) // the I/O thread stopped us
+        return -1;
+    if (m_queued+size>REC_MAX_QUEUED)
+    {
+        m_dropped++;
+        return -1;
+    }
+
+    header.m_type = type;
+    header.m_len = len;
+    header.m_timestamp = m_timer.nsecsElapsed()/1000;
+
+    // header, payload and padding go out in a single write
+    QByteArray record(size, 0);
+    memcpy(record.data(), &header, sizeof(header));
+    memcpy(record.data()+sizeof(header), data, len);
+
+    m_queue.push(record);
+    m_queued += size;
+    m_frames++;
+    m_wait.wakeAll();
+
+    return 0;
+}
+
+void Recorder::run()
+{
+    QByteArray record;
+
+    while(1)
+    {
+        m_mutex.lock();
+        while (m_queue.empty() && m_run)
+            m_wait.wait(&m_mutex);
+        if (m_queue.empty()) // we've been told to stop and there's nothing left
+        {
+            m_mutex.unlock();
+            break;
+        }
+        record = m_queue.front();
+        m_queue.pop();
+        m_queued -= record.size();
+        m_mutex.unlock();
+
+        if (m_file.write(record)!=record.size())
+        {
+            // Cut off whatever part of the record made it, so the index we write on
+            // close() and the records in the file agree, and stop.
+            qDebug("recorder: write error");
+            m_file.resize(m_offset);
+            m_file.seek(m_offset);
+            m_mutex.lock();
+            m_failed = true;
+            m_recording = false;
+            m_dropped += m_queue.size() + 1;
+            while (!m_queue.empty())
+                m_queue.pop();
+            m_queued = 0;
+            m_mutex.unlock();
+            emit error("Recording stopped, unable to write to " + m_file.fileName() + ".\n");
+            break;
+        }
+        m_index.push_back(m_offset);
+        m_offset += record.size();
+    }
+}
+
+int Recorder::writeIndex()
+{
+    RecordTrailer trailer;
+    qint64 len;
+
+    trailer.m_magic = REC_INDEX_MAGIC;
+    trailer.m_numFrames = m_index.size();
+    trailer.m_indexOffset = m_offset;
+
+    len = m_index.size()*sizeof(uint64_t);
+    if (len && m_file.write((char *)&m_index[0], len)!=len)
+        return -1;
+    if (m_file.write((char *)&trailer, sizeof(trailer))!=sizeof(trailer))
+        return -1;
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QByteArray>
+#include <queue>
+#include <vector>
+#include "chirp.hpp"
+
+// Recording file layout (all values little-endian):
+//
+// | RecordFileHeader | RecordHeader | payload | pad | RecordHeader | payload | pad | ... | index | RecordTrailer |
+//
+// Each payload is the raw serialized chirp data of one frame, starting with the
+// type hint (BA81, CCQ1, CCB2, etc).  It can be handed to Chirp::deserializeParse() as-is.
+// Records are padded to REC_ALIGN so payloads stay aligned when the file is mapped.
+// The index is an array of 64-bit record offsets, one per frame, written when the
+// recording is closed.  A file without a trailer (e.g. PixyMon crashed) can still be
+// played back-- the index is rebuilt by walking the records.
+
+#define REC_MAGIC               FOURCC('P','X','R','1')
+#define REC_INDEX_MAGIC         FOURCC('P','X','I','1')
+#define REC_VERSION             1
+#define REC_ALIGN               8
+#define REC_MAX_QUEUED          0x4000000 // 64 MB, drop frames if the disk can't keep up
+
+struct RecordFileHeader
+{
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint64_t m_reserved;
+};
+
+struct RecordHeader
+{
+    uint32_t m_type; // fourcc of frame
+    uint32_t m_len; // payload length, not including padding
+    uint64_t m_timestamp; // microseconds since start of recording
+};
+
+struct RecordTrailer
+{
+    uint32_t m_magic;
+    uint32_t m_numFrames;
+    uint64_t m_indexOffset;
+};
+
+class Recorder : public QThread
+{
+    Q_OBJECT
+
+public:
+    Recorder();
+    ~Recorder();
+
+    int open(const QString &filename);
+    int close();
+    bool recording()
+    {
+        return m_recording;
+    }
+
+    // copies frame and hands it to the I/O thread, doesn't block on disk
+    int record(uint32_t type, const uint8_t *data, uint32_t len);
+
+    uint32_t frames()
+    {
+        return m_frames;
+    }
+    uint32_t dropped()
+    {
+        return m_dropped;
+    }
+
+signals:
+    void error(QString text);
+
+protected:
+    virtual void run();
+
+private:
+    int writeIndex();
+
+    QFile m_file;
+    QElapsedTimer m_timer;
+    QMutex m_mutex;
+    QWaitCondition m_wait;
+    std::queue<QByteArray> m_queue;
+    std::vector<uint64_t> m_index;
+    uint64_t m_offset;
+    uint32_t m_queued;
+    uint32_t m_frames;
+    uint32_t m_dropped;
+    bool m_failed; // a write failed, the file ends at the last whole record
+    bool m_recording;
+    bool m_run;
+};
+
+#endif // RECORDER_H
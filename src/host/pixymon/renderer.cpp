@@ -19,6 +19,7 @@
 #include <QFile>
 #include "renderer.h"
 #include "videowidget.h"
+#include "interpreter.h"
 #include <chirp.hpp>
 #include "calc.h"
 #include <math.h>
@@ -28,7 +29,10 @@ Renderer::Renderer(VideoWidget *video, Interpreter *interpreter) : m_blobs(inter
     m_video = video;
     m_interpreter = interpreter;
 
-    m_rawFrame.m_pixels = new uint8_t[0x10000];
+    m_rawFrame.m_pixels = NULL;
+    m_rawFrameBuf = NULL;
+    m_rawFrameCopy = new uint8_t[RENDER_RAW_FRAME_SIZE];
+    m_bandRows = 0;
 
     m_backgroundFrame = true;
 
@@ -41,7 +45,9 @@ Renderer::Renderer(VideoWidget *video, Interpreter *interpreter) : m_blobs(inter
 
 Renderer::~Renderer()
 {
-    delete[] m_rawFrame.m_pixels;
+    if (m_rawFrameBuf)
+        m_rawFrameBuf->release();
+    delete[] m_rawFrameCopy;
 }
 
 
@@ -179,26 +185,57 @@ inline void Renderer::interpolateBayer(unsigned int width, unsigned int x, unsig
 
 
 
-int Renderer::renderBA81(uint8_t renderFlags, uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame)
+// Keep the raw frame around.  A frame chirp has just received is held where it is
+// instead of being copied, anything else (playback) is copied.  Chirp's buffers are
+// only held and released from the thread that services chirp, the interpreter's.
+// Anywhere else, a buffer we're holding stays held until the interpreter's next frame.
+void Renderer::holdRawFrame(uint8_t *frame, uint16_t width, uint16_t height)
 {
-    uint16_t x, y;
-    uint32_t *line;
-    uint32_t r, g, b;
+    ChirpBuffer *buf = NULL;
 
-    memcpy(m_rawFrame.m_pixels, frame, width*height);
+    if (QThread::currentThread()==m_interpreter)
+    {
+        if (m_interpreter->m_chirp)
+            buf = m_interpreter->m_chirp->holdBuffer(frame);
+        releaseRawFrame();
+        m_rawFrameBuf = buf;
+    }
+    if (buf)
+        m_rawFrame.m_pixels = frame;
+    else
+    {
+        memcpy(m_rawFrameCopy, frame, width*height);
+        m_rawFrame.m_pixels = m_rawFrameCopy;
+    }
     m_rawFrame.m_width = width;
     m_rawFrame.m_height = height;
+}
 
-    // skip first line
-    frame += width;
+void Renderer::releaseRawFrame()
+{
+    if (m_rawFrameBuf && QThread::currentThread()==m_interpreter)
+    {
+        m_rawFrameBuf->release();
+        m_rawFrameBuf = NULL;
+    }
+}
 
-    // don't render top and bottom rows, and left and rightmost columns because of color
-    // interpolation
-    QImage img(width-2, height-2, QImage::Format_RGB32);
+// Rows y0 up to y1 of frame into image, which is a row and a column smaller all the way
+// around, since the edges can't be interpolated.
+void Renderer::renderBayerRows(QImage *image, uint8_t *frame, uint16_t width, uint16_t y0, uint16_t y1)
+{
+    uint16_t x, y;
+    uint32_t *line;
+    uint32_t r=0, g=0, b=0;
+
+    // interpolateBayer() leaves even rows with the color of the last pixel of the row above
+    if (!(y0&1))
+        interpolateBayer(width, width-2, y0-1, frame+y0*width-2, r, g, b);
 
-    for (y=1; y<height-1; y++)
+    frame += y0*width;
+    for (y=y0; y<y1; y++)
     {
-        line = (unsigned int *)img.scanLine(y-1);
+        line = (unsigned int *)image->scanLine(y-1);
         frame++;
         for (x=1; x<width-1; x++, frame++)
         {
@@ -207,6 +244,21 @@ int Renderer::renderBA81(uint8_t renderFlags, uint16_t width, uint16_t height, u
         }
         frame++;
     }
+}
+
+int Renderer::renderBA81(uint8_t renderFlags, uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame)
+{
+    if (width<3 || height<3 || (uint32_t)width*height>RENDER_RAW_FRAME_SIZE || frameLen<(uint32_t)width*height)
+        return -1;
+
+    holdRawFrame(frame, width, height);
+
+    // don't render top and bottom rows, and left and rightmost columns because of color
+    // interpolation
+    QImage img(width-2, height-2, QImage::Format_RGB32);
+
+    renderBayerRows(&img, frame, width, 1, height-1);
+
     // send image to ourselves across threads
     // from chirp thread to gui thread
     emitImage(img);
@@ -219,6 +271,54 @@ int Renderer::renderBA81(uint8_t renderFlags, uint16_t width, uint16_t height, u
     return 0;
 }
 
+// A BA81 frame sent a band of rows at a time, as the camera grabs them.  Each band is
+// interpolated as it comes in, so there's only the last band left to do once the frame is
+// all here.  Returns 1 when it is, and the image goes out.  A band that's missing (the
+// rows don't follow on) drops the rest of the frame.
+int Renderer::renderBA8B(uint8_t renderFlags, uint16_t width, uint16_t height, uint16_t row, uint32_t bandLen, uint8_t *band)
+{
+    uint16_t rows;
+
+    if (row==0)
+    {
+        if (width<3 || height<3 || (uint32_t)width*height>RENDER_RAW_FRAME_SIZE)
+            return -1;
+        // the raw frame is put together in our copy
+        releaseRawFrame();
+        m_rawFrame.m_pixels = NULL;
+        m_bandImage = QImage(width-2, height-2, QImage::Format_RGB32);
+    }
+    else if (row!=m_bandRows || m_bandImage.width()!=width-2 || m_bandImage.height()!=height-2)
+        return -1;
+    if (bandLen%width || row+bandLen/width>height)
+    {
+        m_bandRows = 0;
+        return -1;
+    }
+
+    memcpy(m_rawFrameCopy+row*width, band, bandLen);
+    rows = row + bandLen/width;
+    m_bandRows = rows;
+    // a row needs the one above it, so the first row waits for the second
+    renderBayerRows(&m_bandImage, m_rawFrameCopy, width, row ? row : 1, rows<height-1 ? rows : height-1);
+    if (rows<height)
+        return 0;
+
+    m_rawFrame.m_pixels = m_rawFrameCopy;
+    m_rawFrame.m_width = width;
+    m_rawFrame.m_height = height;
+    m_bandRows = 0;
+
+    emitImage(m_bandImage);
+
+    m_background = m_bandImage;
+
+    if (renderFlags&RENDER_FLAG_FLUSH)
+        emitFlushImage();
+
+    return 1;
+}
+
 
 void Renderer::renderBlobsB(QImage *image, float scale, BlobB *blobs, uint32_t numBlobs)
 {
@@ -392,7 +492,7 @@ void Renderer::handleRL(QImage *image, uint color, uint row, uint startCol, uint
 int Renderer::renderCCQ1(uint8_t renderFlags, uint16_t width, uint16_t height, uint32_t numVals, uint32_t *qVals)
 {
     int32_t row;
-    uint32_t i, startCol, length;
+    uint32_t i, qval, startCol, length;
     uint8_t model;
     QImage img(width, height, QImage::Format_ARGB32);
     unsigned int palette[] =
@@ -427,11 +527,13 @@ int Renderer::renderCCQ1(uint8_t renderFlags, uint16_t width, uint16_t height, u
             row++;
             continue;
         }
-        model = qVals[i]&0x07;
-        qVals[i] >>= 3;
-        startCol = qVals[i]&0x1ff;
-        qVals[i] >>= 9;
-        length = qVals[i]&0x1ff;
+        // don't modify qVals, they may be in a recording we're playing back
+        qval = qVals[i];
+        model = qval&0x07;
+        qval >>= 3;
+        startCol = qval&0x1ff;
+        qval >>= 9;
+        length = qval&0x1ff;
         handleRL(&img, palette[model], row, startCol, length);
     }
     emitImage(img);
@@ -450,6 +552,8 @@ int Renderer::renderCMV1(uint8_t renderFlags, uint32_t cmodelsLen, float *cmodel
     uint32_t numQvals;
     uint32_t *qVals;
 
+    if (width<3 || height<3 || (uint32_t)width*height>RENDER_RAW_FRAME_SIZE || frameLen<(uint32_t)width*height)
+        return -1;
     if (cmodelsLen>=sizeof(ColorModel)*NUM_MODELS/sizeof(float)) // create lookup table
     {
         m_blobs.m_blobs->m_clut->clear();
@@ -487,6 +591,8 @@ int Renderer::render(uint32_t type, void *args[])
     // choose fourcc for representing formats fourcc.org
     if (type==FOURCC('B','A','8','1'))
         res = renderBA81(*(uint8_t *)args[0], *(uint16_t *)args[1], *(uint16_t *)args[2], *(uint32_t *)args[3], (uint8_t *)args[4]);
+    else if (type==FOURCC('B','A','8','B'))
+        res = renderBA8B(*(uint8_t *)args[0], *(uint16_t *)args[1], *(uint16_t *)args[2], *(uint16_t *)args[3], *(uint32_t *)args[4], (uint8_t *)args[5]);
     else if (type==FOURCC('C','C','Q','1'))
         res = renderCCQ1(*(uint8_t *)args[0], *(uint16_t *)args[1], *(uint16_t *)args[2], *(uint32_t *)args[3], (uint32_t *)args[4]);
     else if (type==FOURCC('C', 'C', 'B', '1'))
@@ -21,9 +21,12 @@
 #include "processblobs.h"
 
 class Interpreter;
+class ChirpBuffer;
 
 class VideoWidget;
 
+#define RENDER_RAW_FRAME_SIZE   0x10000 // largest raw frame we'll keep
+
 class Renderer : public QObject
 {
     Q_OBJECT
@@ -58,6 +61,8 @@ private:
 
     int renderCCQ1(uint8_t renderFlags, uint16_t width, uint16_t height, uint32_t numVals, uint32_t *qVals);
     int renderBA81(uint8_t renderFlags, uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame);
+    int renderBA8B(uint8_t renderFlags, uint16_t width, uint16_t height, uint16_t row, uint32_t bandLen, uint8_t *band);
+    void renderBayerRows(QImage *image, uint8_t *frame, uint16_t width, uint16_t y0, uint16_t y1);
     int renderCCB1(uint8_t renderFlags, uint16_t width, uint16_t height, uint32_t numBlobs, uint16_t *blobs);
     int renderCCB2(uint8_t renderFlags, uint16_t width, uint16_t height, uint32_t numBlobs, uint16_t *blobs, uint32_t numCCBlobs, uint16_t *ccBlobs);
     int renderCMV1(uint8_t renderFlags, uint32_t cmodelsLen, float *cmodels, uint16_t width, uint16_t height, uint32_t frameLen, uint8_t *frame);
@@ -73,12 +78,21 @@ private:
 
     void pixelsOut(int x0, int y0, int width, int height);
 
+    void holdRawFrame(uint8_t *frame, uint16_t width, uint16_t height);
+    void releaseRawFrame();
+
     VideoWidget *m_video;
     Interpreter *m_interpreter;
 
     bool m_backgroundFrame; // our own copy because we're in a different thread (not gui thread)
     QImage m_background;
 
+    ChirpBuffer *m_rawFrameBuf; // chirp's receive buffer m_rawFrame is in, if it is
+    uint8_t *m_rawFrameCopy; // otherwise it's copied here
+
+    QImage m_bandImage; // BA8B frame being put together
+    uint16_t m_bandRows; // rows of it that are in
+
     uint32_t m_mode;
 };
 
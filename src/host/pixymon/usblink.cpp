@@ -38,6 +38,8 @@ USBLink::~USBLink()
 
 int USBLink::open()
 {
+    int maxPacketSize;
+
     libusb_init(&m_context);
 
     m_handle = libusb_open_device_with_vid_pid(m_context, PIXY_VID, PIXY_DID);
@@ -62,6 +64,10 @@ int USBLink::open()
 #ifdef __LINUX__
     libusb_reset_device(m_handle);
 #endif
+    // 512 if we're high-speed, chirp negotiates its first transfer up to this
+    maxPacketSize = libusb_get_max_packet_size(libusb_get_device(m_handle), 0x82);
+    if (maxPacketSize>0)
+        m_blockSize = maxPacketSize;
     return 0;
 }
 
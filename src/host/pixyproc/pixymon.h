@@ -0,0 +1,27 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// Stand-in for PixyMon's pixymon.h so that the common blob code
+// (blobs.cpp, blob.cpp) can be built without Qt.
+
+#ifndef PIXYMON_H
+#define PIXYMON_H
+
+#include <stdio.h>
+
+#define cprintf(...)  fprintf(stderr, __VA_ARGS__)
+#define qDebug(...)   fprintf(stderr, __VA_ARGS__)
+
+#endif // PIXYMON_H
@@ -0,0 +1,486 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// pixyproc: headless batch processor.  Runs recorded raw (Bayer) frames
+// through the same color-connected-components pipeline Pixy uses
+// (ColorLUT -> run-length segmentation -> Blobs) and prints the blocks
+// found in each frame along with throughput and latency figures.
+//
+// Frames are processed in parallel, one Blobs/Qqueue pair per worker.  They're
+// read from the files a frame at a time as workers take them, and each frame's
+// blocks are printed as soon as it and the frames before it are done, so a day
+// of footage needs no more memory than a few frames.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include <map>
+#include <sys/stat.h>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/chrono.hpp>
+#include "blobs.h"
+#include "colorlut.h"
+#include "qqueue.h"
+#include "rls.h"
+
+#define DEFAULT_WIDTH     320
+#define DEFAULT_HEIGHT    200
+#define PENDING_PER_THREAD 4 // frames read ahead of the oldest one not yet printed
+
+using namespace boost::chrono;
+
+struct FrameResult
+{
+  std::vector<BlobA> blobs;
+  std::vector<BlobB> ccBlobs;
+  uint32_t dropped;
+  uint32_t usecs;
+};
+
+struct Job
+{
+  char **files;
+  int numFiles;
+  uint64_t numFrames;
+  uint16_t width;
+  uint16_t height;
+  const ColorModel *models; // NUM_MODELS entries, m_hue[0].m_slope==0 means unused
+  uint16_t maxBlobs;
+  uint16_t maxBlobsPerModel;
+  uint32_t minArea;
+  ColorCodeMode ccMode;
+  uint32_t runFilter[3]; // min run length, max run gap, vertical run filter
+  bool quiet;
+  uint32_t maxPending;
+
+  // input, the file being read and the next frame in it
+  int file;
+  FILE *fp;
+  uint64_t next;
+  bool error;
+
+  // output, frames done out of order wait in pending until they're next
+  std::map<uint64_t, FrameResult> pending;
+  uint64_t printed;
+  uint64_t totalBlocks;
+  uint64_t droppedFrames;
+  uint64_t sumUsecs;
+  uint32_t minUsecs;
+  uint32_t maxUsecs;
+
+  boost::mutex mutex;
+  boost::condition_variable cond;
+};
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s [options] frame_file...\n"
+    "  -s file     signature file (one signature per line, see below)\n"
+    "  -t s,x,y,w,h  teach signature s (1-7) from a region of the first frame\n"
+    "  -W width    frame width in pixels (default %d)\n"
+    "  -H height   frame height in pixels (default %d)\n"
+    "  -j threads  number of worker threads (default: number of cores)\n"
+    "  -b max      max blocks per frame (default %d)\n"
+    "  -p max      max blocks per signature (default %d)\n"
+    "  -a area     min block area (default %d)\n"
+    "  -c mode     color code mode, 0=disabled, 1=enabled, 2=cc only, 3=mixed (default 1)\n"
+    "  -r len,gap,vert  run filter: min run length, max run gap, and 1=open, 2=close,\n"
+    "              3=both between rows (default 0,0,0, none)\n"
+    "  -q          don't print blocks, only statistics\n"
+    "\n"
+    "Frame files contain one or more raw 8-bit Bayer frames (BA81), back to back.\n"
+    "Signature file lines: sig type hue0_slope hue0_yi hue1_slope hue1_yi sat0_slope sat0_yi sat1_slope sat1_yi\n"
+    "where type is 0 for a normal signature and 1 for a color code signature.\n",
+    name, DEFAULT_WIDTH, DEFAULT_HEIGHT, MAX_BLOBS, MAX_BLOBS_PER_MODEL, MIN_AREA);
+}
+
+static int loadSignatures(const char *filename, ColorModel *models)
+{
+  FILE *file;
+  char line[256];
+  int sig, type, n, lineNum;
+  ColorModel model;
+
+  file = fopen(filename, "r");
+  if (file==NULL)
+  {
+    perror(filename);
+    return -1;
+  }
+
+  for (lineNum=1; fgets(line, sizeof(line), file); lineNum++)
+  {
+    if (line[0]=='#' || line[0]=='\n' || line[0]=='\r')
+      continue;
+    n = sscanf(line, "%d %d %f %f %f %f %f %f %f %f", &sig, &type,
+               &model.m_hue[0].m_slope, &model.m_hue[0].m_yi, &model.m_hue[1].m_slope, &model.m_hue[1].m_yi,
+               &model.m_sat[0].m_slope, &model.m_sat[0].m_yi, &model.m_sat[1].m_slope, &model.m_sat[1].m_yi);
+    if (n!=10 || sig<1 || sig>NUM_MODELS)
+    {
+      fprintf(stderr, "%s:%d: bad signature line\n", filename, lineNum);
+      fclose(file);
+      return -1;
+    }
+    model.m_type = type ? CL_MODEL_TYPE_COLORCODE : 0;
+    models[sig-1] = model;
+  }
+
+  fclose(file);
+  return 0;
+}
+
+static void printSignature(int sig, const ColorModel &model)
+{
+  fprintf(stderr, "%d %d %f %f %f %f %f %f %f %f\n", sig, model.m_type==CL_MODEL_TYPE_COLORCODE,
+          model.m_hue[0].m_slope, model.m_hue[0].m_yi, model.m_hue[1].m_slope, model.m_hue[1].m_yi,
+          model.m_sat[0].m_slope, model.m_sat[0].m_yi, model.m_sat[1].m_slope, model.m_sat[1].m_yi);
+}
+
+// all of the files are there and whole frames, before we start printing blocks
+static int countFrames(int numFiles, char *files[], uint32_t frameSize, uint64_t *numFrames)
+{
+  struct stat st;
+  int i;
+
+  *numFrames = 0;
+  for (i=0; i<numFiles; i++)
+  {
+    if (stat(files[i], &st)<0)
+    {
+      perror(files[i]);
+      return -1;
+    }
+    if (st.st_size<=0 || (uint64_t)st.st_size%frameSize)
+    {
+      fprintf(stderr, "%s: size %llu isn't a multiple of the frame size (%u)\n", files[i],
+              (unsigned long long)st.st_size, frameSize);
+      return -1;
+    }
+    *numFrames += (uint64_t)st.st_size/frameSize;
+  }
+
+  return 0;
+}
+
+static int readFirstFrame(const char *filename, uint8_t *pixels, uint32_t frameSize)
+{
+  FILE *file;
+  size_t n;
+
+  if ((file=fopen(filename, "rb"))==NULL)
+  {
+    perror(filename);
+    return -1;
+  }
+  n = fread(pixels, 1, frameSize, file);
+  fclose(file);
+  if (n!=frameSize)
+  {
+    fprintf(stderr, "%s: unable to read\n", filename);
+    return -1;
+  }
+  return 0;
+}
+
+// The next frame into pixels, going on to the next file at the end of one.  We
+// don't read further ahead than maxPending of the oldest frame not yet printed.
+static int readFrame(Job *job, uint8_t *pixels, uint64_t *index)
+{
+  uint32_t frameSize = job->width*job->height;
+  boost::unique_lock<boost::mutex> lock(job->mutex);
+
+  while (!job->error && job->next<job->numFrames && job->next-job->printed>=job->maxPending)
+    job->cond.wait(lock);
+
+  while (!job->error && job->next<job->numFrames)
+  {
+    if (job->fp==NULL)
+    {
+      if ((job->fp=fopen(job->files[job->file], "rb"))==NULL)
+      {
+        perror(job->files[job->file]);
+        break;
+      }
+    }
+    if (fread(pixels, 1, frameSize, job->fp)==frameSize)
+    {
+      *index = job->next++;
+      return 0;
+    }
+    if (ferror(job->fp))
+    {
+      fprintf(stderr, "%s: unable to read\n", job->files[job->file]);
+      break;
+    }
+    fclose(job->fp);
+    job->fp = NULL;
+    job->file++;
+  }
+
+  if (job->next<job->numFrames)
+  {
+    // out of frames early, stop everyone
+    job->error = true;
+    job->cond.notify_all();
+  }
+  return -1;
+}
+
+static void printResult(uint64_t index, const FrameResult &result)
+{
+  uint32_t j;
+
+  printf("frame %llu: %u blocks\n", (unsigned long long)index, (uint32_t)(result.blobs.size() + result.ccBlobs.size()));
+  for (j=0; j<result.ccBlobs.size(); j++)
+  {
+    const BlobB &b = result.ccBlobs[j];
+    printf("[sig:%2o w:%3u h:%3u x:%3u y:%3u ang:%3i]\n", b.m_model, b.m_right-b.m_left, b.m_bottom-b.m_top,
+           (b.m_left+b.m_right)/2, (b.m_top+b.m_bottom)/2, b.m_angle);
+  }
+  for (j=0; j<result.blobs.size(); j++)
+  {
+    const BlobA &b = result.blobs[j];
+    printf("[sig:%2u w:%3u h:%3u x:%3u y:%3u]\n", b.m_model, b.m_right-b.m_left, b.m_bottom-b.m_top,
+           (b.m_left+b.m_right)/2, (b.m_top+b.m_bottom)/2);
+  }
+}
+
+// a frame is done, print it and any after it that were waiting on it, in frame order
+static void report(Job *job, uint64_t index, const FrameResult &result)
+{
+  std::map<uint64_t, FrameResult>::iterator it;
+  boost::unique_lock<boost::mutex> lock(job->mutex);
+
+  job->pending[index] = result;
+  while ((it=job->pending.find(job->printed))!=job->pending.end())
+  {
+    const FrameResult &done = it->second;
+
+    job->totalBlocks += done.blobs.size() + done.ccBlobs.size();
+    if (done.dropped)
+      job->droppedFrames++;
+    job->sumUsecs += done.usecs;
+    if (done.usecs<job->minUsecs)
+      job->minUsecs = done.usecs;
+    if (done.usecs>job->maxUsecs)
+      job->maxUsecs = done.usecs;
+    if (!job->quiet)
+      printResult(job->printed, done);
+
+    job->pending.erase(it);
+    job->printed++;
+  }
+  job->cond.notify_all();
+}
+
+static void worker(Job *job)
+{
+  uint32_t i, j, numBlobs, numCCBlobs;
+  uint64_t index;
+  BlobA *blobs;
+  BlobB *ccBlobs;
+  steady_clock::time_point start;
+  Qqueue qq;
+  Blobs blobber(&qq);
+  std::vector<uint8_t> pixels(job->width*job->height);
+
+  // each worker has its own lut copy, so workers share nothing but the frames
+  blobber.m_clut->clear();
+  for (i=0; i<NUM_MODELS; i++)
+  {
+    if (job->models[i].m_hue[0].m_slope!=0.0f)
+      blobber.m_clut->add(&job->models[i], i+1);
+  }
+  blobber.setParams(job->maxBlobs, job->maxBlobsPerModel, job->minArea, job->ccMode);
+  blobber.setRunFilter(job->runFilter[0], job->runFilter[1], job->runFilter[2]);
+
+  while (readFrame(job, &pixels[0], &index)==0)
+  {
+    FrameResult result;
+    Frame8 frame(&pixels[0], job->width, job->height);
+
+    start = steady_clock::now();
+    result.dropped = rls(frame, blobber.m_lut, &qq);
+    blobber.blobify();
+    blobber.getBlobs(&blobs, &numBlobs, &ccBlobs, &numCCBlobs);
+    result.usecs = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    for (j=0; j<numBlobs; j++)
+      result.blobs.push_back(blobs[j]);
+    for (j=0; j<numCCBlobs; j++)
+      result.ccBlobs.push_back(ccBlobs[j]);
+    report(job, index, result);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int opt, sig;
+  uint32_t i, numThreads, frameSize, x, y, w, h;
+  double secs;
+  bool teach[NUM_MODELS];
+  RectA teachRegion[NUM_MODELS];
+  ColorModel models[NUM_MODELS];
+  steady_clock::time_point start;
+  std::vector<boost::thread *> threads;
+  Job job;
+
+  job.width = DEFAULT_WIDTH;
+  job.height = DEFAULT_HEIGHT;
+  job.maxBlobs = MAX_BLOBS;
+  job.maxBlobsPerModel = MAX_BLOBS_PER_MODEL;
+  job.minArea = MIN_AREA;
+  job.ccMode = ENABLED;
+  memset(job.runFilter, 0, sizeof(job.runFilter));
+  job.quiet = false;
+  job.file = 0;
+  job.fp = NULL;
+  job.next = 0;
+  job.error = false;
+  job.printed = 0;
+  job.totalBlocks = job.droppedFrames = job.sumUsecs = 0;
+  job.minUsecs = 0xffffffff;
+  job.maxUsecs = 0;
+  numThreads = boost::thread::hardware_concurrency();
+  if (numThreads==0)
+    numThreads = 1;
+  memset(teach, 0, sizeof(teach));
+
+  while ((opt=getopt(argc, argv, "s:t:W:H:j:b:p:a:c:r:q"))!=-1)
+  {
+    switch (opt)
+    {
+    case 's':
+      if (loadSignatures(optarg, models)<0)
+        return 1;
+      break;
+    case 't':
+      if (sscanf(optarg, "%d,%u,%u,%u,%u", &sig, &x, &y, &w, &h)!=5 || sig<1 || sig>NUM_MODELS)
+      {
+        fprintf(stderr, "bad teach region: %s\n", optarg);
+        return 1;
+      }
+      teach[sig-1] = true;
+      teachRegion[sig-1] = RectA(x, y, w, h);
+      break;
+    case 'W':
+      job.width = atoi(optarg);
+      break;
+    case 'H':
+      job.height = atoi(optarg);
+      break;
+    case 'j':
+      numThreads = atoi(optarg);
+      break;
+    case 'b':
+      job.maxBlobs = atoi(optarg);
+      break;
+    case 'p':
+      job.maxBlobsPerModel = atoi(optarg);
+      break;
+    case 'a':
+      job.minArea = atoi(optarg);
+      break;
+    case 'c':
+      job.ccMode = (ColorCodeMode)atoi(optarg);
+      break;
+    case 'r':
+      if (sscanf(optarg, "%u,%u,%u", &job.runFilter[0], &job.runFilter[1], &job.runFilter[2])!=3)
+      {
+        fprintf(stderr, "bad run filter: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case 'q':
+      job.quiet = true;
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (optind>=argc || job.width<2 || job.height<2 || numThreads<1)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  frameSize = job.width*job.height;
+  job.files = argv+optind;
+  job.numFiles = argc-optind;
+  job.maxPending = numThreads*PENDING_PER_THREAD;
+  if (countFrames(job.numFiles, job.files, frameSize, &job.numFrames)<0)
+    return 1;
+
+  // teach any requested signatures from the first frame
+  {
+    Qqueue qq;
+    Blobs teacher(&qq);
+    std::vector<uint8_t> pixels(frameSize);
+    Frame8 frame(&pixels[0], job.width, job.height);
+
+    if (readFirstFrame(job.files[0], &pixels[0], frameSize)<0)
+      return 1;
+
+    // same bounds as Pixy's default "Min saturation", "Hue spread" and "Saturation spread"
+    teacher.m_clut->setBounds(15.0f, 1.5f, 1.5f);
+    for (i=0; i<NUM_MODELS; i++)
+    {
+      if (!teach[i])
+        continue;
+      if (teacher.generateLUT(i+1, frame, teachRegion[i], &models[i])<0)
+      {
+        fprintf(stderr, "signature %d: color saturation isn't high enough!\n", i+1);
+        return 1;
+      }
+      printSignature(i+1, models[i]);
+    }
+  }
+
+  job.models = models;
+
+  // process
+  start = steady_clock::now();
+  for (i=0; i<numThreads; i++)
+    threads.push_back(new boost::thread(worker, &job));
+  for (i=0; i<numThreads; i++)
+  {
+    threads[i]->join();
+    delete threads[i];
+  }
+  secs = duration_cast<duration<double> >(steady_clock::now() - start).count();
+
+  if (job.fp)
+    fclose(job.fp);
+  if (job.error)
+    return 1;
+
+  fprintf(stderr, "%llu frames, %u threads, %llu blocks\n", (unsigned long long)job.numFrames, numThreads,
+          (unsigned long long)job.totalBlocks);
+  fprintf(stderr, "throughput: %.1f frames/sec (%.3f sec total)\n", job.numFrames/secs, secs);
+  fprintf(stderr, "latency: min %u us, avg %u us, max %u us\n", job.minUsecs,
+          (uint32_t)(job.sumUsecs/job.numFrames), job.maxUsecs);
+  if (job.droppedFrames)
+    fprintf(stderr, "warning: %llu frames overflowed the Qval queue and were truncated\n",
+            (unsigned long long)job.droppedFrames);
+
+  return 0;
+}
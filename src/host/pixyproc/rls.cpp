@@ -0,0 +1,84 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include "rls.h"
+
+// leave room for the end-of-frame marker
+#define RLS_MAX_QVALS  (QQ_MEM_SIZE-1)
+
+static inline uint32_t put(Qqueue *qq, Qval val)
+{
+  if (qq->queued()>=RLS_MAX_QVALS)
+    return 1;
+  qq->enqueue(val);
+  return 0;
+}
+
+uint32_t rls(const Frame8 &frame, const uint8_t *lut, Qqueue *qq)
+{
+  uint32_t y, index, startCol, model, prevModel, r, g1, g2, b;
+  uint32_t dropped = 0;
+  int32_t x, c1, c2; // signed, pixel indexes below can be negative
+  const uint8_t *line;
+
+  for (y=1; y<(uint32_t)frame.m_height; y+=2)
+  {
+    // new line
+    dropped += put(qq, 0);
+
+    line = frame.m_pixels + y*frame.m_width;
+    prevModel = 0;
+    startCol = 0;
+    for (x=1; x<frame.m_width; x+=2)
+    {
+      r = line[x];
+      g1 = line[x - 1];
+      g2 = line[x - frame.m_width];
+      b = line[x - frame.m_width - 1];
+      c2 = r-g1;
+      c1 = b-g2;
+      c1 >>= 1;
+      c2 >>= 1;
+      index = ((uint8_t)c2<<8) | (uint8_t)c1;
+      model = lut[index]&0x07;
+
+      if (model && prevModel==0)
+        startCol = x/2;
+      if ((model && prevModel && model!=prevModel) ||
+          (model==0 && prevModel))
+      {
+        model = prevModel;
+        model |= startCol<<3;
+        model |= (x/2-startCol)<<12;
+        dropped += put(qq, model);
+        model = 0;
+        startCol = 0;
+      }
+      prevModel = model;
+    }
+    if (startCol)
+    {
+      model = prevModel;
+      model |= startCol<<3;
+      model |= (x/2-startCol)<<12;
+      dropped += put(qq, model);
+    }
+  }
+
+  // indicate end of frame
+  qq->enqueue(0xffffffff);
+
+  return dropped;
+}
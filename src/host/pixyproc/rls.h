@@ -0,0 +1,38 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef __RLS_H__
+#define __RLS_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "pixytypes.h"
+#include "qqueue.h"
+
+/**
+  @brief      Host version of the M0 run-length segmenter (see rls_m0.c and
+              ProcessBlobs::rls() in PixyMon).  Converts a raw Bayer frame
+              into Qvals using the color lookup table and enqueues them,
+              followed by the end-of-frame marker.
+              Segments that don't fit in the queue are dropped, but the
+              end-of-frame marker is always enqueued.
+  @param[in]  frame  Raw Bayer frame.
+  @param[in]  lut    Color lookup table (CL_LUT_SIZE entries).
+  @param[out] qq     Queue to write Qvals to.  Should be empty.
+  @return     Number of segments dropped because the queue was full.
+*/
+uint32_t rls(const Frame8 &frame, const uint8_t *lut, Qqueue *qq);
+
+#endif
@@ -0,0 +1,161 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// pixyrelay -- makes a Pixy plugged into this machine reachable over the network.
+// It passes USB transfers to and from one socket client at a time, libpixyusb or
+// PixyMon with PIXY_ADDRESS set to this machine's address, e.g. "robot:7000".
+// Anyone who can connect gets the Pixy, so by default only this machine can,
+// "-l :7000" opens it to the network.
+// Nothing here knows about chirp, transfers are passed on as they come, keeping
+// track of which ones ended in a short packet (see socketlink.h).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <vector>
+#include <boost/thread/thread.hpp>
+#include "pixydefs.h"
+#include "usblink.h"
+#include "socketlink.h"
+
+#define DEFAULT_ADDRESS     "localhost:7000"
+#define POLL_TIMEOUT        100 // ms, how often we look to see if the client has gone
+#define SEND_TIMEOUT        1000 // ms
+#define PACKETS_PER_FRAME   32 // full packets passed on together while more keep coming
+#define FRAME_SIZE          0x10000
+
+static volatile bool g_quit = false;
+
+static void handleSignal(int sig)
+{
+  g_quit = true;
+}
+
+// Client to Pixy, in its own thread so neither direction waits on the other.  Whichever
+// direction fails first shuts the socket down, which stops the other one too.
+static void upstream(USBLink *usb, SocketLink *socket)
+{
+  std::vector<uint8_t> buf(FRAME_SIZE);
+  int res;
+
+  while (!g_quit && socket->connected())
+  {
+    if ((res=socket->receiveFrame(&buf[0], buf.size(), POLL_TIMEOUT))<=0)
+      continue;
+    if ((res=usb->send(&buf[0], res, SEND_TIMEOUT))<0 && res!=LIBUSB_ERROR_TIMEOUT)
+    {
+      fprintf(stderr, "pixyrelay: lost Pixy (%d)\n", res);
+      g_quit = true;
+    }
+  }
+  socket->shutdown();
+}
+
+// Pixy to client.  USB is read a packet at a time, a packet is never split across
+// reads, so a timeout can't lose half of one.  Full packets are held back while the
+// next one follows closely, a short packet (or a pause) sends them on.
+static void downstream(USBLink *usb, SocketLink *socket)
+{
+  uint32_t packet = usb->blockSize();
+  std::vector<uint8_t> buf(packet*PACKETS_PER_FRAME);
+  uint32_t len = 0;
+  int res;
+
+  while (!g_quit && socket->connected())
+  {
+    res = usb->receive(&buf[len], packet, len ? 1 : POLL_TIMEOUT);
+    if (res>0)
+      len += res;
+    if (len && (res<=0 || res<(int)packet || len==buf.size()))
+    {
+      if (socket->send(&buf[0], len, SEND_TIMEOUT)<0)
+        break; // the client has gone, or isn't reading
+      len = 0;
+    }
+    if (res<0 && res!=LIBUSB_ERROR_TIMEOUT)
+    {
+      fprintf(stderr, "pixyrelay: lost Pixy (%d)\n", res);
+      g_quit = true;
+    }
+  }
+  socket->shutdown();
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: pixyrelay [options]\n"
+    "  -l address   listen on host:port, :port (any interface) or a Unix socket path\n"
+    "               (default %s)\n",
+    DEFAULT_ADDRESS);
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  int c, res;
+  const char *address=DEFAULT_ADDRESS;
+  USBLink usb;
+  SocketLink socket;
+
+  while ((c=getopt(argc, argv, "l:"))!=-1)
+  {
+    switch (c)
+    {
+    case 'l':
+      address = optarg;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind<argc)
+    usage();
+
+  if ((res=usb.open())<0)
+  {
+    fprintf(stderr, "pixyrelay: unable to open Pixy (%d)\n", res);
+    return 1;
+  }
+  // frames from the client end in a short packet where the USB transfer did
+  socket.setBlockSize(usb.blockSize());
+  if (socket.listen(address)<0)
+  {
+    fprintf(stderr, "pixyrelay: unable to listen on %s\n", address);
+    return 1;
+  }
+  signal(SIGINT, handleSignal);
+  signal(SIGTERM, handleSignal);
+  printf("pixyrelay: listening on %s\n", address);
+  fflush(stdout);
+
+  while (!g_quit)
+  {
+    if (socket.accept(POLL_TIMEOUT)<0)
+      continue;
+    printf("pixyrelay: client connected\n");
+    fflush(stdout);
+    boost::thread thread(upstream, &usb, &socket);
+    downstream(&usb, &socket);
+    thread.join();
+    printf("pixyrelay: client gone, %llu bytes in, %llu bytes out\n",
+           (unsigned long long)socket.m_recvBytes, (unsigned long long)socket.m_sentBytes);
+    fflush(stdout);
+    socket.close(); // only now that neither thread is using it
+  }
+
+  return 0;
+}
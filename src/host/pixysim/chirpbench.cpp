@@ -0,0 +1,611 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// chirpbench -- measures the chirp protocol by itself, with a client and a server
+// in two threads connected by a LoopbackLink pair.  Small calls show the per-call
+// cost (serialization, framing, CRCs, acks), frame-sized responses sent with
+// UINTS8_NO_COPY show throughput.  Latency, a bandwidth cap and bit errors can be
+// added to the link to see how each protocol mode copes.  The same small calls are
+// also run pipelined, several in flight at once, to show what that saves when the
+// link has latency, batched into one chirp each way, and with the typed calls in
+// chirptyped.hpp instead of va_args.
+// The frames are run again with each one held past the next receive (zero-copy).
+// The two ends' block sizes can differ, to see what init negotiates for the first
+// transfer of each chirp.
+// Without error correction, a recovery case runs small calls on a clean link, then
+// through a burst of bit errors, then on the clean link again.  The calls after the
+// burst have to go through, without a reconnect.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include "chirp.hpp"
+#include "chirptyped.hpp"
+#include "loopback.h"
+#include "sim.h"
+
+#define DEFAULT_CALLS       10000
+#define DEFAULT_FRAMES      100
+#define DEFAULT_FRAME_SIZE  (320*200) // a mode 1 frame, as PixyMon grabs it
+#define DEFAULT_DEPTH       8
+#define MAX_DEPTH           64
+#define MAX_FAILURES        10 // in a row, the link is probably out of sync for good
+#define DEFAULT_BURST_BITS  5000 // recovery case's bit error rate, unless -e is given
+#define RECOVERY_CALLS      500 // most calls in each phase of the recovery case, a failure can take seconds
+
+static uint32_t bench_echo(const uint32_t &val, Chirp *chirp);
+static uint32_t bench_frame(const uint32_t &len, const uint32_t &seed, Chirp *chirp);
+static uint32_t bench_bye(Chirp *chirp);
+
+static const ProcModule g_module[] =
+{
+  {
+  "echo",
+  (ProcPtr)bench_echo,
+  {CRP_UINT32, END},
+  "Return the argument"
+  "@p value"
+  "@r value"
+  },
+  {
+  "frame",
+  (ProcPtr)bench_frame,
+  {CRP_UINT32, CRP_UINT32, END},
+  "Return a frame-sized array, the way cam_getFrameChirp() does"
+  "@p length in bytes"
+  "@p seed, byte i is (seed+i)&0xff"
+  "@r 0"
+  },
+  {
+  "bye",
+  (ProcPtr)bench_bye,
+  {END},
+  "Stop serving"
+  "@r 0"
+  },
+  END
+};
+
+// The device side.  It's a client of nobody, it just answers calls until "bye".
+class BenchServer : public Chirp
+{
+public:
+  BenchServer(Link *link) : Chirp(false, false, link)
+  {
+    registerModule(g_module);
+    m_done = false;
+  }
+
+  void run()
+  {
+    uint8_t type;
+    ChirpProc proc;
+    void *args[CRP_MAX_ARGS+1];
+
+    while (!m_done)
+    {
+      if (recvChirp(&type, &proc, args, true)==CRP_RES_OK)
+        handleChirp(type, proc, args);
+    }
+  }
+
+  std::vector<uint8_t> m_frame;
+  volatile bool m_done;
+};
+
+// The host side.  Chirp gives up on the connection when a send fails, like
+// PixyMon would after a USB error, so we reconnect and carry on.
+class BenchClient : public Chirp
+{
+public:
+  BenchClient(Link *link) : Chirp(false, true, link)
+  {
+    m_reconnects = 0;
+  }
+
+  void check()
+  {
+    if (!connected())
+    {
+      m_reconnects++;
+      remoteInit(true);
+    }
+  }
+
+  uint32_t m_reconnects;
+};
+
+static uint32_t bench_echo(const uint32_t &val, Chirp *chirp)
+{
+  return val;
+}
+
+static uint32_t bench_frame(const uint32_t &len, const uint32_t &seed, Chirp *chirp)
+{
+  BenchServer *server = (BenchServer *)chirp;
+  int hlen;
+  uint32_t i;
+
+  server->m_frame.resize(len+CRP_MAX_HEADER_LEN+CRP_BUFSIZE);
+  hlen = Chirp::serialize(chirp, &server->m_frame[0], server->m_frame.size(), UINTS8_NO_COPY(len), END);
+  if (hlen<0)
+    return hlen;
+  for (i=0; i<len; i++)
+    server->m_frame[hlen+i] = seed+i;
+  chirp->useBuffer(&server->m_frame[0], hlen+len);
+
+  return 0;
+}
+
+static uint32_t bench_bye(Chirp *chirp)
+{
+  ((BenchServer *)chirp)->m_done = true;
+  return 0;
+}
+
+struct Result
+{
+  std::vector<uint32_t> usecs;
+  uint32_t failed;
+  uint32_t failedInRow;
+  uint32_t corrupted;
+  uint64_t bytes;
+  uint64_t total;
+};
+
+static void report(const char *name, Result *result)
+{
+  std::vector<uint32_t> &u = result->usecs;
+  uint32_t n = u.size();
+
+  if (n==0)
+    printf("  %-8s no calls completed, %u failed\n", name, result->failed);
+  else
+  {
+    std::sort(u.begin(), u.end());
+    printf("  %-8s %8.0f calls/s %8.2f MB/s   latency us: min %u median %u p99 %u max %u   failed %u corrupted %u\n",
+           name, n*1e6/result->total, result->bytes/(double)result->total, u[0], u[(n-1)/2], u[(n-1)*99/100], u[n-1],
+           result->failed, result->corrupted);
+  }
+  if (result->failedInRow>=MAX_FAILURES)
+    printf("  %-8s gave up after %d failures in a row\n", "", MAX_FAILURES);
+  fflush(stdout);
+}
+
+static bool frameOk(const uint8_t *data, uint32_t len, uint32_t frameSize, uint32_t seed)
+{
+  uint32_t i;
+
+  for (i=0; i<len && data[i]==(uint8_t)(seed+i); i++);
+  return len==frameSize && i==len;
+}
+
+static void runMode(uint32_t flags, uint32_t blockSize, uint32_t deviceBlockSize, uint32_t latency, uint32_t overhead,
+                    uint32_t bandwidth, uint32_t errorBits, uint32_t calls, uint32_t depth, uint32_t frames, uint32_t frameSize)
+{
+  uint32_t i, j, n, response, len;
+  uint8_t tags[MAX_DEPTH];
+  uint64_t sent[MAX_DEPTH];
+  uint8_t *data, *heldData = NULL;
+  uint32_t heldLen = 0, heldSeed = 0;
+  ChirpBuffer *heldBuf = NULL;
+  uint64_t start, t, begin;
+  int res;
+  ChirpProc echo, frame, bye;
+  Result small = Result(), typed = Result(), piped = Result(), batch = Result(), large = Result(), held = Result();
+  LoopbackLink host(flags, blockSize), device(flags, deviceBlockSize);
+
+  host.connect(&device);
+  host.setBlocking(true);
+  device.setBlocking(true);
+  host.setLatency(latency);
+  device.setLatency(latency);
+  host.setOverhead(overhead);
+  device.setOverhead(overhead);
+  host.setBandwidth(bandwidth);
+  device.setBandwidth(bandwidth);
+  if (errorBits)
+  {
+    host.setBitErrors(errorBits, 1);
+    device.setBitErrors(errorBits, 2);
+  }
+
+  printf("%s, block size %u/%u:\n", flags&LINK_FLAG_ERROR_CORRECTED ? "error corrected" : "not error corrected",
+         blockSize, deviceBlockSize);
+
+  BenchServer server(&device);
+  boost::thread thread(&BenchServer::run, &server);
+
+  BenchClient client(&host);
+  echo = client.getProc("echo");
+  frame = client.getProc("frame");
+  bye = client.getProc("bye");
+  if (!client.connected() || echo<0 || frame<0 || bye<0)
+  {
+    printf("  unable to connect\n");
+    server.m_done = true;
+    thread.join();
+    return;
+  }
+
+  for (i=0, begin=sim_usecs(); i<calls && small.failedInRow<MAX_FAILURES; i++)
+  {
+    start = sim_usecs();
+    res = client.callSync(echo, UINT32(i), END_OUT_ARGS, &response, END_IN_ARGS);
+    t = sim_usecs();
+    if (res<0)
+    {
+      small.failed++;
+      small.failedInRow++;
+      client.check();
+    }
+    else
+    {
+      small.failedInRow = 0;
+      small.usecs.push_back(t-start);
+      small.bytes += sizeof(uint32_t);
+      if (response!=i)
+        small.corrupted++;
+    }
+  }
+  small.total = sim_usecs()-begin;
+
+  for (i=0, begin=sim_usecs(); i<calls && typed.failedInRow<MAX_FAILURES; i++)
+  {
+    start = sim_usecs();
+    res = chirp::call(&client, echo, std::make_tuple(i), &response);
+    t = sim_usecs();
+    if (res<0)
+    {
+      typed.failed++;
+      typed.failedInRow++;
+      client.check();
+    }
+    else
+    {
+      typed.failedInRow = 0;
+      typed.usecs.push_back(t-start);
+      typed.bytes += sizeof(uint32_t);
+      if (response!=i)
+        typed.corrupted++;
+    }
+  }
+  typed.total = sim_usecs()-begin;
+
+  // keep depth calls in flight, latency is from sending a call to collecting its response
+  for (i=0, begin=sim_usecs(); i<calls && piped.failedInRow<MAX_FAILURES; i+=n)
+  {
+    for (n=0; n<depth && i+n<calls; n++)
+    {
+      sent[n] = sim_usecs();
+      if (client.callPipelined(echo, UINT32(i+n), END_OUT_ARGS)<0)
+        break;
+      tags[n] = client.lastTag();
+    }
+    for (j=0; j<n; j++)
+    {
+      res = client.getResponse(tags[j], &response, END_IN_ARGS);
+      t = sim_usecs();
+      if (res<0)
+      {
+        piped.failed++;
+        piped.failedInRow++;
+      }
+      else
+      {
+        piped.failedInRow = 0;
+        piped.usecs.push_back(t-sent[j]);
+        piped.bytes += sizeof(uint32_t);
+        if (response!=i+j)
+          piped.corrupted++;
+      }
+    }
+    if (n<depth && i+n<calls) // send failed
+    {
+      piped.failed++;
+      piped.failedInRow++;
+      n++;
+    }
+    client.check();
+  }
+  piped.total = sim_usecs()-begin;
+
+  // depth calls in each batch, latency is the whole batch's
+  for (i=0, begin=sim_usecs(); i<calls && batch.failedInRow<MAX_FAILURES; i+=n)
+  {
+    start = sim_usecs();
+    client.batchBegin();
+    for (n=0; n<depth && i+n<calls; n++)
+      client.batchAdd(echo, UINT32(i+n), END);
+    res = client.batchCall();
+    t = sim_usecs();
+    if (res!=(int)n)
+    {
+      batch.failed += n;
+      batch.failedInRow++;
+      client.check();
+      continue;
+    }
+    batch.failedInRow = 0;
+    for (j=0; j<n; j++)
+    {
+      batch.usecs.push_back(t-start);
+      batch.bytes += sizeof(uint32_t);
+      if (client.batchResponse(j, &response, END_IN_ARGS)<0 || response!=i+j)
+        batch.corrupted++;
+    }
+  }
+  batch.total = sim_usecs()-begin;
+
+  for (i=0, begin=sim_usecs(); i<frames && large.failedInRow<MAX_FAILURES; i++)
+  {
+    start = sim_usecs();
+    res = client.callSync(frame, UINT32(frameSize), UINT32(i), END_OUT_ARGS, &response, &len, &data, END_IN_ARGS);
+    t = sim_usecs();
+    if (res<0)
+    {
+      large.failed++;
+      large.failedInRow++;
+      client.check();
+    }
+    else
+    {
+      large.failedInRow = 0;
+      large.usecs.push_back(t-start);
+      large.bytes += len;
+      if (!frameOk(data, len, frameSize, i))
+        large.corrupted++;
+    }
+  }
+  large.total = sim_usecs()-begin;
+
+  // The same, but each frame is held, the way PixyMon's renderer holds the frame it's
+  // showing, until the next one is in.  It's checked again then, so it's counted as
+  // corrupted if the receive wrote over it.
+  for (i=0, begin=sim_usecs(); i<frames && held.failedInRow<MAX_FAILURES; i++)
+  {
+    start = sim_usecs();
+    res = client.callSync(frame, UINT32(frameSize), UINT32(i), END_OUT_ARGS, &response, &len, &data, END_IN_ARGS);
+    t = sim_usecs();
+    if (res<0)
+    {
+      held.failed++;
+      held.failedInRow++;
+      client.check();
+      continue;
+    }
+    held.failedInRow = 0;
+    held.usecs.push_back(t-start);
+    held.bytes += len;
+    if (heldBuf)
+    {
+      if (!frameOk(heldData, heldLen, frameSize, heldSeed))
+        held.corrupted++;
+      heldBuf->release();
+    }
+    if ((heldBuf=client.holdBuffer(data))==NULL)
+      held.corrupted++;
+    heldData = data;
+    heldLen = len;
+    heldSeed = i;
+  }
+  if (heldBuf)
+  {
+    if (!frameOk(heldData, heldLen, frameSize, heldSeed))
+      held.corrupted++;
+    heldBuf->release();
+  }
+  held.total = sim_usecs()-begin;
+
+  // if bye gets lost, the server still stops at its next receive timeout
+  client.callSync(bye, END_OUT_ARGS, &response, END_IN_ARGS);
+  server.m_done = true;
+  thread.join();
+
+  report("rpc", &small);
+  report("typed", &typed);
+  report("piped", &piped);
+  report("batch", &batch);
+  report("frame", &large);
+  report("held", &held);
+  printf("  link: %llu bytes sent in %u transfers, %llu received, %u bit errors, %u reconnects\n",
+         (unsigned long long)(host.m_sentBytes+device.m_sentBytes), host.m_sends+device.m_sends,
+         (unsigned long long)(host.m_recvBytes+device.m_recvBytes), host.m_bitErrors+device.m_bitErrors,
+         client.m_reconnects);
+}
+
+static void echoCalls(BenchClient *client, ChirpProc echo, uint32_t calls, Result *result)
+{
+  uint32_t i, response;
+  uint64_t start, t, begin;
+
+  for (i=0, begin=sim_usecs(); i<calls && result->failedInRow<MAX_FAILURES; i++)
+  {
+    start = sim_usecs();
+    if (client->callSync(echo, UINT32(i), END_OUT_ARGS, &response, END_IN_ARGS)<0)
+    {
+      result->failed++;
+      result->failedInRow++;
+      client->check();
+      continue;
+    }
+    t = sim_usecs();
+    result->failedInRow = 0;
+    result->usecs.push_back(t-start);
+    result->bytes += sizeof(uint32_t);
+    if (response!=i)
+      result->corrupted++;
+  }
+  result->total = sim_usecs()-begin;
+}
+
+// The server is stopped between phases, so the bit errors change while neither end is
+// sending.  It stops at its next receive timeout.
+static void runRecovery(uint32_t blockSize, uint32_t errorBits, uint32_t calls)
+{
+  uint32_t response;
+  ChirpProc echo, bye;
+  Result before = Result(), burst = Result(), after = Result();
+  LoopbackLink host(0, blockSize), device(0, blockSize);
+  boost::thread *thread;
+
+  host.connect(&device);
+  host.setBlocking(true);
+  device.setBlocking(true);
+
+  printf("recovery, 1 bit in %u flipped for %u calls:\n", errorBits, calls);
+
+  BenchServer server(&device);
+  thread = new boost::thread(&BenchServer::run, &server);
+
+  BenchClient client(&host);
+  echo = client.getProc("echo");
+  bye = client.getProc("bye");
+  if (!client.connected() || echo<0 || bye<0)
+  {
+    printf("  unable to connect\n");
+    server.m_done = true;
+    thread->join();
+    delete thread;
+    return;
+  }
+
+  echoCalls(&client, echo, calls, &before);
+
+  server.m_done = true;
+  thread->join();
+  delete thread;
+  host.setBitErrors(errorBits, 3);
+  device.setBitErrors(errorBits, 4);
+  server.m_done = false;
+  thread = new boost::thread(&BenchServer::run, &server);
+
+  echoCalls(&client, echo, calls, &burst);
+
+  server.m_done = true;
+  thread->join();
+  delete thread;
+  host.setBitErrors(0);
+  device.setBitErrors(0);
+  server.m_done = false;
+  thread = new boost::thread(&BenchServer::run, &server);
+
+  echoCalls(&client, echo, calls, &after);
+
+  client.callSync(bye, END_OUT_ARGS, &response, END_IN_ARGS);
+  server.m_done = true;
+  thread->join();
+  delete thread;
+
+  report("before", &before);
+  report("burst", &burst);
+  report("after", &after);
+  printf("  link: %u bit errors, %u reconnects, framing with %s\n", host.m_bitErrors+device.m_bitErrors,
+         client.m_reconnects, client.crc16() ? "crc16" : "the sum");
+  if (after.failed || after.corrupted)
+    printf("  did not recover\n");
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: chirpbench [options]\n"
+    "  -n calls    small calls (default %d)\n"
+    "  -p depth    pipelined calls in flight, and calls per batch (default %d, max %d)\n"
+    "  -f frames   frame-sized calls (default %d)\n"
+    "  -s bytes    frame size (default %d)\n"
+    "  -k bytes    link block size (default 64)\n"
+    "  -d bytes    device end's block size (default the same)\n"
+    "  -l us       one-way latency (default 0)\n"
+    "  -o us       overhead per transfer (default 0)\n"
+    "  -b bytes/s  bandwidth (default unlimited)\n"
+    "  -e bits     flip one bit in this many, on average (default none, %d in the\n"
+    "              recovery case)\n"
+    "  -m mode     ec (error corrected) or nec (not), default both\n",
+    DEFAULT_CALLS, DEFAULT_DEPTH, MAX_DEPTH, DEFAULT_FRAMES, DEFAULT_FRAME_SIZE, DEFAULT_BURST_BITS);
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  int c;
+  uint32_t calls=DEFAULT_CALLS, depth=DEFAULT_DEPTH, frames=DEFAULT_FRAMES, frameSize=DEFAULT_FRAME_SIZE, blockSize=64;
+  uint32_t deviceBlockSize=0, latency=0, overhead=0, bandwidth=0, errorBits=0;
+  bool ec=true, nec=true;
+
+  while ((c=getopt(argc, argv, "n:p:f:s:k:d:l:o:b:e:m:"))!=-1)
+  {
+    switch (c)
+    {
+    case 'n':
+      calls = atoi(optarg);
+      break;
+    case 'p':
+      depth = atoi(optarg);
+      break;
+    case 'f':
+      frames = atoi(optarg);
+      break;
+    case 's':
+      frameSize = atoi(optarg);
+      break;
+    case 'k':
+      blockSize = atoi(optarg);
+      break;
+    case 'd':
+      deviceBlockSize = atoi(optarg);
+      break;
+    case 'l':
+      latency = atoi(optarg);
+      break;
+    case 'o':
+      overhead = atoi(optarg);
+      break;
+    case 'b':
+      bandwidth = atoi(optarg);
+      break;
+    case 'e':
+      errorBits = atoi(optarg);
+      break;
+    case 'm':
+      ec = strcmp(optarg, "ec")==0;
+      nec = strcmp(optarg, "nec")==0;
+      if (!ec && !nec)
+        usage();
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind<argc || blockSize==0 || depth==0 || depth>MAX_DEPTH)
+    usage();
+  if (deviceBlockSize==0)
+    deviceBlockSize = blockSize;
+
+  if (ec)
+    runMode(LINK_FLAG_ERROR_CORRECTED, blockSize, deviceBlockSize, latency, overhead, bandwidth, errorBits,
+            calls, depth, frames, frameSize);
+  if (nec)
+  {
+    runMode(0, blockSize, deviceBlockSize, latency, overhead, bandwidth, errorBits, calls, depth, frames, frameSize);
+    runRecovery(blockSize, errorBits ? errorBits : DEFAULT_BURST_BITS, std::min(calls, (uint32_t)RECOVERY_CALLS));
+  }
+
+  return 0;
+}
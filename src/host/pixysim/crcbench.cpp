@@ -0,0 +1,142 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// crcbench -- throughput of the checksums chirp can frame with: the sum
+// (Chirp::calcCrc), and crc16 (Chirp::calcCrc16), which is also what the parameter
+// records use.  A plain byte-at-a-time crc16 is run too, both to check
+// calcCrc16 against and to show what its 8-bytes-per-step tables buy.  Sizes
+// go from a chirp header up to a frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include "chirp.hpp"
+#include "sim.h"
+
+#define DEFAULT_BYTES     (64*1024*1024) // checksummed per size and method
+
+static uint16_t table[256];
+
+static uint16_t crc16Bytewise(const uint8_t *buf, uint32_t len, uint16_t crc=0xffff)
+{
+  for (; len; len--)
+    crc = (crc<<8) ^ table[(crc>>8)^*buf++];
+  return crc;
+}
+
+static uint16_t sum(const uint8_t *buf, uint32_t len)
+{
+  return Chirp::calcCrc((uint8_t *)buf, len);
+}
+
+static uint16_t bytewise(const uint8_t *buf, uint32_t len)
+{
+  return crc16Bytewise(buf, len);
+}
+
+static uint16_t sliced(const uint8_t *buf, uint32_t len)
+{
+  return Chirp::calcCrc16(buf, len);
+}
+
+// MB/s
+static double run(uint16_t (*fn)(const uint8_t *, uint32_t), const uint8_t *buf, uint32_t size, uint32_t bytes)
+{
+  uint32_t i, n = bytes/size;
+  uint64_t begin, t;
+  volatile uint16_t crc = 0;
+
+  if (n==0)
+    n = 1;
+  begin = sim_usecs();
+  for (i=0; i<n; i++)
+    crc ^= (*fn)(buf, size);
+  t = sim_usecs()-begin;
+
+  return t ? (double)n*size/t : 0;
+}
+
+static int check(const uint8_t *buf, uint32_t len)
+{
+  uint32_t i;
+
+  // the standard check value
+  if (Chirp::calcCrc16((const uint8_t *)"123456789", 9)!=0x29b1)
+    return -1;
+  // every length and alignment, and carried across calls the way sendData() does
+  for (i=0; i<len && i<300; i++)
+  {
+    if (Chirp::calcCrc16(buf+i%8, i)!=crc16Bytewise(buf+i%8, i))
+      return -1;
+    if (Chirp::calcCrc16(buf+i, 1, Chirp::calcCrc16(buf, i))!=crc16Bytewise(buf, i+1))
+      return -1;
+  }
+  return 0;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: crcbench [options]\n"
+    "  -b bytes    checksummed per size and method (default %d)\n",
+    DEFAULT_BYTES);
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  int c;
+  uint32_t i, j, bytes=DEFAULT_BYTES;
+  uint16_t crc;
+  static const uint32_t sizes[] = {8, 64, 256, 4096, 320*200};
+  std::vector<uint8_t> buf(320*200);
+
+  while ((c=getopt(argc, argv, "b:"))!=-1)
+  {
+    switch (c)
+    {
+    case 'b':
+      bytes = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind<argc || bytes==0)
+    usage();
+
+  for (i=0; i<256; i++)
+  {
+    for (j=0, crc=i<<8; j<8; j++)
+      crc = crc&0x8000 ? (crc<<1)^0x1021 : crc<<1;
+    table[i] = crc;
+  }
+  for (i=0; i<buf.size(); i++)
+    buf[i] = rand();
+
+  if (check(&buf[0], buf.size())<0)
+  {
+    fprintf(stderr, "calcCrc16 doesn't match the bytewise crc16\n");
+    return 1;
+  }
+
+  printf("%8s %12s %12s %12s   (MB/s)\n", "bytes", "sum", "crc16 x1", "crc16 x8");
+  for (i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+    printf("%8u %12.1f %12.1f %12.1f\n", sizes[i], run(sum, &buf[0], sizes[i], bytes),
+           run(bytewise, &buf[0], sizes[i], bytes), run(sliced, &buf[0], sizes[i], bytes));
+
+  return 0;
+}
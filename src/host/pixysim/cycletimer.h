@@ -0,0 +1,29 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef CYCLETIMER_H
+#define CYCLETIMER_H
+
+// Host stand-in for device/libpixy/cycletimer.h.  Ticks are nanoseconds of host
+// time (steady, not the simulated clock), for the perf probes.
+
+#include "sim.h"
+
+#define CTIMER_TICKS() \
+  sim_nsecs()
+
+#define CTIMER_TICKS_PER_US    1000
+
+#endif
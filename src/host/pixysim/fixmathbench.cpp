@@ -0,0 +1,270 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// fixmathbench -- fixmath.h against libm on this machine.  atan2 and sin/cos are
+// compared over the blob centroid differences and color means they're used on,
+// Blobs::angle()'s degrees have to come out the same, fm_isqrt() has to be exact,
+// and the LUT's line tests (ColorLUT::checkBounds()) are run both ways over every
+// (u, v) for random lines, counting entries that differ.  Each is timed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include "fixmath.h"
+#include "sim.h"
+
+#define DEFAULT_LINES       2000
+#define DEFAULT_SEED        1
+#define ATAN_DX             320 // centroid differences, -ATAN_DX..ATAN_DX
+#define ATAN_DY             200
+#define SINCOS_STEPS        100000
+#define ISQRT_STEP          37 // every 37th number, and the squares around them
+#define LINE_TOLERANCE      (1.0/1024) // how close to a line fm_side() can get the side wrong
+
+static volatile int32_t g_sink; // so the timed loops aren't thrown away
+
+static float randf(float min, float max)
+{
+  return min + (max-min)*rand()/RAND_MAX;
+}
+
+// Blobs::angle() without FIXED_MATH
+static int16_t floatAngle(int dy, int dx)
+{
+  return (int16_t)(atan2((float)dy, (float)dx)*180/3.1415f);
+}
+
+static int checkAtan2()
+{
+  int x, y, mismatches=0;
+  double err, maxErr=0.0;
+  uint64_t begin, tf, tx;
+  int32_t sum;
+
+  for (y=-ATAN_DY; y<=ATAN_DY; y++)
+  {
+    for (x=-ATAN_DX; x<=ATAN_DX; x++)
+    {
+      if (x==0 && y==0)
+        continue;
+      err = fabs(fm_atan2(y, x)/(double)FM_ONE - atan2((double)y, (double)x));
+      if (err>maxErr)
+        maxErr = err;
+      if (fm_atan2Deg(y, x)!=floatAngle(y, x))
+        mismatches++;
+    }
+  }
+
+  begin = sim_usecs();
+  for (y=-ATAN_DY, sum=0; y<=ATAN_DY; y++)
+    for (x=-ATAN_DX; x<=ATAN_DX; x++)
+      sum += floatAngle(y, x);
+  tf = sim_usecs()-begin;
+  g_sink = sum;
+  begin = sim_usecs();
+  for (y=-ATAN_DY, sum=0; y<=ATAN_DY; y++)
+    for (x=-ATAN_DX; x<=ATAN_DX; x++)
+      sum += fm_atan2Deg(y, x);
+  tx = sim_usecs()-begin;
+  g_sink = sum;
+
+  printf("atan2      max error %.2e rad, Blobs::angle() differs %d times in %d   %6.1f ns float %6.1f ns fixed\n",
+       maxErr, mismatches, (2*ATAN_DX+1)*(2*ATAN_DY+1), tf*1000.0/((2*ATAN_DX+1)*(2*ATAN_DY+1)),
+       tx*1000.0/((2*ATAN_DX+1)*(2*ATAN_DY+1)));
+  return mismatches ? -1 : 0;
+}
+
+static int checkSincos()
+{
+  int i;
+  int32_t angle, s, c, sum;
+  double a, err, maxErr=0.0;
+  uint64_t begin, tf, tx;
+
+  for (i=0; i<=SINCOS_STEPS; i++)
+  {
+    angle = -2*FM_PI + (int64_t)4*FM_PI*i/SINCOS_STEPS;
+    a = angle/(double)FM_ONE;
+    fm_sincos(angle, &s, &c);
+    err = fabs(s/(double)FM_ONE - sin(a));
+    if (err>maxErr)
+      maxErr = err;
+    err = fabs(c/(double)FM_ONE - cos(a));
+    if (err>maxErr)
+      maxErr = err;
+  }
+
+  begin = sim_usecs();
+  for (i=0, sum=0; i<=SINCOS_STEPS; i++)
+  {
+    a = (-2*FM_PI + (int64_t)4*FM_PI*i/SINCOS_STEPS)/(float)FM_ONE;
+    sum += (int32_t)(sinf(a)*FM_ONE) + (int32_t)(cosf(a)*FM_ONE);
+  }
+  tf = sim_usecs()-begin;
+  g_sink = sum;
+  begin = sim_usecs();
+  for (i=0, sum=0; i<=SINCOS_STEPS; i++)
+  {
+    fm_sincos(-2*FM_PI + (int64_t)4*FM_PI*i/SINCOS_STEPS, &s, &c);
+    sum += s + c;
+  }
+  tx = sim_usecs()-begin;
+  g_sink = sum;
+
+  printf("sin/cos    max error %.2e                                          %6.1f ns float %6.1f ns fixed\n",
+       maxErr, tf*1000.0/(SINCOS_STEPS+1), tx*1000.0/(SINCOS_STEPS+1));
+  return maxErr>2.0/FM_ONE ? -1 : 0;
+}
+
+static int checkIsqrt()
+{
+  uint32_t i, r, wrong=0, n=0;
+  uint64_t x, begin, tf, tx;
+  int32_t sum;
+
+  for (x=0; x<=0xffffffffull; x+=ISQRT_STEP*(x/ISQRT_STEP/1000+1), n+=3)
+  {
+    r = (uint32_t)sqrt((double)x);
+    if (fm_isqrt(x)!=r)
+      wrong++;
+    // the edges either side of a square
+    if (r<0xffff && (fm_isqrt((r+1)*(r+1))!=r+1 || fm_isqrt((r+1)*(r+1)-1)!=r))
+      wrong++;
+  }
+
+  begin = sim_usecs();
+  for (i=0, sum=0; i<1000000; i++)
+    sum += (int32_t)sqrtf((float)(i*4093));
+  tf = sim_usecs()-begin;
+  g_sink = sum;
+  begin = sim_usecs();
+  for (i=0, sum=0; i<1000000; i++)
+    sum += fm_isqrt(i*4093);
+  tx = sim_usecs()-begin;
+  g_sink = sum;
+
+  printf("isqrt      %u wrong in %u                                               %6.1f ns float %6.1f ns fixed\n",
+       wrong, n, tf/1000.0, tx/1000.0);
+  return wrong ? -1 : 0;
+}
+
+static int sign(double v)
+{
+  return v<0.0 ? -1 : v>0.0 ? 1 : 0;
+}
+
+// ColorLUT::checkBounds() one line at a time, over every LUT entry.  Both are
+// held to the same line in double precision.  Neither counts as wrong for a
+// point that's on it, and fixed point is allowed to be wrong for ones that are
+// within LINE_TOLERANCE of it (in u or v, whichever is less), as float is.
+static int checkLines(uint32_t lines)
+{
+  uint32_t i, j, fwrong=0, xwrong=0;
+  int u, v, side;
+  double d, maxd=0.0;
+  float slope, yi;
+  FmLine line;
+  uint64_t begin, tf=0, tx=0;
+  int32_t sum;
+
+  for (i=0; i<lines; i++)
+  {
+    // hue lines through 0 and sat lines across them, the way generate() makes them
+    slope = tan(randf(-(float)M_PI, (float)M_PI));
+    if (slope==0.0f)
+      continue;
+    yi = i&1 ? randf(-40.0f, 40.0f) : randf(-400.0f, 400.0f);
+    fm_line(&line, slope, yi);
+    for (u=-128; u<128; u++)
+    {
+      for (v=-128; v<128; v++)
+      {
+        d = (double)slope*u + yi - v;
+        if ((side=sign(d))==0)
+          continue;
+        if (sign(slope*u + yi - (float)v)!=side)
+          fwrong++;
+        if (sign(fm_side(&line, u, v))!=side)
+        {
+          xwrong++;
+          d = fabs(d)/(fabs(slope)>1.0f ? fabs(slope) : 1.0);
+          if (d>maxd)
+            maxd = d;
+        }
+      }
+    }
+
+    begin = sim_usecs();
+    for (j=0, sum=0; j<0x10000; j++)
+      sum += slope*(int8_t)(j>>8) + yi<(float)(int8_t)(j&0xff);
+    tf += sim_usecs()-begin;
+    g_sink = sum;
+    begin = sim_usecs();
+    for (j=0, sum=0; j<0x10000; j++)
+      sum += fm_side(&line, (int8_t)(j>>8), (int8_t)(j&0xff))<0;
+    tx += sim_usecs()-begin;
+    g_sink = sum;
+  }
+
+  printf("lines      wrong side: float %u, fixed %u of %u, %.1e off   %6.2f ns float %6.2f ns fixed\n",
+       fwrong, xwrong, lines*0x10000, maxd, tf*1000.0/lines/0x10000, tx*1000.0/lines/0x10000);
+  return maxd>LINE_TOLERANCE ? -1 : 0;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: fixmathbench [options]\n"
+    "  -n lines    random lines to test every LUT entry against (default %d)\n"
+    "  -s seed     (default %d)\n",
+    DEFAULT_LINES, DEFAULT_SEED);
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  int c, res = 0;
+  uint32_t lines=DEFAULT_LINES, seed=DEFAULT_SEED;
+
+  while ((c=getopt(argc, argv, "n:s:"))!=-1)
+  {
+    switch (c)
+    {
+    case 'n':
+      lines = atoi(optarg);
+      break;
+    case 's':
+      seed = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind<argc || lines==0)
+    usage();
+  srand(seed);
+
+  if (checkAtan2()<0)
+    res = 1;
+  if (checkSincos()<0)
+    res = 1;
+  if (checkIsqrt()<0)
+    res = 1;
+  if (checkLines(lines)<0)
+    res = 1;
+
+  return res;
+}
@@ -0,0 +1,120 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "flash.h"
+
+uint32_t g_flashErases = 0;
+uint32_t g_flashPrograms = 0;
+
+static uint8_t *g_flash = NULL;
+static int g_fd = -1;
+
+int flash_open(const char *filename)
+{
+  struct stat st;
+  uint8_t erased[FLASH_SECTOR_SIZE];
+  uint32_t i;
+  void *addr;
+
+  g_fd = open(filename, O_RDWR | O_CREAT, 0644);
+  if (g_fd<0)
+    return -1;
+
+  // new (or short) file, fill it out with erased sectors
+  if (fstat(g_fd, &st)<0)
+    goto error;
+  if (st.st_size<FLASH_SIZE)
+  {
+    memset(erased, 0xff, FLASH_SECTOR_SIZE);
+    for (i=(st.st_size&~(FLASH_SECTOR_SIZE-1)); i<FLASH_SIZE; i+=FLASH_SECTOR_SIZE)
+    {
+      if (pwrite(g_fd, erased, FLASH_SECTOR_SIZE, i)!=FLASH_SECTOR_SIZE)
+        goto error;
+    }
+  }
+
+  // firmware expects flash at FLASH_BEGIN, anywhere else won't do
+  addr = mmap((void *)FLASH_BEGIN, FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, g_fd, 0);
+  if (addr==MAP_FAILED)
+    goto error;
+  if (addr!=(void *)FLASH_BEGIN)
+  {
+    fprintf(stderr, "flash: unable to map flash at 0x%x\n", FLASH_BEGIN);
+    munmap(addr, FLASH_SIZE);
+    goto error;
+  }
+
+  g_flash = (uint8_t *)addr;
+  g_flashErases = 0;
+  g_flashPrograms = 0;
+  return 0;
+
+error:
+  close(g_fd);
+  g_fd = -1;
+  return -1;
+}
+
+void flash_close()
+{
+  if (g_flash)
+  {
+    munmap(g_flash, FLASH_SIZE);
+    g_flash = NULL;
+  }
+  if (g_fd>=0)
+  {
+    close(g_fd);
+    g_fd = -1;
+  }
+}
+
+int32_t flash_erase(uint32_t addr, uint32_t len)
+{
+  uint32_t i;
+
+  if (g_flash==NULL || addr<FLASH_BEGIN || addr+len>FLASH_END)
+    return -1;
+
+  for (i=0; i<len; i+=FLASH_SECTOR_SIZE)
+  {
+    memset(g_flash + FLASH_SECTOR_MASK(addr+i-FLASH_BEGIN), 0xff, FLASH_SECTOR_SIZE);
+    g_flashErases++;
+  }
+  return 0;
+}
+
+int32_t flash_program(uint32_t addr, const uint8_t *data, uint32_t len)
+{
+  uint32_t i;
+  uint8_t *dest;
+
+  if (g_flash==NULL || addr<FLASH_BEGIN || addr+len>FLASH_END)
+    return -1;
+
+  // like NOR flash, programming can only clear bits
+  dest = g_flash + addr - FLASH_BEGIN;
+  for (i=0; i<len; i++)
+    dest[i] &= data[i];
+  g_flashPrograms++;
+
+  return 0;
+}
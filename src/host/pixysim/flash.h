@@ -0,0 +1,42 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef _FLASH_H
+#define _FLASH_H
+
+#include <stdint.h>
+
+// Host stand-in for device/libpixy/flash.h.  Flash is a file mapped at the address
+// it has on Pixy, so firmware code that converts between addresses and uint32_t
+// (e.g. param.cpp) runs unmodified.
+
+#define FLASH_SECTOR_SIZE        0x1000
+#define FLASH_SECTOR_MASK(a)     (a&(~(FLASH_SECTOR_SIZE-1)))
+#define FLASH_SIZE               0x100000
+#define FLASH_BEGIN              0x14000000
+#define FLASH_END                (FLASH_BEGIN+FLASH_SIZE)
+
+int32_t flash_erase(uint32_t addr, uint32_t len);
+int32_t flash_program(uint32_t addr, const uint8_t *data, uint32_t len);
+
+// host only
+int flash_open(const char *filename);
+void flash_close();
+
+// number of sector erases and program operations since flash_open()
+extern uint32_t g_flashErases;
+extern uint32_t g_flashPrograms;
+
+#endif
@@ -0,0 +1,250 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chirp.hpp"
+#include "frames.h"
+
+// same layout as RecordFileHeader, RecordHeader and RecordTrailer in pixymon/recorder.h
+#define REC_MAGIC            FOURCC('P','X','R','1')
+#define REC_INDEX_MAGIC      FOURCC('P','X','I','1')
+#define REC_ALIGN            8
+
+struct RecFileHeader
+{
+  uint32_t m_magic;
+  uint32_t m_version;
+  uint64_t m_reserved;
+};
+
+struct RecHeader
+{
+  uint32_t m_type;
+  uint32_t m_len;
+  uint64_t m_timestamp;
+};
+
+struct RecTrailer
+{
+  uint32_t m_magic;
+  uint32_t m_numFrames;
+  uint64_t m_indexOffset;
+};
+
+// colors of the synthetic rectangles (r, g, b), signature 1 first
+static const uint8_t g_synthColors[][3] =
+{
+  {200, 40, 40},
+  {40, 170, 60},
+  {40, 60, 200}
+};
+
+#define SYNTH_OBJECTS   (sizeof(g_synthColors)/3)
+#define SYNTH_GRAY      100
+
+FrameSource::FrameSource()
+{
+  m_data = NULL;
+  m_size = 0;
+  m_synth = NULL;
+  m_frame = NULL;
+  m_numFrames = 0;
+  m_index = 0;
+  m_width = 0;
+  m_height = 0;
+}
+
+FrameSource::~FrameSource()
+{
+  free(m_data);
+  delete [] m_synth;
+}
+
+int FrameSource::open(const char *filename, uint16_t width, uint16_t height)
+{
+  FILE *file;
+  long len;
+  uint32_t i;
+
+  file = fopen(filename, "rb");
+  if (file==NULL)
+    return -1;
+  fseek(file, 0, SEEK_END);
+  len = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (len<=0 || (m_data=(uint8_t *)malloc(len))==NULL || fread(m_data, 1, len, file)!=(size_t)len)
+  {
+    fclose(file);
+    return -1;
+  }
+  fclose(file);
+  m_size = len;
+
+  if (m_size>=sizeof(RecFileHeader) && ((RecFileHeader *)m_data)->m_magic==REC_MAGIC)
+    return openRecording();
+
+  // raw frames, back to back
+  if (width<2 || height<2 || m_size%(width*height))
+    return -2;
+  m_width = width;
+  m_height = height;
+  for (i=0; i<m_size; i+=width*height)
+    m_frames.push_back(m_data + i);
+  m_numFrames = m_frames.size();
+
+  return m_numFrames;
+}
+
+int FrameSource::openRecording()
+{
+  uint32_t offset, end, size;
+  RecHeader *header;
+  RecTrailer *trailer;
+  void *args[CRP_MAX_ARGS+1];
+
+  // records stop where the index starts, if there is one
+  end = m_size;
+  trailer = (RecTrailer *)(m_data + m_size - sizeof(RecTrailer));
+  if (m_size>=sizeof(RecFileHeader)+sizeof(RecTrailer) && trailer->m_magic==REC_INDEX_MAGIC &&
+      trailer->m_indexOffset<m_size)
+    end = trailer->m_indexOffset;
+
+  for (offset=sizeof(RecFileHeader); offset+sizeof(RecHeader)<=end; offset+=size)
+  {
+    header = (RecHeader *)(m_data + offset);
+    size = sizeof(RecHeader) + header->m_len;
+    ALIGN(size, REC_ALIGN);
+    if (header->m_len==0 || offset+sizeof(RecHeader)+header->m_len>end)
+      break;
+    if (header->m_type!=FOURCC('B','A','8','1'))
+      continue;
+
+    // BA81: HTYPE, HINT8 renderFlags, UINT16 width, UINT16 height, UINTS8 pixels
+    if (Chirp::deserializeParse((uint8_t *)header+sizeof(RecHeader), header->m_len, args)<0 ||
+        args[1]==NULL || args[2]==NULL || args[3]==NULL || args[4]==NULL || args[5]==NULL)
+      continue;
+    if (m_frames.size()==0)
+    {
+      m_width = *(uint16_t *)args[2];
+      m_height = *(uint16_t *)args[3];
+    }
+    // we only deal with one resolution per recording
+    if (*(uint16_t *)args[2]!=m_width || *(uint16_t *)args[3]!=m_height ||
+        *(uint32_t *)args[4]<(uint32_t)m_width*m_height)
+      continue;
+    m_frames.push_back((uint8_t *)args[5]);
+  }
+  m_numFrames = m_frames.size();
+
+  return m_numFrames ? (int)m_numFrames : -3;
+}
+
+int FrameSource::synthetic(uint32_t frames, uint16_t width, uint16_t height)
+{
+  if (width<16 || height<16)
+    return -1;
+
+  m_width = width;
+  m_height = height;
+  m_numFrames = frames;
+  m_synth = new uint8_t[width*height];
+
+  return m_numFrames;
+}
+
+const uint8_t *FrameSource::next()
+{
+  if (m_index>=m_numFrames)
+    return NULL;
+
+  if (m_synth)
+  {
+    generate(m_index);
+    m_frame = m_synth;
+  }
+  else
+    m_frame = m_frames[m_index];
+  m_index++;
+
+  return m_frame;
+}
+
+// Rectangles bounce around the frame, each with its own speed, so blobs
+// cross and occlude each other now and then.
+void FrameSource::position(uint8_t sig, uint32_t n, int32_t *x, int32_t *y)
+{
+  int32_t w = m_width/8, h = m_height/6;
+  int32_t rangex = m_width-w, rangey = m_height-h;
+
+  *x = (rangex/4 + (int32_t)(n*(3+2*sig)))%(2*rangex);
+  *y = (rangey/3*sig + (int32_t)(n*(2+sig)))%(2*rangey);
+  if (*x>=rangex)
+    *x = 2*rangex - *x - 1;
+  if (*y>=rangey)
+    *y = 2*rangey - *y - 1;
+}
+
+int FrameSource::region(uint8_t sig, uint16_t *x, uint16_t *y, uint16_t *w, uint16_t *h)
+{
+  int32_t x0, y0;
+
+  if (m_synth==NULL || m_index==0 || sig<1 || sig>SYNTH_OBJECTS)
+    return -1;
+
+  position(sig-1, m_index-1, &x0, &y0);
+  *x = x0;
+  *y = y0;
+  *w = m_width/8;
+  *h = m_height/6;
+
+  return 0;
+}
+
+void FrameSource::generate(uint32_t n)
+{
+  uint32_t i, x, y, noise = n*2654435761u;
+  int32_t x0[SYNTH_OBJECTS], y0[SYNTH_OBJECTS];
+  int32_t w = m_width/8, h = m_height/6;
+  uint8_t *p = m_synth;
+  int val;
+
+  for (i=0; i<SYNTH_OBJECTS; i++)
+    position(i, n, &x0[i], &y0[i]);
+
+  for (y=0; y<m_height; y++)
+  {
+    for (x=0; x<m_width; x++, p++)
+    {
+      // Bayer layout matches the camera: B G on even lines, G R on odd lines
+      val = SYNTH_GRAY;
+      for (i=0; i<SYNTH_OBJECTS; i++)
+      {
+        if ((int32_t)x>=x0[i] && (int32_t)x<x0[i]+w && (int32_t)y>=y0[i] && (int32_t)y<y0[i]+h)
+        {
+          if (y&1)
+            val = g_synthColors[i][x&1 ? 0 : 1];
+          else
+            val = g_synthColors[i][x&1 ? 1 : 2];
+        }
+      }
+      // a little sensor noise, so segments aren't perfectly regular
+      noise = noise*1664525 + 1013904223;
+      val += (int)(noise>>28) - 8;
+      *p = val<0 ? 0 : (val>255 ? 255 : val);
+    }
+  }
+}
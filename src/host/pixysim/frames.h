@@ -0,0 +1,78 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include <stdint.h>
+#include <vector>
+
+// Raw (Bayer, BA81) frames for the camera stand-in.  Frames come from
+// a PixyMon recording (BA81 records only, see pixymon/recorder.h),
+// a file of raw frames back to back, or are generated: colored
+// rectangles moving over a gray background, one per signature.
+class FrameSource
+{
+public:
+  FrameSource();
+  ~FrameSource();
+
+  int open(const char *filename, uint16_t width, uint16_t height);
+  int synthetic(uint32_t frames, uint16_t width, uint16_t height);
+
+  // advances to the next frame, returns NULL when there are no more
+  const uint8_t *next();
+  const uint8_t *frame()
+  {
+    return m_frame;
+  }
+
+  uint16_t width()
+  {
+    return m_width;
+  }
+  uint16_t height()
+  {
+    return m_height;
+  }
+  uint32_t frames()
+  {
+    return m_numFrames;
+  }
+  uint32_t index()
+  {
+    return m_index;
+  }
+
+  // region covered by signature sig's rectangle in the current synthetic frame
+  int region(uint8_t sig, uint16_t *x, uint16_t *y, uint16_t *w, uint16_t *h);
+
+private:
+  int openRecording();
+  void generate(uint32_t n);
+  void position(uint8_t sig, uint32_t n, int32_t *x, int32_t *y);
+
+  uint8_t *m_data;
+  uint32_t m_size;
+  std::vector<uint8_t *> m_frames; // into m_data, recordings and raw files
+  uint8_t *m_synth; // synthetic frame buffer
+  const uint8_t *m_frame;
+  uint32_t m_numFrames;
+  uint32_t m_index; // number of frames returned so far
+  uint16_t m_width;
+  uint16_t m_height;
+};
+
+#endif
@@ -0,0 +1,66 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// Host stand-in for device/libpixy/led.cpp, remembers what it's told.
+
+#include "pixy_init.h"
+#include "led.h"
+
+static uint8_t g_ledVal[3];
+static uint32_t g_ledMaxCurrent = LED_DEFAULT_MAX_CURRENT;
+
+void led_init()
+{
+}
+
+void led_setPWM(uint8_t led, uint16_t pwm)
+{
+}
+
+void led_set(uint8_t led, uint8_t val, bool override)
+{
+  if (led>2)
+    return;
+  g_ledVal[led] = val;
+}
+
+int32_t led_setRGB(const uint8_t &r, const uint8_t &g, const uint8_t &b)
+{
+  led_set(LED_RED, r);
+  led_set(LED_GREEN, g);
+  led_set(LED_BLUE, b);
+
+  return 0;
+}
+
+int32_t led_set(const uint32_t &color)
+{
+  led_set(LED_RED, (color>>16)&0xff);
+  led_set(LED_GREEN, (color>>8)&0xff);
+  led_set(LED_BLUE, color&0xff);
+
+  return 0;
+}
+
+int32_t led_setMaxCurrent(const uint32_t &uamps)
+{
+  g_ledMaxCurrent = uamps;
+  return 0;
+}
+
+uint32_t led_getMaxCurrent()
+{
+  return g_ledMaxCurrent;
+}
@@ -0,0 +1,286 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include "chirp.hpp"
+#include "loopback.h"
+#include "sim.h"
+
+LoopbackLink::LoopbackLink(uint32_t flags, uint32_t blockSize, uint8_t *sharedMem, uint32_t sharedMemSize)
+{
+  m_flags = flags;
+  m_blockSize = blockSize;
+  m_sharedMem = sharedMem;
+  m_sharedMemSize = sharedMemSize;
+  m_peer = NULL;
+  m_server = NULL;
+  m_avail = 0;
+  m_timer = 0;
+  m_discard = false;
+  m_blocking = false;
+  m_sentBytes = 0;
+  m_recvBytes = 0;
+  m_sends = 0;
+  m_bitErrors = 0;
+  m_latency = 0;
+  m_overhead = 0;
+  m_bandwidth = 0;
+  m_errorBits = 0;
+  m_errorCountdown = 0;
+  m_seed = 1;
+  m_wireFree = 0;
+}
+
+LoopbackLink::~LoopbackLink()
+{
+}
+
+void LoopbackLink::connect(LoopbackLink *peer)
+{
+  m_peer = peer;
+  peer->m_peer = this;
+}
+
+void LoopbackLink::setDiscard(bool discard)
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+
+  m_discard = discard;
+  m_rq.clear();
+  m_segments.clear();
+}
+
+void LoopbackLink::setBitErrors(uint32_t errorBits, uint64_t seed)
+{
+  m_errorBits = errorBits;
+  m_seed = seed;
+  if (m_errorBits)
+    m_errorCountdown = nextError();
+}
+
+// bits until the next error, uniform on 1..2*errorBits-1 so the mean is errorBits
+uint32_t LoopbackLink::nextError()
+{
+  m_seed = m_seed*6364136223846793005ULL + 1442695040888963407ULL;
+  return 1 + (m_seed>>33)%(2*(uint64_t)m_errorBits-1);
+}
+
+void LoopbackLink::corrupt(uint8_t *data, uint32_t len)
+{
+  uint64_t bits = (uint64_t)len*8, pos = 0;
+
+  while (pos+m_errorCountdown<=bits)
+  {
+    pos += m_errorCountdown;
+    data[(pos-1)>>3] ^= 1<<((pos-1)&7);
+    m_bitErrors++;
+    m_errorCountdown = nextError();
+  }
+  m_errorCountdown -= bits-pos;
+}
+
+uint64_t LoopbackLink::now()
+{
+  return m_blocking ? sim_usecs() : g_simClock;
+}
+
+void LoopbackLink::waitUntil(uint64_t us)
+{
+  uint64_t t = now();
+
+  if (us<=t)
+    return;
+  if (m_blocking)
+    boost::this_thread::sleep_for(boost::chrono::microseconds(us-t));
+  else
+    g_simClock = us;
+}
+
+void LoopbackLink::push(const uint8_t *data, uint32_t len, uint64_t arrival, bool end)
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+
+  m_recvBytes += len;
+  if (m_discard)
+    return;
+  if (m_flags&LINK_FLAG_SHARED_MEM)
+    m_avail = len; // data is already in shared memory
+  else
+  {
+    Segment segment = {len, arrival, end};
+    m_rq.insert(m_rq.end(), data, data+len);
+    m_segments.push_back(segment);
+  }
+  m_cond.notify_one();
+}
+
+int LoopbackLink::send(const uint8_t *data, uint32_t len, uint16_t timeoutMs)
+{
+  uint64_t start;
+
+  if (m_peer==NULL)
+    return LINK_RESULT_ERROR;
+
+  if (m_flags&LINK_FLAG_SHARED_MEM)
+    m_peer->push(data, len, now(), false);
+  else
+  {
+    start = std::max(now(), m_wireFree);
+    m_wireFree = start + m_overhead + (m_bandwidth ? (uint64_t)len*1000000/m_bandwidth : 0);
+    if (m_errorBits)
+    {
+      m_corrupted.assign(data, data+len);
+      corrupt(&m_corrupted[0], len);
+      data = &m_corrupted[0];
+    }
+    m_peer->push(data, len, m_wireFree+m_latency,
+                 (m_flags&LINK_FLAG_ERROR_CORRECTED) && m_blockSize && len%m_blockSize);
+    // like a bulk transfer, we return once the data is out
+    waitUntil(m_wireFree);
+  }
+  m_sentBytes += len;
+  m_sends++;
+
+  return len;
+}
+
+// when the first len bytes in the queue will all have arrived
+uint64_t LoopbackLink::arrival(uint32_t len)
+{
+  std::deque<Segment>::iterator i;
+  uint32_t n;
+
+  for (i=m_segments.begin(), n=0; i!=m_segments.end(); i++)
+  {
+    n += i->len;
+    if (n>=len)
+      return i->arrival;
+  }
+  return 0;
+}
+
+// how much a receive of len takes: len, or less if a short packet comes first, or 0
+// if neither is here yet
+uint32_t LoopbackLink::transfer(uint32_t len)
+{
+  std::deque<Segment>::iterator i;
+  uint32_t n;
+
+  for (i=m_segments.begin(), n=0; i!=m_segments.end(); i++)
+  {
+    n += i->len;
+    if (n>=len)
+      return len;
+    if (i->end)
+      return n;
+  }
+  return 0;
+}
+
+void LoopbackLink::consume(uint8_t *data, uint32_t len)
+{
+  std::copy(m_rq.begin(), m_rq.begin()+len, data);
+  m_rq.erase(m_rq.begin(), m_rq.begin()+len);
+
+  while (len)
+  {
+    if (m_segments.front().len<=len)
+    {
+      len -= m_segments.front().len;
+      m_segments.pop_front();
+    }
+    else
+    {
+      m_segments.front().len -= len;
+      len = 0;
+    }
+  }
+}
+
+int LoopbackLink::receiveBlocking(uint8_t *data, uint32_t len, uint16_t timeoutMs)
+{
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  uint64_t t, n, deadline = now() + timeoutMs*1000;
+  uint32_t got;
+
+  while ((got=transfer(len))==0 || (t=arrival(got))>now())
+  {
+    n = now();
+    if (n>=deadline)
+      return timeoutMs ? LINK_RESULT_ERROR_RECV_TIMEOUT : 0;
+    // wait for more data, or for what's here to finish arriving
+    t = got==0 ? deadline : std::min(t, deadline);
+    if (t>n)
+      m_cond.wait_for(lock, boost::chrono::microseconds(t-n));
+  }
+  consume(data, got);
+
+  return got;
+}
+
+int LoopbackLink::receive(uint8_t *data, uint32_t len, uint16_t timeoutMs)
+{
+  uint32_t avail;
+  bool shared = m_flags&LINK_FLAG_SHARED_MEM;
+
+  if (m_blocking && !shared)
+    return receiveBlocking(data, len, timeoutMs);
+
+  avail = shared ? m_avail : transfer(len);
+  if ((shared ? avail<len : avail==0) && m_server)
+  {
+    // give the other side a chance to run
+    uint64_t start = sim_usecs();
+    m_server->service(false);
+    g_simUsecs += sim_usecs() - start;
+    avail = shared ? m_avail : transfer(len);
+  }
+
+  // same as USBLink-- all (or up to a short packet) or nothing, 0 if we're polling
+  if (avail==0)
+    return timeoutMs ? LINK_RESULT_ERROR_RECV_TIMEOUT : 0;
+
+  if (shared)
+  {
+    m_avail = 0;
+    return len;
+  }
+  // we're the only thread, so we wait for it by moving the clock
+  waitUntil(arrival(avail));
+  consume(data, avail);
+
+  return avail;
+}
+
+void LoopbackLink::setTimer()
+{
+  m_timer = now();
+}
+
+uint32_t LoopbackLink::getTimer()
+{
+  return (now() - m_timer)/1000;
+}
+
+uint32_t LoopbackLink::getFlags(uint8_t index)
+{
+  if (index==LINK_FLAG_INDEX_SHARED_MEMORY_LOCATION)
+    return (uint32_t)(uintptr_t)m_sharedMem;
+  else if (index==LINK_FLAG_INDEX_SHARED_MEMORY_SIZE)
+    return m_sharedMemSize;
+  else
+    return Link::getFlags(index);
+}
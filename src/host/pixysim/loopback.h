@@ -0,0 +1,134 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef LOOPBACK_H
+#define LOOPBACK_H
+
+#include <deque>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "link.h"
+
+class Chirp;
+
+// One end of an in-process link.  Two ends are connected back to back and
+// everything runs in a single thread: when an end comes up empty in receive()
+// it runs its server's Chirp::service() once, which is what the other side
+// would have been doing on its own processor.  This keeps the simulation
+// deterministic.
+//
+// Without LINK_FLAG_SHARED_MEM data is a byte stream, like USBLink.  When it's
+// error corrected, a send that isn't a whole number of blocks ends in a short
+// packet, as a USB bulk transfer does, and a receive stops there even if it asked
+// for more.  With LINK_FLAG_SHARED_MEM only the "data available" flag crosses over
+// and both Chirps use the same buffer, like SMLink.
+//
+// With setBlocking() the two ends are meant for two threads instead: receive()
+// waits for the peer like USBLink does, and time is real time rather than the
+// simulation clock.  This is what the non error-corrected protocol needs, since
+// the sender waits for an ack in the middle of a transfer.
+class LoopbackLink : public Link
+{
+public:
+  LoopbackLink(uint32_t flags=LINK_FLAG_ERROR_CORRECTED, uint32_t blockSize=64,
+               uint8_t *sharedMem=NULL, uint32_t sharedMemSize=0);
+  ~LoopbackLink();
+
+  void connect(LoopbackLink *peer);
+  void setServer(Chirp *server)
+  {
+    m_server = server;
+  }
+  // throw away whatever comes in, but keep counting it
+  void setDiscard(bool discard);
+  void setBlocking(bool blocking)
+  {
+    m_blocking = blocking;
+  }
+
+  // Impairments of the data this end sends, byte stream only.  Each send waits
+  // its turn on the wire, takes len/bytesPerSec to go out (0 is unlimited) and
+  // arrives latencyUs after that.  On average one bit in errorBits is flipped
+  // (0 is none), from a fixed seed so runs can be repeated.  Each send also holds
+  // the wire for overheadUs, the per-transfer cost (USB scheduling, turnaround).
+  void setLatency(uint32_t latencyUs)
+  {
+    m_latency = latencyUs;
+  }
+  void setOverhead(uint32_t overheadUs)
+  {
+    m_overhead = overheadUs;
+  }
+  void setBandwidth(uint32_t bytesPerSec)
+  {
+    m_bandwidth = bytesPerSec;
+  }
+  void setBitErrors(uint32_t errorBits, uint64_t seed=1);
+
+  virtual int send(const uint8_t *data, uint32_t len, uint16_t timeoutMs);
+  virtual int receive(uint8_t *data, uint32_t len, uint16_t timeoutMs);
+  virtual void setTimer();
+  virtual uint32_t getTimer();
+  virtual uint32_t getFlags(uint8_t index=LINK_FLAG_INDEX_FLAGS);
+
+  uint64_t m_sentBytes;
+  uint64_t m_recvBytes;
+  uint32_t m_sends;
+  uint32_t m_bitErrors;
+
+private:
+  struct Segment
+  {
+    uint32_t len;
+    uint64_t arrival; // us
+    bool end; // short packet, a receive stops after it
+  };
+
+  void push(const uint8_t *data, uint32_t len, uint64_t arrival, bool end);
+  uint32_t transfer(uint32_t len);
+  int receiveBlocking(uint8_t *data, uint32_t len, uint16_t timeoutMs);
+  uint64_t arrival(uint32_t len);
+  void consume(uint8_t *data, uint32_t len);
+  void corrupt(uint8_t *data, uint32_t len);
+  uint32_t nextError();
+  uint64_t now();
+  void waitUntil(uint64_t us);
+
+  LoopbackLink *m_peer;
+  Chirp *m_server;
+  std::deque<uint8_t> m_rq;
+  std::deque<Segment> m_segments;
+  uint32_t m_avail; // shared memory, length of waiting message
+  uint8_t *m_sharedMem;
+  uint32_t m_sharedMemSize;
+  uint64_t m_timer;
+  bool m_discard;
+  bool m_blocking;
+
+  uint32_t m_latency;
+  uint32_t m_overhead;
+  uint32_t m_bandwidth;
+  uint32_t m_errorBits;
+  uint32_t m_errorCountdown;
+  uint64_t m_seed;
+  uint64_t m_wireFree; // when what we've sent so far is out on the wire
+  std::vector<uint8_t> m_corrupted;
+
+  boost::mutex m_mutex;
+  boost::condition_variable m_cond;
+};
+
+#endif
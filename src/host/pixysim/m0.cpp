@@ -0,0 +1,483 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <string.h>
+#include "pixyvals.h"
+#include "cameravals.h"
+#include "colorlut.h"
+#include "qqueue.h"
+#include "chirp.hpp"
+#include "loopback.h"
+#include "frames.h"
+#include "sim.h"
+#include "m0.h"
+
+// same shared memory as smlink.h
+#define SM_LOC               (SRAM4_LOC+0x3000)
+#define SM_SIZE              (SRAM4_SIZE-0x3000)
+
+// where exec_m0.c puts the lut
+#define M0_LUT               (SRAM1_LOC + SRAM1_SIZE - CL_LUT_SIZE)
+
+// We don't filter noise like rls_m0.c, so a line can have a segment every other column.
+#define M0_MAX_QVALS_PER_LINE  (CAM_RES1_WIDTH/4+1)
+// a line's segments, its beginning and the end of frame
+#define M0_LINE_ROOM           (M0_MAX_QVALS_PER_LINE+2)
+#define M0_LINE_PERIOD         (M0_FRAME_PERIOD/CAM_RES2_HEIGHT) // us
+
+static int32_t m0_run(const uint8_t &prog);
+static int32_t m0_stop();
+static uint32_t m0_running();
+static int32_t m0_getRLSFrame(const uint32_t &m0Mem, const uint32_t &lut);
+static int32_t m0_getFrame(const uint8_t &type, const uint32_t &memory, const uint16_t &xOffset, const uint16_t &yOffset,
+                           const uint16_t &xWidth, const uint16_t &yWidth);
+static int32_t m0_getFrameRows(const uint8_t &type, const uint32_t &memory, const uint16_t &xOffset, const uint16_t &yOffset,
+                               const uint16_t &xWidth, const uint16_t &yWidth, const uint32_t &rows);
+
+static const ProcModule g_module[] =
+{
+  {
+  "run",
+  (ProcPtr)m0_run,
+  {CRP_UINT8, END},
+  "Run M0 program"
+  "@p program number"
+  "@r always returns 0"
+  },
+  {
+  "stop",
+  (ProcPtr)m0_stop,
+  {END},
+  "Stop M0 program"
+  "@r always returns 0"
+  },
+  {
+  "running",
+  (ProcPtr)m0_running,
+  {END},
+  "Is the M0 program running?"
+  "@r 1 if running, 0 otherwise"
+  },
+  {
+  "getRLSFrame",
+  (ProcPtr)m0_getRLSFrame,
+  {CRP_UINT32, CRP_UINT32, END},
+  "Segment one frame into the Qqueue"
+  "@p scratch memory (unused)"
+  "@p lut location"
+  "@r 0 if success, -1 if the queue is full"
+  },
+  {
+  "getFrame",
+  (ProcPtr)m0_getFrame,
+  {CRP_UINT8, CRP_UINT32, CRP_UINT16, CRP_UINT16, CRP_UINT16, CRP_UINT16, END},
+  "Grab raw frame"
+  "@p type, resolution in upper nibble"
+  "@p memory location"
+  "@p x offset"
+  "@p y offset"
+  "@p width"
+  "@p height"
+  "@r 0 if success, negative if error"
+  },
+  {
+  "getFrameRows",
+  (ProcPtr)m0_getFrameRows,
+  {CRP_UINT8, CRP_UINT32, CRP_UINT16, CRP_UINT16, CRP_UINT16, CRP_UINT16, CRP_UINT32, END},
+  "Grab raw frame, counting rows as they're grabbed"
+  "@p type, resolution in upper nibble"
+  "@p memory location"
+  "@p x offset"
+  "@p y offset"
+  "@p width"
+  "@p height"
+  "@p location of the row count"
+  "@r 0 if success, negative if error"
+  },
+  END
+};
+
+// a raw frame grab, a row at a time
+struct Grab
+{
+  uint8_t *dest;
+  uint32_t x, y, width, height; // window
+  uint32_t resWidth, resHeight; // resolution it's in
+  uint32_t row; // rows grabbed so far
+  volatile uint32_t *rows; // getFrameRows() count, NULL if no grab is in progress
+};
+
+uint32_t g_m0Frames = 0;
+
+static FrameSource *g_source = NULL;
+static uint8_t *g_sensor = NULL; // current frame, CAM_RES1
+static uint8_t *g_resampled = NULL;
+static uint32_t g_line = 0;
+static bool g_capture = false; // the current frame is going into the Qqueue
+static uint32_t g_top = 0, g_bottom = CAM_RES2_HEIGHT; // and these lines of it
+static bool g_outOfFrames = false;
+static uint32_t g_lag = 0; // us of capture m0_advance() hasn't caught up on
+static bool g_run = false;
+static QqueueFields *g_qq = (QqueueFields *)QQ_LOC;
+static LoopbackLink *g_m4Link = NULL;
+static LoopbackLink *g_m0Link = NULL;
+static Chirp *g_chirp = NULL;
+static Grab g_grab;
+
+// Nearest neighbor, but keeps the Bayer pattern by picking whole 2x2 cells.
+static inline uint8_t bayerSample(const uint8_t *src, uint32_t sw, uint32_t sh, uint32_t x, uint32_t y,
+                                  uint32_t dw, uint32_t dh)
+{
+  uint32_t sx = (x>>1)*sw/dw*2 + (x&1);
+  uint32_t sy = (y>>1)*sh/dh*2 + (y&1);
+
+  return src[sy*sw + sx];
+}
+
+static int nextFrame()
+{
+  const uint8_t *frame;
+  uint32_t x, y;
+
+  if ((frame=g_source->next())==NULL)
+    return -1;
+
+  if (g_source->width()==CAM_RES1_WIDTH && g_source->height()==CAM_RES1_HEIGHT)
+    g_sensor = (uint8_t *)frame;
+  else
+  {
+    for (y=0; y<CAM_RES1_HEIGHT; y++)
+    {
+      for (x=0; x<CAM_RES1_WIDTH; x++)
+        g_resampled[y*CAM_RES1_WIDTH + x] = bayerSample(frame, g_source->width(), g_source->height(),
+                                                        x, y, CAM_RES1_WIDTH, CAM_RES1_HEIGHT);
+    }
+    g_sensor = g_resampled;
+  }
+  g_simClock += M0_FRAME_PERIOD;
+  g_m0Frames++;
+
+  return 0;
+}
+
+static inline uint16_t qqFree()
+{
+  return QQ_MEM_SIZE - (uint16_t)(g_qq->produced - g_qq->consumed);
+}
+
+static inline void qqEnqueue(Qval val)
+{
+  g_qq->data[g_qq->writeIndex++] = val;
+  g_qq->produced++;
+  if (g_qq->writeIndex==QQ_MEM_SIZE)
+    g_qq->writeIndex = 0;
+}
+
+// qqueue.c's frame handoff
+static bool qqBeginFrame(uint16_t room)
+{
+  if ((uint16_t)(g_qq->frames - g_qq->released)>=QQ_SLOTS || qqFree()<room)
+  {
+    g_qq->skipped++;
+    return false;
+  }
+  return true;
+}
+
+// the window the M4 wants (see qqueue.h), into the frame that's beginning
+static void qqWindow()
+{
+  if (g_qq->windowCols)
+    qqEnqueue(g_qq->windowCols);
+  if (g_qq->windowRows)
+  {
+    qqEnqueue(g_qq->windowRows);
+    g_top = QQ_WINDOW_START(g_qq->windowRows);
+    g_bottom = g_top + QQ_WINDOW_LEN(g_qq->windowRows);
+    if (g_bottom>CAM_RES2_HEIGHT)
+      g_bottom = CAM_RES2_HEIGHT;
+    if (g_top>g_bottom)
+      g_top = g_bottom;
+  }
+  else
+  {
+    g_top = 0;
+    g_bottom = CAM_RES2_HEIGHT;
+  }
+}
+
+static void qqEndFrame(bool complete)
+{
+  qqEnqueue(0xffffffff);
+  g_qq->frames++;
+  if (!complete)
+    g_qq->truncated++;
+}
+
+// One line of run-length segments, same as pixyproc's rls(), which is the
+// host version of lineProcessedRL0A/lineProcessedRL1A.
+static void rlsLine(uint32_t line, const uint8_t *lut)
+{
+  uint32_t index, startCol, model, prevModel, r, g1, g2, b;
+  int32_t x, c1, c2;
+  const uint8_t *pixels = g_sensor + (line*2+1)*CAM_RES1_WIDTH;
+
+  // beginning of line
+  qqEnqueue(0);
+
+  prevModel = 0;
+  startCol = 0;
+  for (x=1; x<CAM_RES1_WIDTH; x+=2)
+  {
+    r = pixels[x];
+    g1 = pixels[x - 1];
+    g2 = pixels[x - CAM_RES1_WIDTH];
+    b = pixels[x - CAM_RES1_WIDTH - 1];
+    c2 = r-g1;
+    c1 = b-g2;
+    c1 >>= 1;
+    c2 >>= 1;
+    index = ((uint8_t)c2<<8) | (uint8_t)c1;
+    model = lut[index]&0x07;
+
+    if (model && prevModel==0)
+      startCol = x/2;
+    if ((model && prevModel && model!=prevModel) ||
+        (model==0 && prevModel))
+    {
+      qqEnqueue(prevModel | startCol<<3 | (x/2-startCol)<<12);
+      model = 0;
+      startCol = 0;
+    }
+    prevModel = model;
+  }
+  if (startCol)
+    qqEnqueue(prevModel | startCol<<3 | (x/2-startCol)<<12);
+}
+
+static int setGrab(uint8_t type, uint32_t memory, uint32_t xOffset, uint32_t yOffset, uint32_t xWidth, uint32_t yWidth)
+{
+  switch (type>>4)
+  {
+  case CAM_RES0:
+    g_grab.resWidth = CAM_RES0_WIDTH;
+    g_grab.resHeight = CAM_RES0_HEIGHT;
+    break;
+  case CAM_RES1:
+    g_grab.resWidth = CAM_RES1_WIDTH;
+    g_grab.resHeight = CAM_RES1_HEIGHT;
+    break;
+  case CAM_RES2:
+    g_grab.resWidth = CAM_RES2_WIDTH;
+    g_grab.resHeight = CAM_RES2_HEIGHT;
+    break;
+  default:
+    return -1;
+  }
+  if (xOffset+xWidth>g_grab.resWidth || yOffset+yWidth>g_grab.resHeight)
+    return -1;
+
+  g_grab.dest = (uint8_t *)(uintptr_t)memory;
+  g_grab.x = xOffset;
+  g_grab.y = yOffset;
+  g_grab.width = xWidth;
+  g_grab.height = yWidth;
+  g_grab.row = 0;
+  g_grab.rows = NULL;
+
+  // every grab is a new frame, so the video program runs through the frames too
+  if (nextFrame()<0)
+    sim_exit();
+
+  return 0;
+}
+
+static void grabRow()
+{
+  uint32_t x, y = g_grab.y + g_grab.row;
+
+  for (x=g_grab.x; x<g_grab.x+g_grab.width; x++)
+    *g_grab.dest++ = bayerSample(g_sensor, CAM_RES1_WIDTH, CAM_RES1_HEIGHT, x, y, g_grab.resWidth, g_grab.resHeight);
+  g_grab.row++;
+}
+
+// One line of the M0 program (exec_m0.c's getRLSFrame() loop).  With wait, the sensor
+// waits for the M4 to make room, as if no time passed while it did.  Otherwise the
+// frame is skipped or cut short the way rls_m0.c does it, since the sensor doesn't wait.
+// A frame in a window ends with the window's last line, the sensor's lines go by
+// either way.
+static int runLine(bool wait)
+{
+  if (wait && g_capture && qqFree()<M0_LINE_ROOM)
+    return 0;
+
+  if (g_line==0)
+  {
+    if (wait && qqFree()<M0_LINE_ROOM+QQ_WINDOW_QVALS)
+      return 0;
+    if (g_outOfFrames || nextFrame()<0)
+    {
+      g_outOfFrames = true;
+      return M0_OUT_OF_FRAMES;
+    }
+    if ((g_capture=qqBeginFrame(M0_LINE_ROOM+QQ_WINDOW_QVALS)))
+      qqWindow();
+  }
+  if (g_capture && g_line>=g_top)
+  {
+    if (qqFree()<M0_LINE_ROOM)
+    {
+      qqEndFrame(false);
+      g_capture = false;
+    }
+    else
+      rlsLine(g_line, (uint8_t *)M0_LUT);
+  }
+  if (g_capture && g_line+1>=g_bottom)
+  {
+    qqEndFrame(true);
+    g_capture = false;
+  }
+  if (++g_line==CAM_RES2_HEIGHT)
+    g_line = 0;
+
+  return 1;
+}
+
+int m0_produce()
+{
+  // the M4 doesn't wait around for ASYNC calls, so pick them up here
+  g_chirp->service(false);
+
+  if (g_grab.rows)
+  {
+    grabRow();
+    *g_grab.rows = g_grab.row;
+    if (g_grab.row==g_grab.height)
+      g_grab.rows = NULL;
+    return 1;
+  }
+
+  if (!g_run)
+    return -1;
+
+  return runLine(true);
+}
+
+void m0_advance(uint32_t usecs)
+{
+  if (!g_run || g_grab.rows)
+    return;
+
+  for (g_lag+=usecs; g_lag>=M0_LINE_PERIOD; g_lag-=M0_LINE_PERIOD)
+    runLine(false);
+}
+
+static int32_t m0_run(const uint8_t &prog)
+{
+  g_line = 0;
+  g_lag = 0;
+  g_run = true;
+  return 0;
+}
+
+static int32_t m0_stop()
+{
+  g_run = false;
+  return 0;
+}
+
+static uint32_t m0_running()
+{
+  return g_run;
+}
+
+static int32_t m0_getRLSFrame(const uint32_t &m0Mem, const uint32_t &lut)
+{
+  uint32_t line;
+
+  if (nextFrame()<0)
+    sim_exit();
+  if (!qqBeginFrame(M0_LINE_ROOM+QQ_WINDOW_QVALS))
+    return -1;
+  qqWindow();
+
+  for (line=g_top; line<g_bottom; line++)
+  {
+    if (qqFree()<M0_LINE_ROOM)
+    {
+      qqEndFrame(false);
+      return -1;
+    }
+    rlsLine(line, (uint8_t *)(uintptr_t)lut);
+  }
+  qqEndFrame(true);
+  return 0;
+}
+
+static int32_t m0_getFrame(const uint8_t &type, const uint32_t &memory, const uint16_t &xOffset, const uint16_t &yOffset,
+                           const uint16_t &xWidth, const uint16_t &yWidth)
+{
+  if (setGrab(type, memory, xOffset, yOffset, xWidth, yWidth)<0)
+    return -1;
+
+  while (g_grab.row<g_grab.height)
+    grabRow();
+  return 0;
+}
+
+// Returns right away.  The rows come in as m0_produce() is called, one per call, and the M4
+// watches the count.
+static int32_t m0_getFrameRows(const uint8_t &type, const uint32_t &memory, const uint16_t &xOffset, const uint16_t &yOffset,
+                               const uint16_t &xWidth, const uint16_t &yWidth, const uint32_t &rows)
+{
+  volatile uint32_t *count = (volatile uint32_t *)(uintptr_t)rows;
+
+  if (setGrab(type, memory, xOffset, yOffset, xWidth, yWidth)<0)
+  {
+    *count = CAM_ROWS_ERROR;
+    return -1;
+  }
+
+  *count = 0;
+  g_grab.rows = count;
+  return 0;
+}
+
+Link *m0_init(FrameSource *source)
+{
+  g_source = source;
+  g_resampled = new uint8_t[CAM_RES1_WIDTH*CAM_RES1_HEIGHT];
+
+  // Both ends share the buffer at SM_LOC, like SMLink.  The block size isn't used in
+  // shared memory, but a C++ chirp server only considers itself connected if it's nonzero.
+  g_m4Link = new LoopbackLink(LINK_FLAG_ERROR_CORRECTED | LINK_FLAG_SHARED_MEM, SM_SIZE-4, (uint8_t *)SM_LOC+4, SM_SIZE-4);
+  g_m0Link = new LoopbackLink(LINK_FLAG_ERROR_CORRECTED | LINK_FLAG_SHARED_MEM, SM_SIZE-4, (uint8_t *)SM_LOC+4, SM_SIZE-4);
+  g_m4Link->connect(g_m0Link);
+
+  g_chirp = new Chirp(false, false, g_m0Link);
+  g_chirp->registerModule(g_module);
+  g_m4Link->setServer(g_chirp);
+
+  return g_m4Link;
+}
+
+void m0_close()
+{
+  delete g_chirp;
+  delete g_m0Link;
+  delete g_m4Link;
+  delete [] g_resampled;
+}
@@ -0,0 +1,49 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef M0_H
+#define M0_H
+
+#include <stdint.h>
+
+class Link;
+class FrameSource;
+
+// Stand-in for the M0 firmware (main_m0.c): serves "run", "stop", "running",
+// "getRLSFrame", "getFrame" and "getFrameRows" over a shared memory link and
+// writes run-length segments into the Qqueue at QQ_LOC like rls_m0.c does, from
+// frames supplied by a FrameSource.  The sensor runs in mode 1 (640x400); frames
+// of other sizes are resampled.
+
+#define M0_FRAME_PERIOD     20000 // us, 50 fps in mode 1
+
+// returns the M4's end of the link, for g_chirpM0
+Link *m0_init(FrameSource *source);
+void m0_close();
+
+// Produces one line of segments if the M0 program is running and there's room
+// in the queue, or one row of a getFrameRows grab.  Returns 1 if it did, 0 if there
+// wasn't room, -1 if the M0 program isn't running and M0_OUT_OF_FRAMES once there are
+// no more frames for it.  A grab that runs out of frames -> sim_exit().
+#define M0_OUT_OF_FRAMES    -2
+int m0_produce();
+
+// Lets the M0 program capture for usecs more, as it does on Pixy while the M4 is busy.
+// Frames are skipped or cut short as they would be there.
+void m0_advance(uint32_t usecs);
+
+extern uint32_t g_m0Frames;
+
+#endif
@@ -0,0 +1,69 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// Host stand-in for device/libpixy/misc.cpp.  Timers run on the simulated clock.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "misc.h"
+#include "sim.h"
+
+// each timer poll moves the clock this much, so busy waits finish
+#define SIM_POLL_TIME   100 // us
+
+void delayus(uint32_t us)
+{
+  g_simClock += us;
+}
+
+void delayms(uint32_t ms)
+{
+  g_simClock += ms*1000;
+}
+
+uint32_t button(void)
+{
+  return 0; // nobody's pressing it
+}
+
+uint32_t adc_get(uint32_t channel)
+{
+  return 0;
+}
+
+void setTimer(uint32_t *timer)
+{
+  *timer = g_simClock;
+}
+
+uint32_t getTimer(uint32_t timer)
+{
+  // the M0 runs alongside, e.g. grabbing rows while the M4 waits for them
+  sim_runM0();
+  g_simClock += SIM_POLL_TIME;
+  return g_simClock-timer;
+}
+
+// the scheduler has nothing to do, which is the M0's chance to run
+void waitEvent(void)
+{
+  sim_idle();
+}
+
+void showError(uint8_t num, uint32_t color, const char *message)
+{
+  fprintf(stderr, "error %d (led 0x%06x): %s", num, color, message ? message : "\n");
+  exit(1);
+}
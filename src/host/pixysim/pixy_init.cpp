@@ -0,0 +1,49 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <stdio.h>
+#include <stdarg.h>
+#include "pixy_init.h"
+
+Chirp *g_chirpUsb = NULL;
+Chirp *g_chirpM0 = NULL;
+uint8_t USB_Configuration = 0;
+
+// on Pixy cprintf() goes to PixyMon, here it goes to stdout
+bool g_cprintf = true;
+
+void cprintf(const char *format, ...)
+{
+  va_list args;
+
+  if (!g_cprintf)
+    return;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+}
+
+void periodic()
+{
+  if (g_chirpUsb)
+    while(g_chirpUsb->service());
+}
+
+// The links here can't tell without receiving, so service() is always called.  It
+// returns right away when nothing has come in.
+bool usbPending()
+{
+  return g_chirpUsb!=NULL;
+}
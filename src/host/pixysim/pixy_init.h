@@ -0,0 +1,35 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef PIXY_INIT_H
+#define PIXY_INIT_H
+
+// Host stand-in for device/libpixy/pixy_init.h
+
+#include "chirp.hpp"
+#include "debug.h"
+#include "pixyvals.h"
+
+void cprintf(const char *format, ...);
+void periodic();
+bool usbPending();
+
+extern Chirp *g_chirpUsb;
+extern Chirp *g_chirpM0;
+
+// nonzero when the USB host has configured us (usbcore.h)
+extern uint8_t USB_Configuration;
+
+#endif
@@ -0,0 +1,521 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// pixy-sim: runs the M4 firmware's program loop (exec_loop() and the programs in
+// device/video) on the host.  The camera, M0, flash, serial port and USB are
+// stand-ins (see m0.cpp, flash.cpp, serial.cpp and loopback.cpp), everything
+// else is the firmware's own code.  Each call to a program's loop function is
+// timed, less the time spent in the stand-ins, which gives the M4's cost per
+// frame on this machine.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <vector>
+#include <algorithm>
+#include "pixy_init.h"
+#include "misc.h"
+#include "param.h"
+#include "flash.h"
+#include "camera.h"
+#include "led.h"
+#include "rcservo.h"
+#include "conncomp.h"
+#include "serial.h"
+#include "exec.h"
+#include "perf.h"
+#include "progblobs.h"
+#include "progpt.h"
+#include "progchase.h"
+#include "progvideo.h"
+#include "tracker.h"
+#include "loopback.h"
+#include "socketlink.h"
+#include "frames.h"
+#include "m0.h"
+#include "qqueue.h"
+#include "sim.h"
+
+#define DEFAULT_FRAMES     300
+#define DEFAULT_WIDTH      CAM_RES2_WIDTH  // raw frame files, same as PixyMon grabs
+#define DEFAULT_HEIGHT     CAM_RES2_HEIGHT
+#define SIM_MAX_SPINS      100000 // idle calls with the M0 stopped before we give up
+
+static jmp_buf g_exit;
+static std::vector<uint32_t> g_frameUsecs;
+static uint64_t g_blocks = 0;
+static Program g_simProgs[EXEC_MAX_PROGS];
+static uint32_t g_slowdown = 0;
+
+void sim_exit()
+{
+  longjmp(g_exit, 1);
+}
+
+int sim_runM0()
+{
+  int res;
+  uint64_t start = sim_usecs();
+
+  res = m0_produce();
+  g_simUsecs += sim_usecs() - start;
+
+  return res;
+}
+
+void sim_idle()
+{
+  static uint32_t spins = 0;
+  int res;
+
+  // the M4 is waiting on the M0 and there won't be another frame, we're done
+  if ((res=sim_runM0())==M0_OUT_OF_FRAMES)
+    sim_exit();
+  if (res<0)
+  {
+    if (++spins>SIM_MAX_SPINS)
+    {
+      fprintf(stderr, "pixy-sim: M4 is waiting on the M0, but the M0 isn't running\n");
+      sim_exit();
+    }
+  }
+  else
+    spins = 0;
+}
+
+// Times one frame's worth of a program's loop, less the stand-ins' share.
+template <Program *prog> static int timedLoop()
+{
+  uint64_t start, simUsecs;
+  uint32_t numBlobs, numCCBlobs;
+  BlobA *blobs;
+  BlobB *ccBlobs;
+  int res;
+
+  simUsecs = g_simUsecs;
+  start = sim_usecs();
+  res = (*prog->loop)();
+  g_frameUsecs.push_back(sim_usecs() - start - (g_simUsecs - simUsecs));
+  // the M0 kept capturing while we were busy
+  if (g_slowdown)
+    m0_advance(g_frameUsecs.back()*g_slowdown);
+
+  g_blobs->getBlobs(&blobs, &numBlobs, &ccBlobs, &numCCBlobs);
+  g_blocks += numBlobs + numCCBlobs;
+
+  return res;
+}
+
+static Program *wrap(Program *prog, ProgFunc loop)
+{
+  static int n = 0;
+
+  g_simProgs[n] = *prog;
+  g_simProgs[n].loop = loop;
+  return &g_simProgs[n++];
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  -f file     frames, a PixyMon recording or raw 8-bit Bayer frames back to back\n"
+    "              (default: synthetic frames)\n"
+    "  -W width    raw frame width in pixels (default %d)\n"
+    "  -H height   raw frame height in pixels (default %d)\n"
+    "  -n frames   number of synthetic frames (default %d)\n"
+    "  -p prog     program to run, 1=blobs, 2=pan/tilt, 3=chase, 8=video (default 1)\n"
+    "  -b rows     video frames go out in bands of this many rows (\"Frame band rows\")\n"
+    "  -s file     signature file, same format as pixyproc's\n"
+    "  -t s,x,y,w,h  teach signature s (1-7) from a region of the first frame (320x200)\n"
+    "  -i file     flash image (default pixysim.bin)\n"
+    "  -k          keep the flash image's parameters instead of starting fresh\n"
+    "  -u          connect a host over USB, so blocks and frames are sent\n"
+    "  -l address  serve USB on a socket, host:port or a Unix socket path, and wait\n"
+    "              for PixyMon or a libpixyusb program (PIXY_ADDRESS=address) to connect\n"
+    "  -o file     write the serial port's output to file\n"
+    "  -d protocol serial block format, 0=original, 1=framed v2, 2=v2 deltas (\"Data out protocol\")\n"
+    "  -r len,gap,vert  run filter, \"Min run length\", \"Max run gap\", \"Vertical run filter\"\n"
+    "  -T sig      track signature sig, in a window once it's found (\"Tracking signature\")\n"
+    "  -x factor   Pixy's M4 is this many times slower than this host, the M0 keeps\n"
+    "              capturing for that long after each frame (default 0, it waits)\n"
+    "  -P          print the time in each stage of a frame and the counters (perf_get)\n"
+    "  -v          print the time of each frame\n"
+    "  -q          don't print cprintf() output\n"
+    "\n"
+    "Without -s or -t, synthetic frames teach one signature per colored rectangle.\n",
+    name, DEFAULT_WIDTH, DEFAULT_HEIGHT, DEFAULT_FRAMES);
+}
+
+static int loadSignatures(const char *filename)
+{
+  FILE *file;
+  char line[256], id[32];
+  int sig, type, n, lineNum;
+  ColorModel model;
+
+  file = fopen(filename, "r");
+  if (file==NULL)
+  {
+    perror(filename);
+    return -1;
+  }
+
+  for (lineNum=1; fgets(line, sizeof(line), file); lineNum++)
+  {
+    if (line[0]=='#' || line[0]=='\n' || line[0]=='\r')
+      continue;
+    n = sscanf(line, "%d %d %f %f %f %f %f %f %f %f", &sig, &type,
+               &model.m_hue[0].m_slope, &model.m_hue[0].m_yi, &model.m_hue[1].m_slope, &model.m_hue[1].m_yi,
+               &model.m_sat[0].m_slope, &model.m_sat[0].m_yi, &model.m_sat[1].m_slope, &model.m_sat[1].m_yi);
+    if (n!=10 || sig<1 || sig>NUM_MODELS)
+    {
+      fprintf(stderr, "%s:%d: bad signature line\n", filename, lineNum);
+      fclose(file);
+      return -1;
+    }
+    model.m_type = type ? CL_MODEL_TYPE_COLORCODE : 0;
+    sprintf(id, "signature%d", sig);
+    prm_set(id, INTS8(sizeof(ColorModel), &model), END);
+  }
+
+  fclose(file);
+  return cc_loadLut();
+}
+
+// same as the "Set signature" action: grab a frame, then cc_setSigRegion
+static int teach(uint8_t sig, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+  int res;
+
+  if (g_rawFrame.m_pixels==NULL)
+    cam_getFrameChirp(CAM_GRAB_M1R2, 0, 0, CAM_RES2_WIDTH, CAM_RES2_HEIGHT, g_chirpUsb);
+  if ((res=cc_setSigRegion(0, sig, x, y, w, h))<0)
+    fprintf(stderr, "pixy-sim: unable to teach signature %d from %d,%d %dx%d (%d)\n", sig, x, y, w, h, res);
+  return res;
+}
+
+static void printPerf()
+{
+  uint32_t i, j;
+  const PerfStats *s;
+
+  fprintf(stderr, "%-9s %6s %9s %9s %9s   us: <16 <64 <256 <1k <4k <16k <64k more\n", "stage", "count", "min us",
+          "avg us", "max us");
+  for (i=0; i<PERF_STAGES; i++)
+  {
+    s = &g_perfStages[i];
+    if (s->count==0)
+      continue;
+    fprintf(stderr, "%-9s %6u %9.1f %9.1f %9.1f  ", g_perfStageNames[i], s->count, (double)s->min/CTIMER_TICKS_PER_US,
+            (double)s->sum/s->count/CTIMER_TICKS_PER_US, (double)s->max/CTIMER_TICKS_PER_US);
+    for (j=0; j<PERF_HIST_BUCKETS; j++)
+      fprintf(stderr, " %u", s->hist[j]);
+    fprintf(stderr, "\n");
+  }
+  for (i=0; i<PERF_COUNTERS; i++)
+    fprintf(stderr, "%s%s %u", i ? ", " : "", g_perfCounterNames[i], g_perfCounters[i]);
+  fprintf(stderr, "\n");
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, uint32_t pct)
+{
+  return sorted[(sorted.size()-1)*pct/100];
+}
+
+int main(int argc, char *argv[])
+{
+  int opt, sig, res;
+  uint32_t i, x, y, w, h, frames=DEFAULT_FRAMES, width=DEFAULT_WIDTH, height=DEFAULT_HEIGHT;
+  uint64_t sum;
+  uint8_t prog=1;
+  int bandRows=-1, protocol=-1, tracking=-1, runFilter[3]={-1, -1, -1};
+  bool keep=false, usb=false, verbose=false, sigs=false, perf=false;
+  const char *framesFile=NULL, *sigFile=NULL, *image="pixysim.bin", *address=NULL;
+  FILE *serialOut=NULL;
+  std::vector<uint32_t> teachArgs;
+  FrameSource source;
+  Link *m0Link;
+  LoopbackLink usbDevice, usbHost;
+  SocketLink usbSocket;
+  Chirp *host=NULL;
+  QqueueFields *qq = (QqueueFields *)QQ_LOC;
+
+  while ((opt=getopt(argc, argv, "f:W:H:n:p:b:s:t:i:kul:o:d:r:T:x:Pvq"))!=-1)
+  {
+    switch (opt)
+    {
+    case 'f':
+      framesFile = optarg;
+      break;
+    case 'W':
+      width = atoi(optarg);
+      break;
+    case 'H':
+      height = atoi(optarg);
+      break;
+    case 'n':
+      frames = atoi(optarg);
+      break;
+    case 'p':
+      prog = atoi(optarg);
+      break;
+    case 'b':
+      bandRows = atoi(optarg);
+      break;
+    case 's':
+      sigFile = optarg;
+      break;
+    case 't':
+      if (sscanf(optarg, "%d,%u,%u,%u,%u", &sig, &x, &y, &w, &h)!=5 || sig<1 || sig>NUM_MODELS)
+      {
+        fprintf(stderr, "bad teach region: %s\n", optarg);
+        return 1;
+      }
+      teachArgs.push_back(sig);
+      teachArgs.push_back(x);
+      teachArgs.push_back(y);
+      teachArgs.push_back(w);
+      teachArgs.push_back(h);
+      break;
+    case 'i':
+      image = optarg;
+      break;
+    case 'k':
+      keep = true;
+      break;
+    case 'u':
+      usb = true;
+      break;
+    case 'l':
+      address = optarg;
+      break;
+    case 'o':
+      if ((serialOut=fopen(optarg, "wb"))==NULL)
+      {
+        perror(optarg);
+        return 1;
+      }
+      break;
+    case 'd':
+      protocol = atoi(optarg);
+      break;
+    case 'r':
+      if (sscanf(optarg, "%d,%d,%d", &runFilter[0], &runFilter[1], &runFilter[2])!=3)
+      {
+        fprintf(stderr, "bad run filter: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case 'T':
+      tracking = atoi(optarg);
+      break;
+    case 'x':
+      g_slowdown = atoi(optarg);
+      break;
+    case 'P':
+      perf = true;
+      break;
+    case 'v':
+      verbose = true;
+      break;
+    case 'q':
+      g_cprintf = false;
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (optind<argc || (usb && address))
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (framesFile)
+    res = source.open(framesFile, width, height);
+  else
+    res = source.synthetic(frames, CAM_RES1_WIDTH, CAM_RES1_HEIGHT);
+  if (res<=0)
+  {
+    fprintf(stderr, "pixy-sim: unable to get frames from %s (%d)\n", framesFile ? framesFile : "generator", res);
+    return 1;
+  }
+
+  if (!keep)
+    unlink(image);
+  if (sim_mapMemory()<0 || flash_open(image)<0)
+  {
+    fprintf(stderr, "pixy-sim: unable to set up memory or flash image %s\n", image);
+    return 1;
+  }
+
+  // pixyInit()
+  if (address)
+  {
+    if (usbSocket.listen(address)<0)
+    {
+      fprintf(stderr, "pixy-sim: unable to listen on %s\n", address);
+      return 1;
+    }
+    fprintf(stderr, "pixy-sim: waiting for a host on %s\n", address);
+    if (usbSocket.accept(0)<0)
+    {
+      fprintf(stderr, "pixy-sim: unable to accept a host on %s\n", address);
+      return 1;
+    }
+    g_chirpUsb = new Chirp(false, false, &usbSocket);
+  }
+  else
+  {
+    usbDevice.connect(&usbHost);
+    g_chirpUsb = new Chirp(false, false, &usbDevice);
+  }
+  m0Link = m0_init(&source);
+  g_chirpM0 = new Chirp(false, true, m0Link);
+  led_init();
+  if (prm_init(g_chirpUsb)<0)
+    showError(1, 0x0000ff, "Flash is corrupt, parameters have been lost\n");
+  cam_init();
+  rcs_init();
+
+  // main()
+  cc_init(g_chirpUsb);
+  ser_init();
+  exec_init(g_chirpUsb);
+  perf_init(g_chirpUsb);
+
+  exec_addProg(wrap(&g_progBlobs, timedLoop<&g_progBlobs>));
+  trk_loadParams();
+  ptLoadParams();
+  exec_addProg(wrap(&g_progPt, timedLoop<&g_progPt>));
+  chaseLoadParams();
+  exec_addProg(wrap(&g_progChase, timedLoop<&g_progChase>));
+  exec_addProg(wrap(&g_progVideo, timedLoop<&g_progVideo>), true);
+
+  ser_simOutput(serialOut);
+  prm_set("Default program", UINT8(prog), END);
+  if (bandRows>=0)
+  {
+    prm_set("Frame band rows", UINT8(bandRows), END);
+    cam_loadParams();
+  }
+  if (protocol>=0)
+  {
+    prm_set("Data out protocol", UINT8(protocol), END);
+    ser_loadParams();
+  }
+  if (runFilter[0]>=0)
+  {
+    prm_set("Min run length", UINT8(runFilter[0]), END);
+    prm_set("Max run gap", UINT8(runFilter[1]), END);
+    prm_set("Vertical run filter", UINT8(runFilter[2]), END);
+    cc_loadParams();
+  }
+  if (tracking>=0)
+  {
+    prm_set("Tracking signature", UINT16(tracking), END);
+    trk_loadParams();
+  }
+
+  // signatures
+  if (sigFile)
+  {
+    if (loadSignatures(sigFile)<0)
+      return 1;
+    sigs = true;
+  }
+  for (i=0; i<teachArgs.size(); i+=5)
+  {
+    if (teach(teachArgs[i], teachArgs[i+1], teachArgs[i+2], teachArgs[i+3], teachArgs[i+4])<0)
+      return 1;
+    sigs = true;
+  }
+  if (!sigs && !framesFile)
+  {
+    uint16_t rx, ry, rw, rh;
+
+    // grab the frame first, the regions are for the current frame
+    cam_getFrameChirp(CAM_GRAB_M1R2, 0, 0, CAM_RES2_WIDTH, CAM_RES2_HEIGHT, g_chirpUsb);
+    for (sig=1; source.region(sig, &rx, &ry, &rw, &rh)==0; sig++)
+    {
+      // region is in sensor coordinates, signatures are taught at half that
+      if (teach(sig, rx/2+2, ry/2+2, rw/2-4, rh/2-4)<0)
+        return 1;
+    }
+  }
+
+  if (usb)
+  {
+    // host connects, then drops everything it receives on the floor
+    usbHost.setServer(g_chirpUsb);
+    host = new Chirp(false, true, &usbHost);
+    if (!host->connected())
+    {
+      fprintf(stderr, "pixy-sim: unable to connect to USB host\n");
+      return 1;
+    }
+    usbHost.setDiscard(true);
+    USB_Configuration = 1;
+  }
+  else if (address)
+    USB_Configuration = 1; // the host does its own init
+
+  if (setjmp(g_exit)==0)
+    exec_loop();
+
+  // report
+  if (verbose)
+  {
+    for (i=0; i<g_frameUsecs.size(); i++)
+      printf("frame %u: %u us\n", i, g_frameUsecs[i]);
+  }
+  if (g_frameUsecs.size()==0)
+  {
+    fprintf(stderr, "pixy-sim: no frames processed\n");
+    return 1;
+  }
+  std::vector<uint32_t> sorted(g_frameUsecs);
+  std::sort(sorted.begin(), sorted.end());
+  for (i=0, sum=0; i<sorted.size(); i++)
+    sum += sorted[i];
+
+  if (perf)
+    printPerf();
+  fprintf(stderr, "program %d, %u frames (%u from camera), %llu blocks\n", prog, (uint32_t)sorted.size(), g_m0Frames,
+          (unsigned long long)g_blocks);
+  fprintf(stderr, "M4 frame time: min %u us, avg %u us, median %u us, p99 %u us, max %u us\n", sorted[0],
+          (uint32_t)(sum/sorted.size()), percentile(sorted, 50), percentile(sorted, 99), sorted.back());
+  fprintf(stderr, "worst frame used %.1f%% of the %d us frame period on this host\n",
+          sorted.back()*100.0/M0_FRAME_PERIOD, M0_FRAME_PERIOD);
+  fprintf(stderr, "M0: %u frames handed over, %u skipped (no slot or no room), %u cut short (queue full)\n",
+          qq->frames, qq->skipped, qq->truncated);
+  if (tracking>0)
+    fprintf(stderr, "tracking: %u frames in a window, target lost %u times\n", g_perfCounters[PERF_WINDOWED],
+            g_perfCounters[PERF_TRACK_LOST]);
+  fprintf(stderr, "serial: %llu bytes, USB: %llu bytes in %u sends, flash: %u erases\n",
+          (unsigned long long)ser_simBytes(),
+          (unsigned long long)(address ? usbSocket.m_sentBytes : usbDevice.m_sentBytes),
+          address ? usbSocket.m_sends : usbDevice.m_sends, g_flashErases);
+
+  if (serialOut)
+    fclose(serialOut);
+  flash_close();
+
+  return 0;
+}
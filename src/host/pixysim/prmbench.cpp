@@ -0,0 +1,146 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// prmbench -- compares writing Pixy's parameters one at a time against writing them
+// in a single prm_begin()/prm_commit() transaction, using the firmware's param.cpp on
+// top of file-backed flash.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "flash.h"
+#include "param.h"
+
+static uint64_t now()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (uint64_t)tv.tv_sec*1000000 + tv.tv_usec;
+}
+
+static void usage()
+{
+  fprintf(stderr, "usage: prmbench [-n params] [-l lookups] [flash image]\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  int c, i, n=24, lookups=100000, errors=0, committed;
+  int32_t val;
+  uint32_t erases, programs;
+  uint64_t t;
+  char id[32];
+  const char *filename = "prmbench.bin";
+
+  while ((c=getopt(argc, argv, "n:l:"))!=-1)
+  {
+    switch (c)
+    {
+    case 'n':
+      n = atoi(optarg);
+      break;
+    case 'l':
+      lookups = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind<argc)
+    filename = argv[optind];
+  if (n<=0 || lookups<=0)
+    usage();
+
+  if (flash_open(filename)<0)
+  {
+    fprintf(stderr, "prmbench: can't open %s\n", filename);
+    return 1;
+  }
+
+  Chirp chirp;
+  prm_format();
+  prm_init(&chirp);
+  for (i=0; i<n; i++)
+  {
+    sprintf(id, "param%d", i);
+    if (prm_add(id, 0, "Benchmark parameter @c Benchmark", INT32(i), END)<0)
+    {
+      fprintf(stderr, "prmbench: can't add %s, too many parameters?\n", id);
+      return 1;
+    }
+  }
+
+  // one at a time (what prm_set() did before transactions)
+  erases = g_flashErases;
+  programs = g_flashPrograms;
+  t = now();
+  for (i=0; i<n; i++)
+  {
+    sprintf(id, "param%d", i);
+    prm_set(id, INT32(i+1000), END);
+  }
+  t = now()-t;
+  printf("individual:  %d params, %d sector erases, %d programs, %d us\n", n,
+         g_flashErases-erases, g_flashPrograms-programs, (int)t);
+
+  // all at once
+  erases = g_flashErases;
+  programs = g_flashPrograms;
+  t = now();
+  prm_begin();
+  for (i=0; i<n; i++)
+  {
+    sprintf(id, "param%d", i);
+    prm_set(id, INT32(i+2000), END);
+  }
+  committed = prm_commit();
+  t = now()-t;
+  printf("transaction: %d params, %d sector erases, %d programs, %d us\n", n,
+         g_flashErases-erases, g_flashPrograms-programs, (int)t);
+  // more sectors than a transaction can stage, none of it should be written
+  if (committed<0)
+    printf("transaction: rejected (%d), too many sectors\n", committed);
+
+  // lookups by id
+  t = now();
+  for (i=0; i<lookups; i++)
+  {
+    sprintf(id, "param%d", i%n);
+    prm_get(id, &val, END);
+  }
+  t = now()-t;
+  printf("lookup:      %.3f us per prm_get()\n", (double)t/lookups);
+
+  // reopen and make sure everything made it to "flash"
+  flash_close();
+  if (flash_open(filename)<0 || prm_init(&chirp)<0)
+  {
+    fprintf(stderr, "prmbench: parameters corrupt after reopen\n");
+    return 1;
+  }
+  for (i=0; i<n; i++)
+  {
+    sprintf(id, "param%d", i);
+    if (prm_get(id, &val, END)<0 || val!=(committed<0 ? i+1000 : i+2000))
+      errors++;
+  }
+  printf("verify:      %d errors\n", errors);
+  flash_close();
+
+  return errors ? 1 : 0;
+}
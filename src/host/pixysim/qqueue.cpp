@@ -0,0 +1,84 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// Host stand-in for common/qqueue.cpp (M4 side, PIXY build).  The same queue
+// at QQ_LOC, except that dequeue() lets the M0 stand-in run when the queue is
+// empty-- the firmware spins on dequeue() waiting for the M0, and there's no
+// M0 running alongside us here.  It still returns 0 that time, so the wait is
+// the M0's time, as it would be on Pixy (see the perf probes in Blobs::unpack).
+
+#include <string.h>
+#include <pixyvals.h>
+#include "qqueue.h"
+#include "sim.h"
+
+Qqueue::Qqueue()
+{
+  m_fields = (QqueueFields *)QQ_LOC;
+  memset((void *)m_fields, 0, sizeof(QqueueFields));
+}
+
+Qqueue::~Qqueue()
+{
+}
+
+uint32_t Qqueue::dequeue(uint32_t *val)
+{
+  uint16_t len = m_fields->produced - m_fields->consumed;
+  if (len==0)
+    sim_idle();
+  else
+  {
+    *val = m_fields->data[m_fields->readIndex++];
+    m_fields->consumed++;
+    if (m_fields->readIndex==QQ_MEM_SIZE)
+      m_fields->readIndex = 0;
+    return 1;
+  }
+  return 0;
+}
+
+uint32_t Qqueue::readAll(Qval *mem, uint32_t size)
+{
+  uint16_t len = m_fields->produced - m_fields->consumed;
+  uint16_t i, j;
+
+  for (i=0, j=m_fields->readIndex; i<len && i<size; i++)
+  {
+    mem[i] = m_fields->data[j++];
+    if (j==QQ_MEM_SIZE)
+      j = 0;
+  }
+  // flush the rest
+  m_fields->consumed += len;
+  m_fields->readIndex += len;
+  if (m_fields->readIndex>=QQ_MEM_SIZE)
+    m_fields->readIndex -= QQ_MEM_SIZE;
+
+  return i;
+}
+
+void Qqueue::flush()
+{
+  uint16_t len = m_fields->produced - m_fields->consumed;
+
+  m_fields->released = m_fields->frames;
+  m_fields->windowCols = m_fields->windowRows = 0;
+
+  m_fields->consumed += len;
+  m_fields->readIndex += len;
+  if (m_fields->readIndex>=QQ_MEM_SIZE)
+    m_fields->readIndex -= QQ_MEM_SIZE;
+}
@@ -0,0 +1,115 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// Host stand-in for device/libpixy/rcservo.cpp.  Same parameters and limits,
+// the pulse widths are kept instead of going to the SCT.
+
+#include "pixy_init.h"
+#include "param.h"
+#include "pixytypes.h"
+#include "rcservo.h"
+
+static uint16_t g_rcsPos[RCS_NUM_AXES];
+static int16_t g_rcsMinPwm[RCS_NUM_AXES];
+static int16_t g_rcsPwmGain[RCS_NUM_AXES];
+
+uint16_t g_rcsPwm[RCS_NUM_AXES];
+
+void rcs_init()
+{
+  int i;
+
+  for (i=0; i<RCS_NUM_AXES; i++)
+  {
+    g_rcsMinPwm[i] = RCS_MIN_PWM;
+    g_rcsPwmGain[i] = 1<<RCS_GAIN_SCALE;
+    rcs_setPos(i, RCS_CENTER_POS);
+  }
+
+  rcs_loadParams();
+}
+
+void rcs_loadParams()
+{
+  prm_add("S0 lower limit", PRM_FLAG_SIGNED,
+    "@c Servo Sets the lower limit of travel for servo 0 (default -200)", INT16(-200), END);
+  prm_add("S0 upper limit", PRM_FLAG_SIGNED,
+    "@c Servo Sets the upper limit of travel for servo 0 (default 200)", INT16(200), END);
+  prm_add("S1 lower limit", PRM_FLAG_SIGNED,
+    "@c Servo Sets the lower limit of travel for servo 1 (default -200)", INT16(-200), END);
+  prm_add("S1 upper limit", PRM_FLAG_SIGNED,
+    "@c Servo Sets the upper limit of travel for servo 1 (default 200)", INT16(200), END);
+  prm_add("Servo frequency", PRM_FLAG_ADVANCED,
+    "@c Servo Sets the PWM frequency of the servos (default 100)", UINT16(100), END);
+
+  int16_t lower, upper;
+
+  prm_get("S0 lower limit", &lower, END);
+  prm_get("S0 upper limit", &upper, END);
+  rcs_setLimits(0, lower, upper);
+
+  prm_get("S1 lower limit", &lower, END);
+  prm_get("S1 upper limit", &upper, END);
+  rcs_setLimits(1, lower, upper);
+}
+
+int32_t rcs_setPos(const uint8_t &channel, const uint16_t &pos)
+{
+  if (channel>=RCS_NUM_AXES || pos>RCS_MAX_POS)
+    return -1;
+
+  g_rcsPwm[channel] = g_rcsMinPwm[channel] + (((uint32_t)pos*g_rcsPwmGain[channel])>>RCS_GAIN_SCALE);
+  g_rcsPos[channel] = pos;
+
+  return 0;
+}
+
+int32_t rcs_getPos(const uint8_t &channel)
+{
+  if (channel>=RCS_NUM_AXES)
+    return -1;
+
+  return g_rcsPos[channel];
+}
+
+int32_t rcs_enable(const uint8_t &channel, const uint8_t &enable)
+{
+  if (channel>=RCS_NUM_AXES)
+    return -1;
+
+  return 0;
+}
+
+int32_t rcs_setLimits(const uint8_t &channel, const int16_t &lower, const int16_t &upper)
+{
+  if (channel>=RCS_NUM_AXES || upper>500 || upper<-500 || lower>500 || lower<-500)
+    return -1;
+
+  g_rcsMinPwm[channel] = RCS_MIN_PWM+lower;
+  g_rcsPwmGain[channel] = ((RCS_PWM_RANGE+upper-lower)<<RCS_GAIN_SCALE)/RCS_MAX_POS;
+
+  // update
+  rcs_setPos(channel, g_rcsPos[channel]);
+
+  return 0;
+}
+
+int32_t rcs_setFreq(const uint16_t &freq)
+{
+  if (freq<20 || freq>300)
+    return -1;
+
+  return 0;
+}
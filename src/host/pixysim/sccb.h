@@ -0,0 +1,50 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef _SCCB_H
+#define _SCCB_H
+
+#include <string.h>
+
+// Host stand-in for device/libpixy/sccb.h.  The imager's registers are just
+// memory, so camera.cpp's settings read back as written.
+
+class CSccb
+{
+public:
+  CSccb(unsigned char dev)
+  {
+    m_dev = dev;
+    Reset();
+  }
+  void Write(unsigned char addr, unsigned char val)
+  {
+    m_regs[addr] = val;
+  }
+  unsigned char Read(unsigned char addr)
+  {
+    return m_regs[addr];
+  }
+  void Reset()
+  {
+    memset(m_regs, 0, sizeof(m_regs));
+  }
+
+private:
+  unsigned char m_dev;
+  unsigned char m_regs[0x100];
+};
+
+#endif
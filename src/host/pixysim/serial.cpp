@@ -0,0 +1,166 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// Host stand-in for device/libpixy/serial.cpp.  Every interface is the same
+// in-memory port: update() drains the frame's blocks the way an Arduino
+// polling the SPI port would, and received bytes come from a queue that the
+// simulation can fill.
+
+#include <stdio.h>
+#include "serial.h"
+#include "conncomp.h"
+#include "param.h"
+#include "sim.h"
+#include "perf.h"
+
+#define SIM_SERIAL_RECEIVEBUF_SIZE  64
+#define SIM_SERIAL_TRANSMITBUF_SIZE 32 // words, as SPI_TRANSMITBUF_SIZE
+#define SIM_SERIAL_MAX_WORDS        0x1000 // per update, in case blocks never run out
+
+class SimSerial : public Iserial
+{
+public:
+  SimSerial(SerialCallback callback) : m_rq(SIM_SERIAL_RECEIVEBUF_SIZE), m_tq(SIM_SERIAL_TRANSMITBUF_SIZE, callback)
+  {
+    m_out = NULL;
+    m_bytes = 0;
+  }
+
+  virtual int receive(uint8_t *buf, uint32_t len)
+  {
+    uint32_t i;
+
+    for (i=0; i<len; i++)
+    {
+      if (m_rq.read(buf+i)==0)
+        break;
+    }
+    return i;
+  }
+
+  virtual int receiveLen()
+  {
+    return m_rq.receiveLen();
+  }
+
+  virtual int update()
+  {
+    const uint16_t *data;
+    uint32_t len, words;
+
+    // drained the way the SPI ISR does it, a chunk at a time
+    for (words=0; words<SIM_SERIAL_MAX_WORDS; words+=len)
+    {
+      len = m_tq.peek(&data);
+      if (len==0)
+        break;
+      m_tq.consume(len);
+      // a null word by itself means there's nothing more to send this frame
+      if (len==1 && data[0]==0)
+        break;
+      m_bytes += len*sizeof(uint16_t);
+      if (m_out)
+        fwrite(data, sizeof(uint16_t), len, m_out);
+    }
+    return 0;
+  }
+
+  ReceiveQ<uint8_t> m_rq;
+  TransmitQ<uint16_t> m_tq;
+  FILE *m_out;
+  uint64_t m_bytes;
+};
+
+static uint8_t g_interface = 0;
+static uint8_t g_protocol = SER_PROTOCOL_V1;
+static SimSerial *g_serial = NULL;
+
+static uint32_t callback(uint8_t *data, uint32_t len)
+{
+  PERF_DECLARE(timer);
+
+  PERF_START(timer);
+  if (g_protocol>=SER_PROTOCOL_V2)
+    len = g_blobs->getBlockV2(data, len);
+  else
+    len = g_blobs->getBlocks(data, len);
+  PERF_STOP(PERF_SERIAL, timer);
+
+  return len;
+}
+
+int ser_init()
+{
+  g_serial = new SimSerial(callback);
+
+  ser_loadParams();
+
+  return 0;
+}
+
+void ser_loadParams()
+{
+  prm_add("Data out port", 0,
+    "@c Interface Selects the port that's used to output data, 0=SPI, 1=I2C, 2=UART, 3=analog/digital x, 4=analog/digital y (default 0)", UINT8(0), END);
+  prm_add("I2C address", PRM_FLAG_HEX_FORMAT,
+    "@c Interface Sets the I2C address if you are using I2C data out port. (default 0x54)", UINT8(0x54), END);
+  prm_add("UART baudrate", 0,
+    "@c Interface Sets the UART baudrate if you are using UART data out port. (default 19200)", UINT32(19200), END);
+  prm_add("Data out protocol", 0,
+    "@c Interface Selects the block format, 0=original (14 bytes a block), 1=framed v2 (5 bytes a block, frames have a counter and CRC), 2=framed v2 with delta frames (default 0)", UINT8(SER_PROTOCOL_V1), END);
+  prm_add("Data out keyframe period", 0,
+    "@c Interface Sets how often a whole frame is sent if Data out protocol is 2, every this many frames. (default 10)", UINT8(10), END);
+
+  uint8_t interface, period;
+
+  prm_get("Data out port", &interface, END);
+  ser_setInterface(interface);
+
+  prm_get("Data out protocol", &g_protocol, END);
+  prm_get("Data out keyframe period", &period, END);
+  g_blobs->setKeyframePeriod(g_protocol==SER_PROTOCOL_V2_DELTA ? period : 0);
+}
+
+int ser_setInterface(uint8_t interface)
+{
+  if (interface>SER_INTERFACE_ADY)
+    return -1;
+
+  g_interface = interface;
+
+  return 0;
+}
+
+uint8_t ser_getInterface()
+{
+  return g_interface;
+}
+
+Iserial *ser_getSerial()
+{
+  return g_serial;
+}
+
+// host only, see sim.h
+int ser_simOutput(FILE *file)
+{
+  g_serial->m_out = file;
+  return 0;
+}
+
+uint64_t ser_simBytes()
+{
+  return g_serial->m_bytes;
+}
@@ -0,0 +1,241 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// serialbench -- the serial ports' queues (iserial.h) on this machine.  A callback
+// hands out blocks shaped like getBlock()'s, one per call the way the serial
+// callback used to, or as many as fit the way getBlocks() does.  The transmit
+// queue is drained a word at a time with read(), or a FIFO's worth at a time with
+// peek() and consume(), as the SPI ISR does now.  Every combination has to send the
+// same words.  The receive queue's bulk read() and write() are checked against
+// the single ones too.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "iserial.h"
+#include "sim.h"
+
+#define DEFAULT_WORDS       (16*1024*1024) // sent per combination
+#define TRANSMITBUF_SIZE    32 // words, as SPI_TRANSMITBUF_SIZE
+#define FIFO_SIZE           8 // words, the SSP's transmit FIFO
+#define BLOCK_WORDS         7 // sync, checksum, signature, x, y, width, height
+#define BLOCKS_PER_FRAME    10
+#define RECEIVEQ_SIZE       64
+
+static bool g_batch;
+static uint32_t g_block;
+static uint32_t g_calls;
+
+// like Blobs::getBlock(), a frame of blocks, the first with an extra sync word
+static uint32_t block(uint16_t *buf, uint32_t len)
+{
+  uint32_t n = BLOCK_WORDS;
+  uint16_t sum;
+
+  if (g_block%BLOCKS_PER_FRAME==0)
+    n++;
+  if (len<n)
+    return 0;
+  if (n>BLOCK_WORDS)
+    *buf++ = 0xaa55;
+  buf[0] = 0xaa55;
+  buf[2] = g_block%7 + 1;
+  buf[3] = g_block%320;
+  buf[4] = g_block%200;
+  buf[5] = g_block%31 + 1;
+  buf[6] = g_block%17 + 1;
+  sum = buf[2] + buf[3] + buf[4] + buf[5] + buf[6];
+  buf[1] = sum;
+  g_block++;
+
+  return n;
+}
+
+static uint32_t callback(uint8_t *data, uint32_t len)
+{
+  uint16_t *buf = (uint16_t *)data;
+  uint32_t n, total = 0;
+
+  g_calls++;
+  len /= sizeof(uint16_t);
+  do
+  {
+    if ((n=block(buf+total, len-total))==0)
+      break;
+    total += n;
+  } while (g_batch);
+
+  return total*sizeof(uint16_t);
+}
+
+// words/us, sent into out
+static double transmit(bool batch, bool burst, uint16_t *out, uint32_t words)
+{
+  TransmitQ<uint16_t> tq(TRANSMITBUF_SIZE, callback);
+  const uint16_t *chunk;
+  uint32_t i, n, len;
+  uint64_t begin, t;
+
+  g_batch = batch;
+  g_block = 0;
+  g_calls = 0;
+  begin = sim_usecs();
+  if (burst)
+  {
+    for (i=0; i<words; i+=n) // each pass is an interrupt filling the FIFO
+    {
+      for (n=0; n<FIFO_SIZE && i+n<words; n+=len)
+      {
+        if ((len=tq.peek(&chunk))==0)
+          break;
+        if (len>FIFO_SIZE-n)
+          len = FIFO_SIZE-n;
+        if (len>words-i-n)
+          len = words-i-n;
+        memcpy(out+i+n, chunk, len*sizeof(uint16_t));
+        tq.consume(len);
+      }
+      if (n==0)
+        break;
+    }
+  }
+  else
+  {
+    for (i=0; i<words; i++)
+    {
+      if (tq.read(out+i)==0)
+        break;
+    }
+  }
+  t = sim_usecs()-begin;
+
+  return t ? (double)i/t : 0;
+}
+
+// TransmitQ's bulk read(), odd lengths across chunk boundaries
+static int checkTransmitQ(const std::vector<uint16_t> &expected)
+{
+  TransmitQ<uint16_t> tq(TRANSMITBUF_SIZE, callback);
+  uint16_t buf[TRANSMITBUF_SIZE*3];
+  uint32_t i, n;
+
+  g_batch = true;
+  g_block = 0;
+  for (i=0; i<expected.size() && i<100000; i+=n)
+  {
+    n = i%(sizeof(buf)/sizeof(buf[0])) + 1;
+    if (n>expected.size()-i)
+      n = expected.size()-i;
+    if (tq.read(buf, n)!=(int)n || memcmp(buf, &expected[i], n*sizeof(uint16_t)))
+      return -1;
+  }
+  return 0;
+}
+
+static int checkReceiveQ()
+{
+  ReceiveQ<uint16_t> q(RECEIVEQ_SIZE), r(RECEIVEQ_SIZE);
+  uint16_t in[RECEIVEQ_SIZE*2], a[RECEIVEQ_SIZE*2], b[RECEIVEQ_SIZE*2];
+  uint32_t i, j, n, m;
+
+  for (i=0; i<sizeof(in)/sizeof(in[0]); i++)
+    in[i] = i*7919;
+  // odd lengths so the reads and writes wrap around at every offset
+  for (i=0; i<1000; i++)
+  {
+    n = i%(RECEIVEQ_SIZE+5);
+    m = q.write(in, n);
+    for (j=0; j<n; j++)
+    {
+      if (r.write(in[j])==0)
+        break;
+    }
+    if (m!=j || q.receiveLen()!=r.receiveLen())
+      return -1;
+    n = (i*3)%(RECEIVEQ_SIZE+3);
+    m = q.read(a, n);
+    for (j=0; j<n; j++)
+    {
+      if (r.read(b+j)==0)
+        break;
+    }
+    if (m!=j || memcmp(a, b, m*sizeof(uint16_t)) || q.receiveLen()!=r.receiveLen())
+      return -1;
+  }
+  return 0;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: serialbench [options]\n"
+    "  -w words    sent per combination (default %d)\n",
+    DEFAULT_WORDS);
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  int c, res = 0;
+  uint32_t i, calls[4], words=DEFAULT_WORDS;
+  double rate[4];
+  static const char *names[] = {"block per call, word reads", "block per call, FIFO bursts",
+                                "buffer per call, word reads", "buffer per call, FIFO bursts"};
+
+  while ((c=getopt(argc, argv, "w:"))!=-1)
+  {
+    switch (c)
+    {
+    case 'w':
+      words = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind<argc || words==0)
+    usage();
+
+  if (checkReceiveQ()<0)
+  {
+    fprintf(stderr, "ReceiveQ's bulk read/write don't match the single ones\n");
+    return 1;
+  }
+
+  std::vector<uint16_t> expected(words), out(words);
+  for (i=0; i<4; i++)
+  {
+    rate[i] = transmit(i>=2, i&1, i ? &out[0] : &expected[0], words);
+    calls[i] = g_calls;
+    if (i && out!=expected)
+    {
+      fprintf(stderr, "%s sent different words\n", names[i]);
+      res = 1;
+    }
+  }
+  if (checkTransmitQ(expected)<0)
+  {
+    fprintf(stderr, "TransmitQ's bulk read doesn't match\n");
+    res = 1;
+  }
+
+  printf("%-30s %12s %12s\n", "", "Mwords/s", "callbacks");
+  for (i=0; i<4; i++)
+    printf("%-30s %12.1f %12u\n", names[i], rate[i], calls[i]);
+
+  return res;
+}
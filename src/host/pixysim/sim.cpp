@@ -0,0 +1,67 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "pixyvals.h"
+#include "sim.h"
+
+uint32_t g_simClock = 0;
+uint64_t g_simUsecs = 0;
+
+static int mapBank(uint32_t loc, uint32_t size)
+{
+  void *addr;
+
+  addr = mmap((void *)(uintptr_t)loc, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr==MAP_FAILED)
+    return -1;
+  if (addr!=(void *)(uintptr_t)loc)
+  {
+    fprintf(stderr, "sim: unable to map SRAM at 0x%x\n", loc);
+    munmap(addr, size);
+    return -1;
+  }
+  memset(addr, 0, size);
+  return 0;
+}
+
+int sim_mapMemory()
+{
+  // SRAM2, 3 and 4 are back to back
+  if (mapBank(SRAM0_LOC, SRAM0_SIZE)<0 ||
+      mapBank(SRAM1_LOC, SRAM1_SIZE)<0 ||
+      mapBank(SRAM2_LOC, SRAM2_SIZE+SRAM3_SIZE+SRAM4_SIZE)<0)
+    return -1;
+  return 0;
+}
+
+uint64_t sim_usecs()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+}
+
+uint32_t sim_nsecs()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
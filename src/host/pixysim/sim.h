@@ -0,0 +1,63 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Glue shared by the pixy-sim stand-ins.  Nothing here exists on Pixy.
+
+// Maps Pixy's SRAM banks at their LPC4330 addresses.  The firmware passes
+// buffer addresses around as uint32_t (e.g. to the M0), so they have to be
+// low enough to survive the trip.
+int sim_mapMemory();
+
+// host time in microseconds, used for measuring
+uint64_t sim_usecs();
+
+// host time in nanoseconds, wrapping, for the perf probes (cycletimer.h)
+uint32_t sim_nsecs();
+
+// Simulated time in microseconds, what setTimer()/getTimer() see.  It advances
+// by one frame period per camera frame and a little for every timer poll, so
+// the firmware's timeouts expire without the host actually waiting.
+extern uint32_t g_simClock;
+
+// Called when the M4 would otherwise spin waiting on the M0 (empty Qqueue,
+// nothing received on the serial port).  Runs the M0 stand-in.
+void sim_idle();
+
+// Runs the M0 stand-in once, whether or not the M4 is waiting on it, as when the
+// M4 polls a timer.  Returns m0_produce()'s result.
+int sim_runM0();
+
+// Host time spent in the M0 stand-in and the host side of the USB link,
+// subtracted from the M4's frame times.
+extern uint64_t g_simUsecs;
+
+// cprintf() output on/off
+extern bool g_cprintf;
+
+// serial.cpp: copy the serial port's output to file (NULL for none),
+// bytes sent so far
+int ser_simOutput(FILE *file);
+uint64_t ser_simBytes();
+
+// Unwinds back to main() once the frame source is exhausted.
+void sim_exit();
+
+#endif
@@ -0,0 +1,286 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+// socketbench -- chirp over SocketLink on this machine, TCP and a Unix socket.  A
+// device thread streams CCB1 block messages, the way the blobs program does over
+// USB, and the host counts blocks per second as libpixyusb would receive them.
+// Small calls show the round trip.  This is the best a pixyrelay or pixy-sim
+// session can do, less whatever the network in between adds.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include "chirp.hpp"
+#include "socketlink.h"
+#include "sim.h"
+
+#define DEFAULT_CALLS       10000
+#define DEFAULT_MESSAGES    20000
+#define DEFAULT_BLOCKS      20 // per message, a busy frame
+#define DEFAULT_TCP         "127.0.0.1:7599"
+#define DEFAULT_UNIX        "/tmp/socketbench.sock"
+#define BLOCK_WORDS         5 // signature, left, right, top, bottom, as in BlobA
+#define RECV_TIMEOUT        2000 // ms, a message that takes this long isn't coming
+
+static uint32_t bench_echo(const uint32_t &val, Chirp *chirp);
+static uint32_t bench_stream(const uint32_t &messages, const uint32_t &blocks, Chirp *chirp);
+
+static const ProcModule g_module[] =
+{
+  {
+  "echo",
+  (ProcPtr)bench_echo,
+  {CRP_UINT32, END},
+  "Return the argument"
+  "@p value"
+  "@r value"
+  },
+  {
+  "stream",
+  (ProcPtr)bench_stream,
+  {CRP_UINT32, CRP_UINT32, END},
+  "Send block messages once this call has returned"
+  "@p number of messages"
+  "@p blocks per message"
+  "@r 0"
+  },
+  END
+};
+
+// The device side, which answers calls until the host hangs up.
+class BenchServer : public Chirp
+{
+public:
+  BenchServer(Link *link) : Chirp(false, false, link)
+  {
+    registerModule(g_module);
+    m_messages = 0;
+    m_blocks = 0;
+  }
+
+  void run(SocketLink *link)
+  {
+    uint8_t type;
+    ChirpProc proc;
+    void *args[CRP_MAX_ARGS+1];
+    uint32_t i;
+
+    if (link->accept(RECV_TIMEOUT)<0)
+      return;
+    while (link->connected())
+    {
+      if (recvChirp(&type, &proc, args, true)==CRP_RES_OK)
+        handleChirp(type, proc, args);
+      if (m_messages)
+      {
+        std::vector<uint16_t> blocks(m_blocks*BLOCK_WORDS);
+        for (i=0; i<blocks.size(); i++)
+          blocks[i] = i;
+        for (i=0; i<m_messages; i++)
+        {
+          blocks[0] = i; // so the host can tell if it missed one
+          CRP_RETURN(this, HTYPE(FOURCC('C','C','B','1')), HINT8(0), HINT16(320), HINT16(200),
+                     UINTS16(blocks.size(), &blocks[0]));
+        }
+        m_messages = 0;
+      }
+    }
+  }
+
+  uint32_t m_messages;
+  uint32_t m_blocks;
+};
+
+// The host side, counting blocks like PixyInterpreter::interpret_CCB1().
+class BenchClient : public Chirp
+{
+public:
+  BenchClient(Link *link) : Chirp(true, true, link) // interested in hints, CCB1 is one
+  {
+    m_messages = 0;
+    m_blocks = 0;
+    m_missed = 0;
+  }
+
+  // one chirp, block messages go to handleXdata()
+  void receive()
+  {
+    uint8_t type;
+    ChirpProc proc;
+    void *args[CRP_MAX_ARGS+1];
+
+    if (recvChirp(&type, &proc, args, true)==CRP_RES_OK)
+      handleChirp(type, proc, args);
+  }
+
+  virtual void handleXdata(void *data[])
+  {
+    uint16_t *blocks;
+
+    if (data[0]==NULL || data[4]==NULL || data[5]==NULL || *(uint32_t *)data[0]!=FOURCC('C','C','B','1'))
+      return;
+    blocks = (uint16_t *)data[5];
+    if (blocks[0]!=m_messages)
+      m_missed++;
+    m_messages++;
+    m_blocks += *(uint32_t *)data[4]/BLOCK_WORDS;
+  }
+
+  uint32_t m_messages;
+  uint64_t m_blocks;
+  uint32_t m_missed;
+};
+
+static uint32_t bench_echo(const uint32_t &val, Chirp *chirp)
+{
+  return val;
+}
+
+static uint32_t bench_stream(const uint32_t &messages, const uint32_t &blocks, Chirp *chirp)
+{
+  ((BenchServer *)chirp)->m_messages = messages;
+  ((BenchServer *)chirp)->m_blocks = blocks;
+  return 0;
+}
+
+static void run(const char *name, const char *address, uint32_t calls, uint32_t messages, uint32_t blocks)
+{
+  uint32_t i, n, response, failed=0;
+  uint64_t start, begin, t;
+  std::vector<uint32_t> usecs;
+  ChirpProc echo, stream;
+  SocketLink device, host;
+
+  if (device.listen(address)<0)
+  {
+    printf("%s (%s): unable to listen\n", name, address);
+    return;
+  }
+  BenchServer server(&device);
+  boost::thread thread(&BenchServer::run, &server, &device);
+
+  if (host.open(address)<0)
+  {
+    printf("%s (%s): unable to connect\n", name, address);
+    thread.join();
+    return;
+  }
+  BenchClient client(&host);
+  echo = client.getProc("echo");
+  stream = client.getProc("stream");
+  if (!client.connected() || echo<0 || stream<0)
+  {
+    printf("%s (%s): no chirp connection\n", name, address);
+    host.close();
+    thread.join();
+    return;
+  }
+
+  for (i=0, begin=sim_usecs(); i<calls; i++)
+  {
+    start = sim_usecs();
+    if (client.callSync(echo, UINT32(i), END_OUT_ARGS, &response, END_IN_ARGS)<0 || response!=i)
+      failed++;
+    else
+      usecs.push_back(sim_usecs()-start);
+  }
+  t = sim_usecs()-begin;
+  printf("%s (%s):\n", name, address);
+  if ((n=usecs.size()))
+  {
+    std::sort(usecs.begin(), usecs.end());
+    printf("  calls    %8.0f calls/s   latency us: min %u median %u p99 %u max %u   failed %u\n",
+           n*1e6/t, usecs[0], usecs[(n-1)/2], usecs[(n-1)*99/100], usecs[n-1], failed);
+  }
+
+  begin = sim_usecs();
+  if (client.callSync(stream, UINT32(messages), UINT32(blocks), END_OUT_ARGS, &response, END_IN_ARGS)==0)
+  {
+    host.setTimer();
+    while (client.m_messages<messages)
+    {
+      n = client.m_messages;
+      client.receive();
+      if (client.m_messages!=n)
+        host.setTimer();
+      else if (host.getTimer()>RECV_TIMEOUT)
+        break;
+    }
+  }
+  t = sim_usecs()-begin;
+  printf("  blocks   %8.0f blocks/s %8.0f messages/s %8.2f MB/s   received %u of %u messages, %u out of order\n",
+         client.m_blocks*1e6/t, client.m_messages*1e6/t, host.m_recvBytes/(double)t,
+         client.m_messages, messages, client.m_missed);
+  fflush(stdout);
+
+  host.close();
+  thread.join();
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: socketbench [options]\n"
+    "  -n calls     small calls (default %d)\n"
+    "  -m messages  block messages (default %d)\n"
+    "  -b blocks    blocks per message (default %d)\n"
+    "  -t address   TCP address (default %s)\n"
+    "  -u path      Unix socket (default %s)\n",
+    DEFAULT_CALLS, DEFAULT_MESSAGES, DEFAULT_BLOCKS, DEFAULT_TCP, DEFAULT_UNIX);
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  int c;
+  uint32_t calls=DEFAULT_CALLS, messages=DEFAULT_MESSAGES, blocks=DEFAULT_BLOCKS;
+  const char *tcp=DEFAULT_TCP, *path=DEFAULT_UNIX;
+
+  while ((c=getopt(argc, argv, "n:m:b:t:u:"))!=-1)
+  {
+    switch (c)
+    {
+    case 'n':
+      calls = atoi(optarg);
+      break;
+    case 'm':
+      messages = atoi(optarg);
+      break;
+    case 'b':
+      blocks = atoi(optarg);
+      break;
+    case 't':
+      tcp = optarg;
+      break;
+    case 'u':
+      path = optarg;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind<argc || blocks==0)
+    usage();
+
+  run("tcp", tcp, calls, messages, blocks);
+  run("unix", path, calls, messages, blocks);
+  unlink(path);
+
+  return 0;
+}
@@ -0,0 +1,24 @@
+//
+// begin license header
+//
+// This file is part of Pixy CMUcam5 or "Pixy" for short
+//
+// All Pixy source code is provided under the terms of the
+// GNU General Public License v2 (http://www.gnu.org/licenses/gpl-2.0.html).
+// Those wishing to use Pixy source code, software and/or
+// technologies under different licensing terms should contact us at
+// cmucam@cs.cmu.edu. Such licensing terms are available for
+// all portions of the Pixy codebase presented here.
+//
+// end license header
+//
+
+#ifndef _SPI_H
+#define _SPI_H
+
+// Host stand-in for device/libpixy/spi.h.  All serial ports are the in-memory
+// port in serial.cpp.
+
+#include "iserial.h"
+
+#endif